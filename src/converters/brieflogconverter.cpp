@@ -1,10 +1,95 @@
 #include "brieflogconverter.h"
-#include <QDateTime>
+
+namespace {
+
+// Character helpers shared by the QString and the raw UTF-8 byte scanner
+inline char16_t code(QChar c)
+{
+    return c.unicode();
+}
+
+inline char16_t code(char c)
+{
+    return static_cast<uchar>(c);
+}
+
+// ASCII whitespace only, like \s in the regexes, which are compiled without
+// UseUnicodePropertiesOption
+template <typename Char>
+inline bool isSpaceChar(Char c)
+{
+    return code(c) == ' ' || (code(c) >= '\t' && code(c) <= '\r');
+}
+
+template <typename Char>
+inline bool isAsciiDigit(Char c)
+{
+    return code(c) >= '0' && code(c) <= '9';
+}
+
+template <typename Char>
+inline bool isLevelChar(Char c)
+{
+    switch (code(c)) {
+    case 'V': case 'D': case 'I': case 'W': case 'E': case 'A':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Positions of the brief fields within a line, the tag spans [2, paren)
+struct BriefFields {
+    qsizetype paren;
+    qsizetype pidEnd;
+    qsizetype messageStart;
+};
+
+// Single-pass scanner over QChar or UTF-8 bytes, returns false if the line needs the regex
+template <typename Char>
+bool scanFields(const Char *data, qsizetype length, BriefFields &fields)
+{
+    // Shortest possible line is "L/T(P):"
+    if (length < 7 || !isLevelChar(data[0]) || code(data[1]) != '/') {
+        return false;
+    }
+    
+    // The tag is the shortest run (at least one character) followed by "(digits):"
+    for (qsizetype paren = 3; paren < length; ++paren) {
+        if (code(data[paren]) != '(') {
+            continue;
+        }
+        
+        qsizetype pos = paren + 1;
+        while (pos < length && isAsciiDigit(data[pos])) {
+            ++pos;
+        }
+        
+        if (pos > paren + 1 && pos + 1 < length
+            && code(data[pos]) == ')' && code(data[pos + 1]) == ':') {
+            fields.paren = paren;
+            fields.pidEnd = pos;
+            
+            // Message is everything after the colon and its leading whitespace
+            pos += 2;
+            while (pos < length && isSpaceChar(data[pos])) {
+                ++pos;
+            }
+            fields.messageStart = pos;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+} // namespace
 
 BriefLogConverter::BriefLogConverter()
 {
     // Regex pattern for brief format: LEVEL/TAG(PID): message
     // Example: I/MyTag(1234): Log message here
+    // Only used as a fallback for lines the fixed-layout scanner can't classify
     m_regex.setPattern("^([VDIWEA])/(.+?)\\((\\d+)\\):\\s*(.*)$");
 }
 
@@ -12,25 +97,79 @@ LogEntry BriefLogConverter::convert(const QString &line) const
 {
     LogEntry entry;
     
-    QRegularExpressionMatch match = m_regex.match(line);
-    
-    if (match.hasMatch()) {
-        entry.level = match.captured(1);
-        entry.tag = match.captured(2).trimmed();
-        entry.pid = match.captured(3);
-        entry.message = match.captured(4);
+    if (!scan(line, entry)) {
+        QRegularExpressionMatch match = m_regex.match(line);
+        if (!match.hasMatch()) {
+            return entry;
+        }
         
-        // Brief format doesn't have time or TID, generate current date and time
-        QDateTime now = QDateTime::currentDateTime();
-        entry.date = now.toString("yyyy-MM-dd");
-        entry.time = now.toString("hh:mm:ss.zzz");
-        entry.tid = "";
-        entry.package = "";
+        entry.level = LogEntry::levelFromChar(match.capturedView(1).front());
+        entry.setTag(match.captured(2).trimmed());
+        entry.pid = LogEntry::parseId(match.capturedView(3));
+        entry.message = match.captured(4);
+    }
+    
+    // Brief format doesn't have time, TID or package; the timestamp stays NoTimestamp
+    return entry;
+}
+
+LogEntry BriefLogConverter::convertUtf8(QByteArrayView line) const
+{
+    BriefFields fields;
+    
+    // Lines the byte scanner can't classify take the decoded path, including the regex
+    if (line.contains('\n') || !scanFields(line.data(), line.size(), fields)) {
+        return convert(QString::fromUtf8(line));
     }
     
+    const char *data = line.data();
+    LogEntry entry;
+    entry.level = LogEntry::levelFromChar(QLatin1Char(data[0]));
+    entry.setTag(QString::fromUtf8(data + 2, fields.paren - 2).trimmed());
+    entry.pid = LogEntry::parseId(QLatin1StringView(data + fields.paren + 1, fields.pidEnd - fields.paren - 1));
+    entry.message = QString::fromUtf8(data + fields.messageStart, line.size() - fields.messageStart);
+    
     return entry;
 }
 
+bool BriefLogConverter::scanUtf8(QByteArrayView line, LogLevel &level, qint64 &timestamp) const
+{
+    BriefFields fields;
+    if (line.contains('\n') || !scanFields(line.data(), line.size(), fields)) {
+        return ILogConverter::scanUtf8(line, level, timestamp);
+    }
+    
+    // Same fields as convertUtf8() without decoding the tag and message; an empty
+    // message makes the entry invalid
+    level = LogEntry::levelFromChar(QLatin1Char(line.data()[0]));
+    timestamp = LogEntry::NoTimestamp;
+    return fields.messageStart < line.size();
+}
+
+bool BriefLogConverter::scan(const QString &line, LogEntry &entry) const
+{
+    // The regex never matches across a line break, let it decide those lines
+    if (line.contains(QLatin1Char('\n'))) {
+        return false;
+    }
+    
+    BriefFields fields;
+    if (!scanFields(line.constData(), line.size(), fields)) {
+        return false;
+    }
+    
+    entry.level = LogEntry::levelFromChar(line[0]);
+    entry.setTag(line.mid(2, fields.paren - 2).trimmed());
+    entry.pid = LogEntry::parseId(QStringView(line).mid(fields.paren + 1, fields.pidEnd - fields.paren - 1));
+    entry.message = line.mid(fields.messageStart);
+    return true;
+}
+
+LogConverterPtr BriefLogConverter::clone() const
+{
+    return LogConverterPtr(new BriefLogConverter());
+}
+
 QString BriefLogConverter::name() const
 {
     return "Brief";
@@ -8,6 +8,7 @@
  * Converter for Android logcat brief format
  * Format: LEVEL/TAG(PID): message
  * Example: I/MyTag(1234): Log message here
+ * Lines carry no time, so entries have no timestamp
  */
 class BriefLogConverter : public ILogConverter
 {
@@ -16,10 +17,16 @@ public:
     ~BriefLogConverter() override = default;
     
     LogEntry convert(const QString &line) const override;
+    LogEntry convertUtf8(QByteArrayView line) const override;
+    bool scanUtf8(QByteArrayView line, LogLevel &level, qint64 &timestamp) const override;
+    LogConverterPtr clone() const override;
     QString name() const override;
     QString formatDescription() const override;
     
 private:
+    // Single-pass fixed-layout scanner, returns false if the line needs the regex
+    bool scan(const QString &line, LogEntry &entry) const;
+    
     QRegularExpression m_regex;
 };
 
@@ -1,11 +1,157 @@
 #include "threadtimelogconverter.h"
 #include <QDateTime>
 
+namespace {
+
+// Character helpers shared by the QString and the raw UTF-8 byte scanner
+inline char16_t code(QChar c)
+{
+    return c.unicode();
+}
+
+inline char16_t code(char c)
+{
+    return static_cast<uchar>(c);
+}
+
+// ASCII whitespace only, like \s in the regexes, which are compiled without
+// UseUnicodePropertiesOption
+template <typename Char>
+inline bool isSpaceChar(Char c)
+{
+    return code(c) == ' ' || (code(c) >= '\t' && code(c) <= '\r');
+}
+
+template <typename Char>
+inline bool isAsciiDigit(Char c)
+{
+    return code(c) >= '0' && code(c) <= '9';
+}
+
+template <typename Char>
+inline bool isLevelChar(Char c)
+{
+    switch (code(c)) {
+    case 'V': case 'D': case 'I': case 'W': case 'E': case 'A':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Skip a whitespace run starting at pos, returns false if there was none
+template <typename Char>
+inline bool skipSpaces(const Char *data, qsizetype length, qsizetype &pos)
+{
+    const qsizetype start = pos;
+    while (pos < length && isSpaceChar(data[pos])) {
+        ++pos;
+    }
+    return pos > start;
+}
+
+// Skip an ASCII digit run starting at pos, returns false if there was none
+template <typename Char>
+inline bool skipDigits(const Char *data, qsizetype length, qsizetype &pos)
+{
+    const qsizetype start = pos;
+    while (pos < length && isAsciiDigit(data[pos])) {
+        ++pos;
+    }
+    return pos > start;
+}
+
+// Positions of the threadtime fields within a line
+struct ThreadtimeFields {
+    qsizetype pidStart;
+    qsizetype pidEnd;
+    qsizetype tidStart;
+    qsizetype tidEnd;
+    qsizetype levelPos;
+    qsizetype tagStart;
+    qsizetype tagEnd;
+    qsizetype messageStart;
+};
+
+// Single-pass fixed-layout scanner over QChar or UTF-8 bytes, returns false if
+// the line needs the regex
+template <typename Char>
+bool scanFields(const Char *data, qsizetype length, ThreadtimeFields &fields)
+{
+    // Fixed layout: "MM-DD HH:MM:SS.mmm" is 18 characters, followed by at least
+    // " P T L X:" so anything shorter can't be a threadtime line
+    if (length < 27) {
+        return false;
+    }
+    
+    // MM-DD HH:MM:SS.mmm
+    static const char layout[] = "00-00 00:00:00.000";
+    for (qsizetype i = 0; i < 18; ++i) {
+        if (layout[i] == '0') {
+            if (!isAsciiDigit(data[i])) {
+                return false;
+            }
+        } else if (code(data[i]) != static_cast<uchar>(layout[i])) {
+            return false;
+        }
+    }
+    
+    qsizetype pos = 18;
+    
+    // PID
+    if (!skipSpaces(data, length, pos)) {
+        return false;
+    }
+    fields.pidStart = pos;
+    if (!skipDigits(data, length, pos)) {
+        return false;
+    }
+    fields.pidEnd = pos;
+    
+    // TID
+    if (!skipSpaces(data, length, pos)) {
+        return false;
+    }
+    fields.tidStart = pos;
+    if (!skipDigits(data, length, pos)) {
+        return false;
+    }
+    fields.tidEnd = pos;
+    
+    // Level
+    if (!skipSpaces(data, length, pos) || pos >= length || !isLevelChar(data[pos])) {
+        return false;
+    }
+    fields.levelPos = pos++;
+    
+    // Tag runs up to the first colon, surrounding whitespace is trimmed
+    if (!skipSpaces(data, length, pos) || pos >= length || code(data[pos]) == ':') {
+        return false;
+    }
+    fields.tagStart = pos;
+    while (pos < length && code(data[pos]) != ':') {
+        ++pos;
+    }
+    if (pos >= length) {
+        return false;
+    }
+    fields.tagEnd = pos++;
+    
+    // Message is everything after the colon and its leading whitespace
+    skipSpaces(data, length, pos);
+    fields.messageStart = pos;
+    
+    return true;
+}
+
+} // namespace
+
 ThreadtimeLogConverter::ThreadtimeLogConverter()
 {
     // Regex pattern for threadtime format: MM-DD HH:MM:SS.mmm PID TID LEVEL TAG : message
     // Example: 02-10 12:34:23.772  2577  4448 D PowerUI : can't show warning
     // Note: There can be spaces before the colon (e.g., "TAG :" or "TAG:")
+    // Only used as a fallback for lines the fixed-layout scanner can't classify
     m_regex.setPattern("^(\\d{2}-\\d{2})\\s+(\\d{2}:\\d{2}:\\d{2}\\.\\d{3})\\s+(\\d+)\\s+(\\d+)\\s+([VDIWEA])\\s+(.+?)\\s*:\\s*(.*)$");
 }
 
@@ -13,26 +159,111 @@ LogEntry ThreadtimeLogConverter::convert(const QString &line) const
 {
     LogEntry entry;
     
+    if (scan(line, entry)) {
+        return entry;
+    }
+    
     QRegularExpressionMatch match = m_regex.match(line);
     
     if (match.hasMatch()) {
-        QString dateStr = match.captured(1); // MM-DD
-        entry.time = match.captured(2); // HH:MM:SS.mmm
-        entry.pid = match.captured(3);
-        entry.tid = match.captured(4);
-        entry.level = match.captured(5);
-        entry.tag = match.captured(6).trimmed();
+        // MM-DD and HH:MM:SS.mmm, the year comes from the current date
+        entry.timestamp = LogEntry::parseTimestamp(currentYear(), match.capturedView(1),
+                                                   match.capturedView(2));
+        entry.pid = LogEntry::parseId(match.capturedView(3));
+        entry.tid = LogEntry::parseId(match.capturedView(4));
+        entry.level = LogEntry::levelFromChar(match.capturedView(5).front());
+        entry.setTag(match.captured(6).trimmed());
         entry.message = match.captured(7);
-        entry.package = ""; // Not available in threadtime format
-        
-        // Add current year to the date
-        int currentYear = QDateTime::currentDateTime().date().year();
-        entry.date = QString("%1-%2").arg(currentYear).arg(dateStr);
+        // Package is not available in threadtime format
+    }
+    
+    return entry;
+}
+
+LogEntry ThreadtimeLogConverter::convertUtf8(QByteArrayView line) const
+{
+    ThreadtimeFields fields;
+    
+    // Lines the byte scanner can't classify take the decoded path, including the regex
+    if (line.contains('\n') || !scanFields(line.data(), line.size(), fields)) {
+        return convert(QString::fromUtf8(line));
     }
     
+    const char *data = line.data();
+    LogEntry entry;
+    
+    // The layout and the ID fields were checked to be ASCII
+    entry.timestamp = LogEntry::parseTimestamp(currentYear(), QLatin1StringView(data, 5),
+                                               QLatin1StringView(data + 6, 12));
+    entry.pid = LogEntry::parseId(QLatin1StringView(data + fields.pidStart, fields.pidEnd - fields.pidStart));
+    entry.tid = LogEntry::parseId(QLatin1StringView(data + fields.tidStart, fields.tidEnd - fields.tidStart));
+    entry.level = LogEntry::levelFromChar(QLatin1Char(data[fields.levelPos]));
+    entry.setTag(QString::fromUtf8(data + fields.tagStart, fields.tagEnd - fields.tagStart).trimmed());
+    entry.message = QString::fromUtf8(data + fields.messageStart, line.size() - fields.messageStart);
+    // Package is not available in threadtime format
+    
     return entry;
 }
 
+bool ThreadtimeLogConverter::scanUtf8(QByteArrayView line, LogLevel &level, qint64 &timestamp) const
+{
+    ThreadtimeFields fields;
+    if (line.contains('\n') || !scanFields(line.data(), line.size(), fields)) {
+        return ILogConverter::scanUtf8(line, level, timestamp);
+    }
+    
+    // Same fields as convertUtf8() without decoding the tag and message; an empty
+    // message makes the entry invalid
+    const char *data = line.data();
+    timestamp = LogEntry::parseTimestamp(currentYear(), QLatin1StringView(data, 5),
+                                         QLatin1StringView(data + 6, 12));
+    level = LogEntry::levelFromChar(QLatin1Char(data[fields.levelPos]));
+    return fields.messageStart < line.size();
+}
+
+bool ThreadtimeLogConverter::scan(const QString &line, LogEntry &entry) const
+{
+    // The regex never matches across a line break, let it decide those lines
+    if (line.contains(QLatin1Char('\n'))) {
+        return false;
+    }
+    
+    ThreadtimeFields fields;
+    if (!scanFields(line.constData(), line.size(), fields)) {
+        return false;
+    }
+    
+    const QStringView view(line);
+    
+    // MM-DD and HH:MM:SS.mmm, the year comes from the current date
+    entry.timestamp = LogEntry::parseTimestamp(currentYear(), view.left(5), view.mid(6, 12));
+    entry.pid = LogEntry::parseId(view.mid(fields.pidStart, fields.pidEnd - fields.pidStart));
+    entry.tid = LogEntry::parseId(view.mid(fields.tidStart, fields.tidEnd - fields.tidStart));
+    entry.level = LogEntry::levelFromChar(line[fields.levelPos]);
+    entry.setTag(line.mid(fields.tagStart, fields.tagEnd - fields.tagStart).trimmed());
+    entry.message = line.mid(fields.messageStart);
+    // Package is not available in threadtime format
+    
+    return true;
+}
+
+int ThreadtimeLogConverter::currentYear() const
+{
+    // Resolving the local date is far more expensive than scanning a line,
+    // so the year is only refreshed once per second
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now >= m_yearValidUntil.loadAcquire()) {
+        m_cachedYear.storeRelaxed(QDate::currentDate().year());
+        m_yearValidUntil.storeRelease(now + 1000);
+    }
+    return m_cachedYear.loadRelaxed();
+}
+
+LogConverterPtr ThreadtimeLogConverter::clone() const
+{
+    return LogConverterPtr(new ThreadtimeLogConverter());
+}
+
 QString ThreadtimeLogConverter::name() const
 {
     return "Threadtime";
@@ -3,6 +3,7 @@
 
 #include "ilogconverter.h"
 #include <QRegularExpression>
+#include <QAtomicInteger>
 
 /**
  * Converter for Android logcat threadtime format
@@ -16,11 +17,20 @@ public:
     ~ThreadtimeLogConverter() override = default;
     
     LogEntry convert(const QString &line) const override;
+    LogEntry convertUtf8(QByteArrayView line) const override;
+    bool scanUtf8(QByteArrayView line, LogLevel &level, qint64 &timestamp) const override;
+    LogConverterPtr clone() const override;
     QString name() const override;
     QString formatDescription() const override;
     
 private:
+    // Single-pass fixed-layout scanner, returns false if the line needs the regex
+    bool scan(const QString &line, LogEntry &entry) const;
+    int currentYear() const;
+    
     QRegularExpression m_regex;
+    mutable QAtomicInt m_cachedYear;
+    mutable QAtomicInteger<qint64> m_yearValidUntil;
 };
 
 #endif // THREADTIMELOGCONVERTER_H
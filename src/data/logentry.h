@@ -2,19 +2,278 @@
 #define LOGENTRY_H
 
 #include <QString>
+#include <QStringView>
+#include <limits>
+#include "logstringpool.h"
 
+// Ordered from least to most severe so levels can be compared directly
+enum class LogLevel : quint8 {
+    Unknown = 0,
+    Verbose,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Assert
+};
+
+/**
+ * Compact log record
+ * Fields are stored in typed form (timestamp, numeric IDs, level enum, interned
+ * tag/package) and only formatted as text by the accessors below when displayed
+ */
 struct LogEntry {
-    QString date;
-    QString time;
-    QString pid;
-    QString tid;
-    QString package;
-    QString level;
-    QString tag;
-    QString message;
+    static constexpr qint64 NoTimestamp = std::numeric_limits<qint64>::min();
+    static constexpr qint32 NoId = -1;
+    static constexpr qint64 MSECS_PER_DAY = 86400000;
+    
+    qint64 timestamp = NoTimestamp; // Wall clock as logged, see makeTimestamp() (no time zone)
+    QString message;                // Implicitly shared with any copies of the entry
+    qint32 pid = NoId;
+    qint32 tid = NoId;
+    quint32 tagId = 0;              // LogStringPool ID
+    quint32 packageId = 0;          // LogStringPool ID
+    quint32 sourceId = 0;           // LogStringPool ID of the file name when files are merged
+    LogLevel level = LogLevel::Unknown;
     
     bool isValid() const {
-        return !level.isEmpty() && !message.isEmpty();
+        return level != LogLevel::Unknown && !message.isEmpty();
+    }
+    
+    // Text accessors used for display, filtering and saving
+    
+    QString date() const {
+        const int y = year();
+        if (timestamp == NoTimestamp || y < 0 || y > 9999) {
+            return QString();
+        }
+        const int m = month();
+        const int d = day();
+        const QChar text[10] = {
+            QChar('0' + y / 1000), QChar('0' + (y / 100) % 10), QChar('0' + (y / 10) % 10),
+            QChar('0' + y % 10), QChar('-'), QChar('0' + m / 10), QChar('0' + m % 10),
+            QChar('-'), QChar('0' + d / 10), QChar('0' + d % 10)
+        };
+        return QString(text, 10);
+    }
+    
+    QString time() const {
+        const int msecs = msecsOfDay();
+        if (msecs < 0) {
+            return QString();
+        }
+        const int hours = msecs / 3600000;
+        const int minutes = (msecs / 60000) % 60;
+        const int seconds = (msecs / 1000) % 60;
+        const int millis = msecs % 1000;
+        const QChar text[12] = {
+            QChar('0' + hours / 10), QChar('0' + hours % 10), QChar(':'),
+            QChar('0' + minutes / 10), QChar('0' + minutes % 10), QChar(':'),
+            QChar('0' + seconds / 10), QChar('0' + seconds % 10), QChar('.'),
+            QChar('0' + millis / 100), QChar('0' + (millis / 10) % 10), QChar('0' + millis % 10)
+        };
+        return QString(text, 12);
+    }
+    
+    QString pidText() const {
+        return pid == NoId ? QString() : QString::number(pid);
+    }
+    
+    QString tidText() const {
+        return tid == NoId ? QString() : QString::number(tid);
+    }
+    
+    QString levelText() const {
+        const QChar c = levelChar(level);
+        return c.isNull() ? QString() : QString(c);
+    }
+    
+    QString tag() const {
+        return tagId == 0 ? QString() : LogStringPool::instance().at(tagId);
+    }
+    
+    QString package() const {
+        return packageId == 0 ? QString() : LogStringPool::instance().at(packageId);
+    }
+    
+    QString source() const {
+        return sourceId == 0 ? QString() : LogStringPool::instance().at(sourceId);
+    }
+    
+    void setTag(const QString &text) {
+        tagId = LogStringPool::instance().intern(text);
+    }
+    
+    void setPackage(const QString &text) {
+        packageId = LogStringPool::instance().intern(text);
+    }
+    
+    /**
+     * Date fields of the timestamp, 0 if the entry has no timestamp
+     * The day may be 02-29 in a year that has no such day, as logged
+     */
+    int year() const {
+        return timestamp == NoTimestamp ? 0 : EPOCH_YEAR + floorDiv(dayNumber(), DAYS_PER_YEAR);
+    }
+    
+    int month() const {
+        return timestamp == NoTimestamp ? 0 : dayOfYear() / DAYS_PER_MONTH + 1;
+    }
+    
+    int day() const {
+        return timestamp == NoTimestamp ? 0 : dayOfYear() % DAYS_PER_MONTH + 1;
+    }
+    
+    /**
+     * Milliseconds since midnight, or -1 if the entry has no timestamp
+     */
+    int msecsOfDay() const {
+        if (timestamp == NoTimestamp) {
+            return -1;
+        }
+        return static_cast<int>(timestamp - dayNumber() * MSECS_PER_DAY);
+    }
+    
+    // Conversion helpers shared by the converters
+    
+    static LogLevel levelFromChar(QChar c) {
+        switch (c.unicode()) {
+        case 'V': return LogLevel::Verbose;
+        case 'D': return LogLevel::Debug;
+        case 'I': return LogLevel::Info;
+        case 'W': return LogLevel::Warn;
+        case 'E': return LogLevel::Error;
+        case 'A': return LogLevel::Assert;
+        default:  return LogLevel::Unknown;
+        }
+    }
+    
+    static QChar levelChar(LogLevel level) {
+        switch (level) {
+        case LogLevel::Verbose: return QChar('V');
+        case LogLevel::Debug:   return QChar('D');
+        case LogLevel::Info:    return QChar('I');
+        case LogLevel::Warn:    return QChar('W');
+        case LogLevel::Error:   return QChar('E');
+        case LogLevel::Assert:  return QChar('A');
+        default:                return QChar();
+        }
+    }
+    
+    /**
+     * Build a timestamp from calendar fields
+     * Days are counted from 1970-01-01 with 31 for every month, so timestamps order
+     * like the fields and any day a month can have, including 02-29 of a year that
+     * is not a leap year, keeps the given year. Differences between timestamps are
+     * not durations.
+     * @return Timestamp, or NoTimestamp if the fields don't form a valid date/time
+     */
+    static qint64 makeTimestamp(int year, int month, int day, int msecs) {
+        if (month < 1 || month > 12 || day < 1 || day > MONTH_DAYS[month - 1]
+            || msecs < 0 || msecs >= MSECS_PER_DAY) {
+            return NoTimestamp;
+        }
+        const qint64 days = qint64(year - EPOCH_YEAR) * DAYS_PER_YEAR
+                            + (month - 1) * DAYS_PER_MONTH + day - 1;
+        return days * MSECS_PER_DAY + msecs;
+    }
+    
+    /**
+     * Parse a logcat "MM-DD" and "HH:MM:SS.mmm" pair into a timestamp for the given year
+     * Every line of a stream keeps the given year, 02-29 included
+     * @return Timestamp, or NoTimestamp if either part is malformed
+     */
+    static qint64 parseTimestamp(int year, QStringView monthDay, QStringView clock) {
+        return parseTimestampText(year, monthDay, clock);
+    }
+    
+    // Same for raw (ASCII) bytes, e.g. a line in a memory-mapped file
+    static qint64 parseTimestamp(int year, QLatin1StringView monthDay, QLatin1StringView clock) {
+        return parseTimestampText(year, monthDay, clock);
+    }
+    
+    /**
+     * Parse a decimal PID/TID
+     * @return The ID, or NoId if the text is empty, not numeric or out of range
+     */
+    static qint32 parseId(QStringView digits) {
+        return parseIdText(digits);
+    }
+    
+    static qint32 parseId(QLatin1StringView digits) {
+        return parseIdText(digits);
+    }
+
+private:
+    static constexpr int EPOCH_YEAR = 1970;
+    static constexpr int DAYS_PER_MONTH = 31;
+    static constexpr int DAYS_PER_YEAR = 12 * DAYS_PER_MONTH;
+    static constexpr int MONTH_DAYS[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    
+    // Floor division so times before 1970 still land on the right day
+    static qint64 floorDiv(qint64 value, qint64 divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+    
+    qint64 dayNumber() const {
+        return floorDiv(timestamp, MSECS_PER_DAY);
+    }
+    
+    int dayOfYear() const {
+        return static_cast<int>(dayNumber() - floorDiv(dayNumber(), DAYS_PER_YEAR) * DAYS_PER_YEAR);
+    }
+    
+    static int digitValue(QChar c) {
+        return c.digitValue();
+    }
+    
+    static int digitValue(QLatin1Char c) {
+        const char ch = c.toLatin1();
+        return (ch >= '0' && ch <= '9') ? ch - '0' : -1;
+    }
+    
+    template <typename View>
+    static int twoDigits(View text, qsizetype pos) {
+        const int high = digitValue(text[pos]);
+        const int low = digitValue(text[pos + 1]);
+        return (high < 0 || low < 0) ? -1 : high * 10 + low;
+    }
+    
+    template <typename View>
+    static qint64 parseTimestampText(int year, View monthDay, View clock) {
+        if (monthDay.size() != 5 || clock.size() != 12) {
+            return NoTimestamp;
+        }
+        const int month = twoDigits(monthDay, 0);
+        const int day = twoDigits(monthDay, 3);
+        const int hours = twoDigits(clock, 0);
+        const int minutes = twoDigits(clock, 3);
+        const int seconds = twoDigits(clock, 6);
+        const int millis = twoDigits(clock, 9) * 10 + digitValue(clock[11]);
+        if (month < 0 || day < 0 || hours < 0 || hours > 23 || minutes < 0 || minutes > 59
+            || seconds < 0 || seconds > 59 || millis < 0 || digitValue(clock[11]) < 0) {
+            return NoTimestamp;
+        }
+        // Logcat omits the year; the caller's year holds for the whole stream, so a
+        // 02-29 line from an earlier leap year stays between its neighbours
+        return makeTimestamp(year, month, day,
+                             ((hours * 60 + minutes) * 60 + seconds) * 1000 + millis);
+    }
+    
+    template <typename View>
+    static qint32 parseIdText(View digits) {
+        if (digits.isEmpty() || digits.size() > 10) {
+            return NoId;
+        }
+        qint64 value = 0;
+        for (qsizetype i = 0; i < digits.size(); ++i) {
+            const int digit = digitValue(digits[i]);
+            if (digit < 0) {
+                return NoId;
+            }
+            value = value * 10 + digit;
+        }
+        return value > std::numeric_limits<qint32>::max() ? NoId : static_cast<qint32>(value);
     }
 };
 
@@ -0,0 +1,199 @@
+#include "logfileindex.h"
+#include <QFileInfo>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
+
+namespace {
+
+// Parsed entries kept for scrolling back and forth, a few screens' worth
+const int CACHED_ENTRIES = 4096;
+
+// Lines parsed by one task of parseLines()
+const qsizetype PARSE_CHUNK_SIZE = 8192;
+
+} // namespace
+
+LogFileIndex::LogFileIndex()
+    : m_mapped(nullptr)
+    , m_data(nullptr)
+    , m_length(0)
+    , m_cache(CACHED_ENTRIES)
+{}
+
+LogFileIndex::~LogFileIndex()
+{
+    close();
+}
+
+bool LogFileIndex::open(const QString &filePath, QString &errorMsg)
+{
+    close();
+    
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists()) {
+        errorMsg = QString("File does not exist: %1").arg(filePath);
+        return false;
+    }
+    
+    if (!fileInfo.isFile()) {
+        errorMsg = QString("Path is not a file: %1").arg(filePath);
+        return false;
+    }
+    
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        errorMsg = QString("Failed to open file: %1").arg(m_file.errorString());
+        return false;
+    }
+    
+    // The mapping backs every entry parsed later, so it stays until close()
+    m_length = m_file.size();
+    m_mapped = m_length > 0 ? m_file.map(0, m_length) : nullptr;
+    if (m_mapped) {
+        m_data = reinterpret_cast<const char *>(m_mapped);
+    } else {
+        m_contents = m_file.readAll();
+        m_data = m_contents.constData();
+        m_length = m_contents.size();
+    }
+    
+    errorMsg.clear();
+    return true;
+}
+
+void LogFileIndex::close()
+{
+    m_cache.clear();
+    m_offsets.clear();
+    m_timestamps.clear();
+    m_levels.clear();
+    m_converterIds.clear();
+    
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+        m_mapped = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_contents.clear();
+    m_data = nullptr;
+    m_length = 0;
+}
+
+QString LogFileIndex::filePath() const
+{
+    return m_file.fileName();
+}
+
+void LogFileIndex::setConverters(const QVector<LogConverterPtr> &converters)
+{
+    m_converters = converters;
+    m_cache.clear();
+}
+
+QVector<LogConverterPtr> LogFileIndex::cloneConverters() const
+{
+    QVector<LogConverterPtr> clones;
+    clones.reserve(m_converters.size());
+    for (const LogConverterPtr &converter : m_converters) {
+        clones.append(converter->clone());
+    }
+    return clones;
+}
+
+void LogFileIndex::appendLines(const QVector<LineInfo> &lines)
+{
+    for (const LineInfo &line : lines) {
+        m_offsets.append(line.offset);
+        m_timestamps.append(line.timestamp);
+        m_levels.append(line.level);
+        m_converterIds.append(line.converter);
+    }
+}
+
+void LogFileIndex::setLines(QVector<qint64> offsets, QVector<qint64> timestamps,
+                            QVector<LogLevel> levels, QVector<quint8> converterIds)
+{
+    m_cache.clear();
+    m_offsets = std::move(offsets);
+    m_timestamps = std::move(timestamps);
+    m_levels = std::move(levels);
+    m_converterIds = std::move(converterIds);
+}
+
+LogEntry LogFileIndex::entry(quint32 sequence) const
+{
+    if (const LogEntry *cached = m_cache.object(sequence)) {
+        return *cached;
+    }
+    
+    // The cache evicts the least recently used entry once it is full
+    LogEntry parsed = parseLine(sequence, m_converters);
+    m_cache.insert(sequence, new LogEntry(parsed));
+    return parsed;
+}
+
+LogEntry LogFileIndex::parseLine(qsizetype index, const QVector<LogConverterPtr> &converters) const
+{
+    LogEntry entry = converters[m_converterIds[index]]->convertUtf8(lineAt(index));
+    
+    // Keep the timestamp from indexing so the entry doesn't change when it is parsed again
+    entry.timestamp = m_timestamps[index];
+    return entry;
+}
+
+LogEntry LogFileIndex::metadataAt(qsizetype index) const
+{
+    LogEntry entry;
+    entry.timestamp = m_timestamps[index];
+    entry.level = m_levels[index];
+    return entry;
+}
+
+qint64 LogFileIndex::byteSize() const
+{
+    return m_offsets.size() * static_cast<qint64>(sizeof(qint64) * 2 + sizeof(LogLevel) + sizeof(quint8));
+}
+
+QVector<LogEntry> LogFileIndex::parseLines(qsizetype first, qsizetype count) const
+{
+    QVector<LogEntry> entries(count);
+    LogEntry *parsed = entries.data();
+    
+    // Every task parses its own part of the range with its own converters
+    QVector<qsizetype> chunkStarts;
+    for (qsizetype start = 0; start < count; start += PARSE_CHUNK_SIZE) {
+        chunkStarts.append(start);
+    }
+    auto parseChunk = [this, first, count, parsed](qsizetype start) {
+        const QVector<LogConverterPtr> converters = cloneConverters();
+        const qsizetype end = qMin(start + PARSE_CHUNK_SIZE, count);
+        for (qsizetype i = start; i < end; ++i) {
+            parsed[i] = parseLine(first + i, converters);
+        }
+    };
+    if (chunkStarts.size() > 1 && QThread::idealThreadCount() > 1) {
+        QtConcurrent::blockingMap(chunkStarts, parseChunk);
+    } else {
+        for (qsizetype start : std::as_const(chunkStarts)) {
+            parseChunk(start);
+        }
+    }
+    return entries;
+}
+
+QByteArrayView LogFileIndex::lineAt(qsizetype index) const
+{
+    const qint64 offset = m_offsets[index];
+    const char *lineStart = m_data + offset;
+    const char *lineEnd = static_cast<const char *>(std::memchr(lineStart, '\n', m_length - offset));
+    qint64 lineLength = lineEnd ? lineEnd - lineStart : m_length - offset;
+    
+    // Drop the CR of CRLF line endings
+    if (lineLength > 0 && lineStart[lineLength - 1] == '\r') {
+        lineLength--;
+    }
+    return QByteArrayView(lineStart, lineLength);
+}
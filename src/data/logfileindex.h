@@ -0,0 +1,131 @@
+#ifndef LOGFILEINDEX_H
+#define LOGFILEINDEX_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QCache>
+#include "ilogsource.h"
+#include "ilogconverter.h"
+
+/**
+ * Log file opened without building its entries
+ * The file stays memory mapped; only the offset, level and timestamp of every
+ * log line are kept, and full entries are parsed when they are requested, with
+ * the most recently used ones cached. Memory grows with the number of lines,
+ * not with the size of the text. The sequence number of an entry is its line
+ * index, so files are limited to 2^32 log lines
+ */
+class LogFileIndex final : public ILogSource
+{
+public:
+    // Indexed log line as found by a converter's scanUtf8()
+    struct LineInfo {
+        qint64 offset;
+        qint64 timestamp;
+        LogLevel level;
+        quint8 converter; // Index into converters()
+    };
+    
+    LogFileIndex();
+    ~LogFileIndex() override;
+    
+    // Delete copy constructor and assignment operator
+    LogFileIndex(const LogFileIndex&) = delete;
+    LogFileIndex& operator=(const LogFileIndex&) = delete;
+    
+    /**
+     * Map a file, dropping the lines of any previously opened file
+     * @param filePath Path to the log file
+     * @param errorMsg Output parameter for error messages
+     * @return true if the file contents are available through data()
+     */
+    bool open(const QString &filePath, QString &errorMsg);
+    void close();
+    
+    QString filePath() const;
+    const char *data() const { return m_data; }
+    qint64 length() const { return m_length; }
+    
+    /**
+     * Set the converters that parse the indexed lines on demand
+     * @param converters Converters in the order referenced by LineInfo::converter
+     */
+    void setConverters(const QVector<LogConverterPtr> &converters);
+    
+    // Independent copies of the converters, for parsing on another thread
+    QVector<LogConverterPtr> cloneConverters() const;
+    
+    // Add lines in file order
+    void appendLines(const QVector<LineInfo> &lines);
+    
+    /**
+     * Replace the lines with previously indexed columns, e.g. from a cache
+     * @param offsets Start of each line in the file
+     * @param timestamps Timestamp of each line
+     * @param levels Level of each line
+     * @param converterIds Converter of each line, an index into the converters
+     */
+    void setLines(QVector<qint64> offsets, QVector<qint64> timestamps,
+                  QVector<LogLevel> levels, QVector<quint8> converterIds);
+    
+    // Indexed columns, one element per log line
+    const QVector<qint64>& offsets() const { return m_offsets; }
+    const QVector<qint64>& timestamps() const { return m_timestamps; }
+    const QVector<LogLevel>& levels() const { return m_levels; }
+    const QVector<quint8>& converterIds() const { return m_converterIds; }
+    QVector<LogConverterPtr> converters() const { return m_converters; }
+    
+    qsizetype size() const override { return m_offsets.size(); }
+    quint32 offsetOf(quint32 sequence) const override { return sequence; }
+    bool contains(quint32 sequence) const override { return sequence < static_cast<quint32>(size()); }
+    
+    // Parsed entry, served from the cache of recently used entries
+    LogEntry entry(quint32 sequence) const override;
+    
+    /**
+     * Parse a line without using the cache
+     * Safe to call from several threads as long as each passes its own converters
+     * @param index Line index
+     * @param converters Converters from cloneConverters()
+     * @return Parsed entry with the indexed timestamp
+     */
+    LogEntry parseLine(qsizetype index, const QVector<LogConverterPtr> &converters) const;
+    
+    // Entry with only the indexed level and timestamp set
+    LogEntry metadataAt(qsizetype index) const;
+    
+    // Approximate memory used by the index, the mapped file is not counted
+    qint64 byteSize() const;
+    
+    /**
+     * Parse a range of lines without using the cache, in parallel for large ranges
+     * Safe to call from a worker thread while the GUI thread reads entries
+     * @param first Index of the first line
+     * @param count Number of lines
+     * @return Parsed entries in file order
+     */
+    QVector<LogEntry> parseLines(qsizetype first, qsizetype count) const;
+
+private:
+    QByteArrayView lineAt(qsizetype index) const;
+    
+    QFile m_file;
+    uchar *m_mapped;
+    QByteArray m_contents;         // Files that can't be mapped are read into memory
+    const char *m_data;
+    qint64 m_length;
+    
+    // One element per log line
+    QVector<qint64> m_offsets;
+    QVector<qint64> m_timestamps;
+    QVector<LogLevel> m_levels;
+    QVector<quint8> m_converterIds;
+    
+    QVector<LogConverterPtr> m_converters;
+    mutable QCache<quint32, LogEntry> m_cache;
+};
+
+#endif // LOGFILEINDEX_H
@@ -0,0 +1,99 @@
+#include "logstore.h"
+
+namespace {
+
+const qsizetype INITIAL_RING_SIZE = 1024;
+
+} // namespace
+
+qsizetype LogStore::setCapacity(qsizetype maxEntries, qint64 maxBytes)
+{
+    m_maxEntries = qMax<qsizetype>(0, maxEntries);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    return enforceLimits();
+}
+
+qsizetype LogStore::append(const LogEntry &entry)
+{
+    // Make room first so the ring never needs more slots than the entry limit
+    qsizetype evicted = 0;
+    if (m_maxEntries > 0 && m_size >= m_maxEntries) {
+        evictOldest();
+        ++evicted;
+    }
+    if (m_size == m_ring.size()) {
+        grow();
+    }
+    
+    m_ring[(m_head + m_size) & (m_ring.size() - 1)] = entry;
+    ++m_size;
+    m_bytes += entryBytes(entry);
+    
+    return evicted + enforceLimits();
+}
+
+void LogStore::assign(const QVector<LogEntry> &entries)
+{
+    clear();
+    for (const LogEntry &entry : entries) {
+        append(entry);
+    }
+}
+
+void LogStore::clear()
+{
+    // Keep numbering after a clear so stale sequence numbers never match new entries
+    m_firstSequence += static_cast<quint32>(m_size);
+    m_ring.clear();
+    m_head = 0;
+    m_size = 0;
+    m_bytes = 0;
+}
+
+QVector<LogEntry> LogStore::toVector() const
+{
+    QVector<LogEntry> entries;
+    entries.reserve(m_size);
+    for (qsizetype i = 0; i < m_size; ++i) {
+        entries.append(at(i));
+    }
+    return entries;
+}
+
+qint64 LogStore::entryBytes(const LogEntry &entry)
+{
+    return static_cast<qint64>(sizeof(LogEntry)) + entry.message.size() * static_cast<qint64>(sizeof(QChar));
+}
+
+void LogStore::grow()
+{
+    // Unroll the ring into a larger one, oldest entry first
+    QVector<LogEntry> ring(m_ring.isEmpty() ? INITIAL_RING_SIZE : m_ring.size() * 2);
+    for (qsizetype i = 0; i < m_size; ++i) {
+        ring[i] = std::move(m_ring[(m_head + i) & (m_ring.size() - 1)]);
+    }
+    m_ring.swap(ring);
+    m_head = 0;
+}
+
+void LogStore::evictOldest()
+{
+    LogEntry &oldest = m_ring[m_head];
+    m_bytes -= entryBytes(oldest);
+    oldest = LogEntry(); // Release the message now rather than when the slot is reused
+    m_head = (m_head + 1) & (m_ring.size() - 1);
+    --m_size;
+    ++m_firstSequence;
+}
+
+qsizetype LogStore::enforceLimits()
+{
+    qsizetype evicted = 0;
+    // Always keep the newest entry, even if it alone exceeds the byte limit
+    while (m_size > 1 && ((m_maxEntries > 0 && m_size > m_maxEntries)
+                          || (m_maxBytes > 0 && m_bytes > m_maxBytes))) {
+        evictOldest();
+        ++evicted;
+    }
+    return evicted;
+}
@@ -0,0 +1,81 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QVector>
+#include "logentry.h"
+#include "ilogsource.h"
+
+/**
+ * Owning store for all captured log entries
+ * Entries live in a power-of-two ring so the oldest ones can be dropped in O(1)
+ * once a capacity limit is set. Every entry gets a 32-bit sequence number that
+ * stays valid while the entry is stored; sequence numbers wrap, so compare them
+ * through offsetOf() rather than directly
+ */
+class LogStore final : public ILogSource
+{
+public:
+    LogStore() = default;
+    
+    /**
+     * Limit the store size, the oldest entries are evicted when either limit is exceeded
+     * @param maxEntries Maximum number of entries, 0 for no limit
+     * @param maxBytes Approximate maximum memory for the entries, 0 for no limit
+     * @return Number of entries evicted to satisfy the new limits
+     */
+    qsizetype setCapacity(qsizetype maxEntries, qint64 maxBytes);
+    
+    /**
+     * Append an entry, evicting the oldest entries if a limit is exceeded
+     * @param entry Entry to store
+     * @return Number of entries evicted from the head
+     */
+    qsizetype append(const LogEntry &entry);
+    
+    // Replace the contents, keeping only the newest entries that fit the limits
+    void assign(const QVector<LogEntry> &entries);
+    void clear();
+    
+    qsizetype size() const override { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    qint64 byteSize() const { return m_bytes; }
+    
+    // Entry by position, 0 is the oldest stored entry
+    const LogEntry& at(qsizetype index) const {
+        return m_ring[(m_head + index) & (m_ring.size() - 1)];
+    }
+    
+    // Sequence number of the oldest stored entry
+    quint32 firstSequence() const { return m_firstSequence; }
+    quint32 sequenceAt(qsizetype index) const {
+        return m_firstSequence + static_cast<quint32>(index);
+    }
+    
+    /**
+     * Position of a sequence number relative to the oldest stored entry
+     * @return Offset, >= size() if the entry was evicted or not stored yet
+     */
+    quint32 offsetOf(quint32 sequence) const override { return sequence - m_firstSequence; }
+    bool contains(quint32 sequence) const override { return offsetOf(sequence) < static_cast<quint32>(m_size); }
+    const LogEntry& bySequence(quint32 sequence) const { return at(offsetOf(sequence)); }
+    LogEntry entry(quint32 sequence) const override { return bySequence(sequence); }
+    
+    // Copy of the stored entries, oldest first (messages are implicitly shared)
+    QVector<LogEntry> toVector() const;
+
+private:
+    static qint64 entryBytes(const LogEntry &entry);
+    void grow();
+    void evictOldest();
+    qsizetype enforceLimits();
+    
+    QVector<LogEntry> m_ring;     // Size is zero or a power of two
+    qsizetype m_head = 0;         // Ring slot of the oldest entry
+    qsizetype m_size = 0;
+    qint64 m_bytes = 0;
+    quint32 m_firstSequence = 0;
+    qsizetype m_maxEntries = 0;
+    qint64 m_maxBytes = 0;
+};
+
+#endif // LOGSTORE_H
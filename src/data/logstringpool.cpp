@@ -0,0 +1,64 @@
+#include "logstringpool.h"
+
+LogStringPool::LogStringPool()
+{
+    // Reserve ID 0 for the empty string so default-constructed entries need no lookup
+    m_strings.append(QString());
+    m_ids.insert(QString(), 0);
+}
+
+LogStringPool& LogStringPool::instance()
+{
+    static LogStringPool instance;
+    return instance;
+}
+
+quint32 LogStringPool::intern(const QString &text)
+{
+    if (text.isEmpty()) {
+        return 0;
+    }
+    
+    // Almost every lookup hits an existing tag, so try under the shared lock first
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_ids.constFind(text);
+        if (it != m_ids.constEnd()) {
+            return it.value();
+        }
+    }
+    
+    QWriteLocker locker(&m_lock);
+    
+    // Another thread may have added it while we waited for the write lock
+    auto it = m_ids.constFind(text);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+    
+    const quint32 id = static_cast<quint32>(m_strings.size());
+    m_strings.append(text);
+    m_ids.insert(text, id);
+    return id;
+}
+
+QString LogStringPool::at(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    if (id < static_cast<quint32>(m_strings.size())) {
+        return m_strings.at(id);
+    }
+    return QString();
+}
+
+quint32 LogStringPool::size() const
+{
+    QReadLocker locker(&m_lock);
+    return static_cast<quint32>(m_strings.size());
+}
+
+QStringList LogStringPool::strings() const
+{
+    QReadLocker locker(&m_lock);
+    return m_strings;
+}
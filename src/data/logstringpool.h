@@ -0,0 +1,59 @@
+#ifndef LOGSTRINGPOOL_H
+#define LOGSTRINGPOOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QReadWriteLock>
+
+/**
+ * Process-wide intern table for low-cardinality log fields (tags, packages)
+ * Each distinct string is stored once and referenced by a 32-bit ID
+ * ID 0 is always the empty string. Safe to use from any thread
+ */
+class LogStringPool
+{
+public:
+    static LogStringPool& instance();
+    
+    // Delete copy constructor and assignment operator
+    LogStringPool(const LogStringPool&) = delete;
+    LogStringPool& operator=(const LogStringPool&) = delete;
+    
+    /**
+     * Get the ID for a string, adding it to the pool if needed
+     * @param text String to intern
+     * @return Stable ID for the string
+     */
+    quint32 intern(const QString &text);
+    
+    /**
+     * Get the string for an ID
+     * @param id ID returned by intern()
+     * @return The interned string, empty if the ID is unknown
+     */
+    QString at(quint32 id) const;
+    
+    /**
+     * Get the number of interned strings (IDs are 0 .. size()-1)
+     * @return Pool size
+     */
+    quint32 size() const;
+    
+    /**
+     * Get a snapshot of all interned strings, indexed by ID
+     * @return Copy of the table (implicitly shared strings)
+     */
+    QStringList strings() const;
+
+private:
+    LogStringPool();
+    ~LogStringPool() = default;
+    
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_ids;
+    QVector<QString> m_strings;
+};
+
+#endif // LOGSTRINGPOOL_H
@@ -0,0 +1,77 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicPointer>
+#include <utility>
+
+/**
+ * Unbounded lock-free queue for exactly one producer thread and one consumer thread
+ * The producer only touches the tail and the consumer only the head, so neither
+ * side ever blocks the other. Intended for batches, not single items, since every
+ * push allocates a node
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    SpscQueue()
+        : m_head(new Node)
+        , m_tail(m_head)
+    {}
+    
+    ~SpscQueue()
+    {
+        while (m_head) {
+            Node *next = m_head->next.loadRelaxed();
+            delete m_head;
+            m_head = next;
+        }
+    }
+    
+    // Delete copy constructor and assignment operator
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    
+    /**
+     * Append a value, producer thread only
+     * @param value Value to move into the queue
+     */
+    void push(T value)
+    {
+        Node *node = new Node;
+        node->value = std::move(value);
+        // Publish the node only after its value is written
+        m_tail->next.storeRelease(node);
+        m_tail = node;
+    }
+    
+    /**
+     * Take the oldest value, consumer thread only
+     * @param value Receives the value if one was available
+     * @return True if a value was taken
+     */
+    bool pop(T &value)
+    {
+        Node *next = m_head->next.loadAcquire();
+        if (!next) {
+            return false;
+        }
+        // The popped node becomes the new empty head
+        value = std::move(next->value);
+        next->value = T();
+        delete m_head;
+        m_head = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        T value;
+        QAtomicPointer<Node> next;
+    };
+    
+    Node *m_head; // Consumer side, always an already consumed (or dummy) node
+    Node *m_tail; // Producer side, the last pushed node
+};
+
+#endif // SPSCQUEUE_H
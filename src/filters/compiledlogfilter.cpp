@@ -0,0 +1,366 @@
+#include "compiledlogfilter.h"
+#include "logstringpool.h"
+#include "logfileindex.h"
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace {
+
+// Below this many entries a parallel scan costs more than it saves
+const qsizetype PARALLEL_THRESHOLD = 50000;
+const qsizetype MIN_CHUNK_SIZE = 16384;
+
+struct FilterChunk {
+    qsizetype begin;
+    qsizetype end;
+    QVector<quint32> matches;
+};
+
+// Run scan over [0, count) in chunks, in parallel for large counts, and join the
+// matches in order so the result is the same as a serial scan
+template <typename Scan>
+QVector<quint32> scanChunks(qsizetype count, Scan scan)
+{
+    const int threadCount = QThread::idealThreadCount();
+    
+    if (count < PARALLEL_THRESHOLD || threadCount <= 1) {
+        FilterChunk chunk{0, count, QVector<quint32>()};
+        scan(chunk);
+        return chunk.matches;
+    }
+    
+    // Several chunks per thread so idle threads pick up the remaining work when
+    // matches cluster in one part of the log
+    const qsizetype chunkCount = qMin<qsizetype>(threadCount * 4,
+                                                 (count + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+    const qsizetype chunkSize = (count + chunkCount - 1) / chunkCount;
+    
+    QVector<FilterChunk> chunks;
+    chunks.reserve(chunkCount);
+    for (qsizetype begin = 0; begin < count; begin += chunkSize) {
+        chunks.append({begin, qMin(begin + chunkSize, count), QVector<quint32>()});
+    }
+    
+    // Each chunk collects its own matches, filter state is read-only here
+    QtConcurrent::blockingMap(chunks, scan);
+    
+    // Concatenate in chunk order so the result matches a serial scan
+    qsizetype total = 0;
+    for (const FilterChunk &chunk : chunks) {
+        total += chunk.matches.size();
+    }
+    
+    QVector<quint32> result;
+    result.reserve(total);
+    for (const FilterChunk &chunk : chunks) {
+        result.append(chunk.matches);
+    }
+    return result;
+}
+
+// Layout of LogEntry::time(), '0' marks a digit position
+const char TIME_LAYOUT[] = "00:00:00.000";
+const int TIME_LENGTH = 12;
+
+// Time of day as the decimal number HHMMSSmmm, which orders like the time text
+qint64 timeKey(int msecs)
+{
+    const qint64 hours = msecs / 3600000;
+    const qint64 minutes = (msecs / 60000) % 60;
+    const qint64 seconds = (msecs / 1000) % 60;
+    return ((hours * 100 + minutes) * 100 + seconds) * 1000 + msecs % 1000;
+}
+
+} // namespace
+
+CompiledLogFilter::CompiledLogFilter(const FilterCriteria &criteria)
+{
+    if (!criteria.messageFilter.isEmpty()) {
+        m_message = compileText(criteria.messageFilter, criteria.messageOperator);
+    }
+    if (!criteria.startTime.isEmpty()) {
+        m_startTime = compileTime(criteria.startTime);
+    }
+    if (!criteria.endTime.isEmpty()) {
+        m_endTime = compileTime(criteria.endTime);
+    }
+    if (!criteria.tagFilter.isEmpty()) {
+        m_tag = compilePooledText(criteria.tagFilter, criteria.tagOperator);
+    }
+    if (!criteria.packageFilter.isEmpty()) {
+        m_package = compilePooledText(criteria.packageFilter, criteria.packageOperator);
+    }
+    if (!criteria.pidFilter.isEmpty()) {
+        m_pid = compileIds(criteria.pidFilter, criteria.pidOperator);
+    }
+    if (!criteria.tidFilter.isEmpty()) {
+        m_tid = compileIds(criteria.tidFilter, criteria.tidOperator);
+    }
+    if (!criteria.minLevel.isEmpty()) {
+        m_minLevel = QStringList({"V", "D", "I", "W", "E", "A"}).indexOf(criteria.minLevel);
+    }
+}
+
+bool CompiledLogFilter::matches(const LogEntry &entry) const
+{
+    // Every active part of the criteria must match
+    if (m_message.active && !m_message.matches(entry.message)) {
+        return false;
+    }
+    
+    if (m_startTime.active && m_startTime.compare(entry) < 0) {
+        return false;
+    }
+    if (m_endTime.active && m_endTime.compare(entry) > 0) {
+        return false;
+    }
+    
+    if (m_tag.text.active && !m_tag.matches(entry.tagId)) {
+        return false;
+    }
+    
+    if (m_package.text.active && !m_package.matches(entry.packageId)) {
+        return false;
+    }
+    
+    if (m_pid.active && !m_pid.matches(entry.pid)) {
+        return false;
+    }
+    
+    if (m_tid.active && !m_tid.matches(entry.tid)) {
+        return false;
+    }
+    
+    // LogLevel::Unknown maps to -1, like a level missing from the V..A list
+    if (static_cast<int>(entry.level) - 1 < m_minLevel) {
+        return false;
+    }
+    
+    return true;
+}
+
+QVector<quint32> CompiledLogFilter::matchingSequences(const LogStore &logs) const
+{
+    return scanChunks(logs.size(), [this, &logs](FilterChunk &chunk) {
+        for (qsizetype i = chunk.begin; i < chunk.end; ++i) {
+            if (matches(logs.at(i))) {
+                chunk.matches.append(logs.sequenceAt(i));
+            }
+        }
+    });
+}
+
+QVector<quint32> CompiledLogFilter::matchingSequences(const LogFileIndex &index) const
+{
+    // Level and time bounds only need the indexed metadata, so nothing is parsed
+    const bool metadataOnly = !m_message.active && !m_tag.text.active && !m_package.text.active
+                              && !m_pid.active && !m_tid.active;
+    
+    return scanChunks(index.size(), [this, &index, metadataOnly](FilterChunk &chunk) {
+        // Converters are not shared between threads
+        const QVector<LogConverterPtr> converters = metadataOnly ? QVector<LogConverterPtr>()
+                                                                 : index.cloneConverters();
+        for (qsizetype i = chunk.begin; i < chunk.end; ++i) {
+            const LogEntry entry = metadataOnly ? index.metadataAt(i) : index.parseLine(i, converters);
+            if (matches(entry)) {
+                chunk.matches.append(static_cast<quint32>(i));
+            }
+        }
+    });
+}
+
+QStringList CompiledLogFilter::splitKeywords(const QString &filter, FilterOperator &op)
+{
+    // Split by || for OR operator or && for AND operator
+    QStringList filterParts;
+    
+    if (filter.contains("&&")) {
+        filterParts = filter.split("&&");
+        op = FilterOperator::AND;
+    } else if (filter.contains("||")) {
+        filterParts = filter.split("||");
+        op = FilterOperator::OR;
+    } else {
+        // Backward compatibility: keep the given operator with | separator
+        filterParts = filter.split("|");
+    }
+    
+    QStringList keywords;
+    for (const QString &part : filterParts) {
+        QString trimmedPart = part.trimmed();
+        if (!trimmedPart.isEmpty()) {
+            keywords.append(trimmedPart);
+        }
+    }
+    return keywords;
+}
+
+CompiledLogFilter::TextFilter CompiledLogFilter::compileText(const QString &filter, FilterOperator op)
+{
+    TextFilter compiled;
+    compiled.active = true;
+    compiled.op = op;
+    
+    const QStringList keywords = splitKeywords(filter, compiled.op);
+    for (const QString &keyword : keywords) {
+        compiled.keywords.append(QStringMatcher(keyword, Qt::CaseInsensitive));
+    }
+    return compiled;
+}
+
+CompiledLogFilter::PooledTextFilter CompiledLogFilter::compilePooledText(const QString &filter, FilterOperator op)
+{
+    PooledTextFilter compiled;
+    compiled.text = compileText(filter, op);
+    
+    // Tags and packages repeat across millions of rows, so evaluate each distinct string once
+    const QStringList strings = LogStringPool::instance().strings();
+    compiled.cache.resize(strings.size());
+    for (qsizetype id = 0; id < strings.size(); ++id) {
+        compiled.cache[id] = compiled.text.matches(strings[id]);
+    }
+    return compiled;
+}
+
+CompiledLogFilter::IdFilter CompiledLogFilter::compileIds(const QString &filter, FilterOperator op)
+{
+    IdFilter compiled;
+    compiled.active = true;
+    compiled.op = op;
+    
+    const QStringList keywords = splitKeywords(filter, compiled.op);
+    for (const QString &keyword : keywords) {
+        // The text comparison is exact, so "0123" never matches PID 123
+        const qint32 id = LogEntry::parseId(keyword);
+        if (id != LogEntry::NoId && QString::number(id) == keyword) {
+            compiled.ids.append(id);
+        } else {
+            compiled.ids.append(LogEntry::NoId);
+        }
+    }
+    return compiled;
+}
+
+CompiledLogFilter::TimeBound CompiledLogFilter::compileTime(const QString &bound)
+{
+    TimeBound compiled;
+    compiled.active = true;
+    compiled.text = bound;
+    
+    if (bound.size() > TIME_LENGTH) {
+        return compiled;
+    }
+    
+    // Pad the missing digits with zeros, e.g. "12:3" becomes 12:30:00.000
+    qint64 key = 0;
+    for (int i = 0; i < TIME_LENGTH; ++i) {
+        const char expected = TIME_LAYOUT[i];
+        if (i < bound.size()) {
+            const char16_t c = bound[i].unicode();
+            if (expected == '0') {
+                if (c < '0' || c > '9') {
+                    return compiled;
+                }
+                key = key * 10 + (c - '0');
+            } else if (c != static_cast<char16_t>(expected)) {
+                return compiled;
+            }
+        } else if (expected == '0') {
+            key = key * 10;
+        }
+    }
+    
+    compiled.numeric = true;
+    compiled.complete = (bound.size() == TIME_LENGTH);
+    compiled.key = key;
+    return compiled;
+}
+
+bool CompiledLogFilter::TextFilter::matches(QStringView value) const
+{
+    if (op == FilterOperator::OR) {
+        // OR logic: at least one keyword must match
+        for (const QStringMatcher &keyword : keywords) {
+            if (keyword.indexIn(value) >= 0) {
+                return true;
+            }
+        }
+        return false; // No match found
+    } else {
+        // AND logic: all keywords must match
+        for (const QStringMatcher &keyword : keywords) {
+            if (keyword.indexIn(value) < 0) {
+                return false;
+            }
+        }
+        return true; // All keywords matched
+    }
+}
+
+bool CompiledLogFilter::PooledTextFilter::matches(quint32 id) const
+{
+    if (id < static_cast<quint32>(cache.size())) {
+        return cache[id];
+    }
+    
+    // Interned after the filter was compiled (live capture)
+    return text.matches(LogStringPool::instance().at(id));
+}
+
+bool CompiledLogFilter::IdFilter::matches(qint32 id) const
+{
+    if (op == FilterOperator::OR) {
+        // OR logic: at least one ID must match
+        for (qint32 value : ids) {
+            if (value != LogEntry::NoId && value == id) {
+                return true;
+            }
+        }
+        return false; // No match found
+    } else {
+        // AND logic: all IDs must match
+        for (qint32 value : ids) {
+            if (value == LogEntry::NoId || value != id) {
+                return false;
+            }
+        }
+        return true; // All IDs matched
+    }
+}
+
+int CompiledLogFilter::TimeBound::compare(const LogEntry &entry) const
+{
+    const int msecs = entry.msecsOfDay();
+    
+    // Entries without a timestamp have an empty time text, which sorts first
+    if (msecs < 0) {
+        return -1;
+    }
+    
+    if (numeric) {
+        const qint64 entryKey = timeKey(msecs);
+        if (entryKey < key) {
+            return -1;
+        }
+        // A longer time text with an equal prefix sorts after the bound
+        if (entryKey > key || !complete) {
+            return 1;
+        }
+        return 0;
+    }
+    
+    // Irregular bound, compare the formatted time text without allocating
+    const qint64 entryKey = timeKey(msecs);
+    char16_t timeText[TIME_LENGTH];
+    qint64 digits = entryKey;
+    for (int i = TIME_LENGTH - 1; i >= 0; --i) {
+        if (TIME_LAYOUT[i] == '0') {
+            timeText[i] = static_cast<char16_t>(u'0' + digits % 10);
+            digits /= 10;
+        } else {
+            timeText[i] = static_cast<char16_t>(TIME_LAYOUT[i]);
+        }
+    }
+    const int result = QStringView(timeText, TIME_LENGTH).compare(text);
+    return (result > 0) - (result < 0);
+}
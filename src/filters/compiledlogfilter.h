@@ -0,0 +1,98 @@
+#ifndef COMPILEDLOGFILTER_H
+#define COMPILEDLOGFILTER_H
+
+#include <QString>
+#include <QVector>
+#include <QStringMatcher>
+#include "ilogfilter.h"
+#include "logstore.h"
+
+class LogFileIndex;
+
+/**
+ * FilterCriteria compiled into a reusable predicate
+ * Keywords are split, trimmed and case-folded once, PID/TID lists become
+ * integers and level/time bounds become numbers, so matches() does no
+ * parsing and no allocation per entry.
+ */
+class CompiledLogFilter
+{
+public:
+    // Default filter matches every entry
+    CompiledLogFilter() = default;
+    explicit CompiledLogFilter(const FilterCriteria &criteria);
+    
+    bool matches(const LogEntry &entry) const;
+    
+    /**
+     * Find all matching entries, scanning large stores in parallel
+     * @param logs Entries to filter
+     * @return Sequence numbers of matching entries, oldest first
+     */
+    QVector<quint32> matchingSequences(const LogStore &logs) const;
+    
+    /**
+     * Find all matching lines of an indexed file
+     * Lines are parsed in parallel without filling the index's cache; filters on
+     * the level and time only read the indexed metadata
+     * @param index Indexed file to filter
+     * @return Line indices (sequence numbers) of matching entries, oldest first
+     */
+    QVector<quint32> matchingSequences(const LogFileIndex &index) const;
+
+private:
+    // Substring keywords joined by || or &&
+    struct TextFilter {
+        bool active = false;
+        FilterOperator op = FilterOperator::OR;
+        QVector<QStringMatcher> keywords;
+        
+        bool matches(QStringView value) const;
+    };
+    
+    // Text filter over an interned field, with results cached per pool ID
+    struct PooledTextFilter {
+        TextFilter text;
+        QVector<bool> cache; // Indexed by pool ID, covers IDs interned before compiling
+        
+        bool matches(quint32 id) const;
+    };
+    
+    // Exact PID/TID matches joined by || or &&
+    struct IdFilter {
+        bool active = false;
+        FilterOperator op = FilterOperator::OR;
+        QVector<qint32> ids; // LogEntry::NoId for keywords that can never match
+        
+        bool matches(qint32 id) const;
+    };
+    
+    // Start or end of the time range, compared like the "HH:MM:SS.mmm" text
+    struct TimeBound {
+        bool active = false;
+        bool numeric = false;   // Bound follows the time layout and compares as a number
+        bool complete = false;  // All 12 characters given
+        qint64 key = 0;         // Digits of the bound padded with zeros, as HHMMSSmmm
+        QString text;           // Fallback for bounds that don't follow the layout
+        
+        // Lexicographic comparison of the entry's time text with the bound
+        int compare(const LogEntry &entry) const;
+    };
+    
+    static TextFilter compileText(const QString &filter, FilterOperator op);
+    static PooledTextFilter compilePooledText(const QString &filter, FilterOperator op);
+    static IdFilter compileIds(const QString &filter, FilterOperator op);
+    static TimeBound compileTime(const QString &bound);
+    static QStringList splitKeywords(const QString &filter, FilterOperator &op);
+    
+    TextFilter m_message;
+    PooledTextFilter m_tag;
+    PooledTextFilter m_package;
+    IdFilter m_pid;
+    IdFilter m_tid;
+    TimeBound m_startTime;
+    TimeBound m_endTime;
+    int m_minLevel = -1; // Index into V, D, I, W, E, A; -1 accepts every level
+};
+
+#endif // COMPILEDLOGFILTER_H
@@ -2,6 +2,7 @@
 #define ILOGCONVERTER_H
 
 #include <QString>
+#include <QByteArrayView>
 #include <QSharedPointer>
 #include "logentry.h"
 
@@ -21,6 +22,40 @@ public:
      */
     virtual LogEntry convert(const QString &line) const = 0;
     
+    /**
+     * Convert a UTF-8 encoded log line without decoding it first
+     * Converters that can parse raw bytes override this, the default decodes
+     * the line and calls convert()
+     * @param line The raw log line, without line terminator
+     * @return Same result as convert() on the decoded line
+     */
+    virtual LogEntry convertUtf8(QByteArrayView line) const {
+        return convert(QString::fromUtf8(line));
+    }
+    
+    /**
+     * Check a UTF-8 encoded log line and read only its level and timestamp
+     * Used to index large files without building entries; converters that can
+     * skip the tag and message override this, the default converts the line
+     * @param line The raw log line, without line terminator
+     * @param level Output parameter for the level
+     * @param timestamp Output parameter for the timestamp
+     * @return True if convertUtf8() returns a valid entry for the line
+     */
+    virtual bool scanUtf8(QByteArrayView line, LogLevel &level, qint64 &timestamp) const {
+        const LogEntry entry = convertUtf8(line);
+        level = entry.level;
+        timestamp = entry.timestamp;
+        return entry.isValid();
+    }
+    
+    /**
+     * Create an independent converter of the same type
+     * Used to give each parsing thread its own instance
+     * @return New converter with the same configuration
+     */
+    virtual QSharedPointer<ILogConverter> clone() const = 0;
+    
     /**
      * Get the name of this converter
      * @return Human-readable name
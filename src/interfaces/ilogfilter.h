@@ -9,6 +9,7 @@ enum class FilterOperator {
     AND   // All keywords must match (&&)
 };
 
+// Filter inputs as entered, compiled by CompiledLogFilter
 struct FilterCriteria {
     QString messageFilter;
     FilterOperator messageOperator = FilterOperator::OR;
@@ -25,13 +26,4 @@ struct FilterCriteria {
     QString minLevel;
 };
 
-class ILogFilter
-{
-public:
-    virtual ~ILogFilter() = default;
-    
-    // Check if a log entry passes the filter
-    virtual bool passesFilter(const LogEntry &entry, const FilterCriteria &criteria) const = 0;
-};
-
 #endif // ILOGFILTER_H
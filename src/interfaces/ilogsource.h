@@ -0,0 +1,36 @@
+#ifndef ILOGSOURCE_H
+#define ILOGSOURCE_H
+
+#include "logentry.h"
+
+/**
+ * Interface for the entries shown by LogModel
+ * Entries are addressed by 32-bit sequence numbers that may wrap, so they are
+ * ordered through offsetOf(). Implemented by the in-memory LogStore and by
+ * LogFileIndex, which parses entries from the file when they are requested
+ */
+class ILogSource
+{
+public:
+    virtual ~ILogSource() = default;
+    
+    // Number of available entries
+    virtual qsizetype size() const = 0;
+    
+    /**
+     * Position of a sequence number relative to the oldest available entry
+     * @return Offset, >= size() if the entry is not available
+     */
+    virtual quint32 offsetOf(quint32 sequence) const = 0;
+    
+    virtual bool contains(quint32 sequence) const = 0;
+    
+    /**
+     * Get an entry by sequence number
+     * @param sequence Sequence number of an available entry
+     * @return Copy of the entry (the message is implicitly shared)
+     */
+    virtual LogEntry entry(quint32 sequence) const = 0;
+};
+
+#endif // ILOGSOURCE_H
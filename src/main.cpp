@@ -1,11 +1,80 @@
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+// Report a bad option value like QCommandLineParser reports an unknown option
+[[noreturn]] void exitWithOptionError(const QString &message)
+{
+    std::fprintf(stderr, "%s: %s\n", qPrintable(QCoreApplication::applicationName()), qPrintable(message));
+    std::exit(EXIT_FAILURE);
+}
+
+// Value of an option that takes a positive count, 0 if the option isn't set
+qint64 positiveValue(const QCommandLineParser &parser, const QCommandLineOption &option, qint64 max)
+{
+    if (!parser.isSet(option)) {
+        return 0;
+    }
+    bool ok = false;
+    const QString text = parser.value(option);
+    const qint64 value = text.toLongLong(&ok);
+    if (!ok || value <= 0 || value > max) {
+        exitWithOptionError(QString("Invalid value '%1' for option '%2', expected a number from 1 to %3.")
+                                .arg(text, option.names().constFirst())
+                                .arg(max));
+    }
+    return value;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption maxLinesOption("max-lines",
+                                      "Keep at most <count> log entries, dropping the oldest.",
+                                      "count");
+    QCommandLineOption maxMemoryOption("max-mb",
+                                       "Keep the stored log entries under about <size> MB, dropping the oldest.",
+                                       "size");
+    QCommandLineOption stdinOption("stdin",
+                                   "Read log lines from standard input, e.g. adb logcat | ToolLogPro --stdin.");
+    QCommandLineOption fifoOption("fifo",
+                                  "Read log lines from the named pipe <path>.",
+                                  "path");
+    QCommandLineOption socketOption("socket",
+                                    "Read log lines from the local socket <name> (a Unix domain socket path).",
+                                    "name");
+    parser.addOption(maxLinesOption);
+    parser.addOption(maxMemoryOption);
+    parser.addOption(stdinOption);
+    parser.addOption(fifoOption);
+    parser.addOption(socketOption);
+    parser.process(a);
+    
+    const qint64 bytesPerMb = 1024 * 1024;
+    const qint64 maxLines = positiveValue(parser, maxLinesOption, std::numeric_limits<qsizetype>::max());
+    const qint64 maxMb = positiveValue(parser, maxMemoryOption, std::numeric_limits<qint64>::max() / bytesPerMb);
+    
     MainWindow w;
+    w.setLogCapacity(maxLines, maxMb * bytesPerMb);
     w.show();
+    
+    if (parser.isSet(stdinOption)) {
+        w.startStream(StreamLogReader::Source::Stdin, QString());
+    } else if (parser.isSet(fifoOption)) {
+        w.startStream(StreamLogReader::Source::Fifo, parser.value(fifoOption));
+    } else if (parser.isSet(socketOption)) {
+        w.startStream(StreamLogReader::Source::LocalSocket, parser.value(socketOption));
+    }
     return a.exec();
 }
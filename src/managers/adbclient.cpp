@@ -0,0 +1,223 @@
+#include "adbclient.h"
+#include <QTcpSocket>
+#include <QRegularExpression>
+#include <QtEndian>
+
+namespace {
+
+const int STATUS_SIZE = 4;
+const int LENGTH_PREFIX_SIZE = 4;
+
+// Read size bytes, false if the deadline passes or the connection closes first
+bool readExactly(QTcpSocket &socket, qint64 size, QByteArray &data, const QDeadlineTimer &deadline)
+{
+    data.clear();
+    while (data.size() < size) {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(deadline.remainingTime())) {
+            return false;
+        }
+        data.append(socket.read(size - data.size()));
+    }
+    return true;
+}
+
+// Read the server's OKAY, or the message that comes with a FAIL; refused is set
+// when the server answered FAIL
+bool readStatus(QTcpSocket &socket, const QDeadlineTimer &deadline, QString &errorMsg,
+                bool *refused = nullptr)
+{
+    QByteArray status;
+    if (!readExactly(socket, STATUS_SIZE, status, deadline)) {
+        errorMsg = "No reply from the adb server";
+        return false;
+    }
+    if (status == "OKAY") {
+        return true;
+    }
+    
+    QByteArray length;
+    QByteArray message;
+    bool ok = false;
+    if (status == "FAIL" && readExactly(socket, LENGTH_PREFIX_SIZE, length, deadline)
+        && readExactly(socket, length.toInt(&ok, 16), message, deadline) && ok) {
+        errorMsg = QString::fromUtf8(message);
+        if (refused) {
+            *refused = true;
+        }
+    } else {
+        errorMsg = QString("Unexpected reply from the adb server: %1").arg(QString::fromLatin1(status));
+    }
+    return false;
+}
+
+} // namespace
+
+AdbClient::AdbClient(const QString &host, quint16 port)
+    : m_host(host)
+    , m_port(port)
+{}
+
+QString AdbClient::host() const
+{
+    return m_host;
+}
+
+quint16 AdbClient::port() const
+{
+    return m_port;
+}
+
+bool AdbClient::hostQuery(const QString &service, QByteArray &reply, int timeoutMs, QString &errorMsg) const
+{
+    const QDeadlineTimer deadline(timeoutMs);
+    QTcpSocket socket;
+    if (!openService(socket, service, deadline, errorMsg)) {
+        return false;
+    }
+    
+    QByteArray length;
+    bool ok = false;
+    if (!readExactly(socket, LENGTH_PREFIX_SIZE, length, deadline)
+        || !readExactly(socket, length.toInt(&ok, 16), reply, deadline) || !ok) {
+        errorMsg = QString("Incomplete reply to %1").arg(service);
+        return false;
+    }
+    return true;
+}
+
+bool AdbClient::shell(const QString &serial, const QStringList &arguments, ShellResult &result,
+                      int timeoutMs, QString &errorMsg) const
+{
+    QStringList quoted;
+    for (const QString &argument : arguments) {
+        quoted.append(quoteArgument(argument));
+    }
+    const QString command = quoted.join(' ');
+    const QDeadlineTimer deadline(timeoutMs);
+    result = ShellResult();
+    
+    // Shell v2 keeps stderr apart and reports the exit code; raw means no terminal
+    QTcpSocket socket;
+    bool refused = false;
+    if (openDeviceService(socket, serial, "shell,v2,raw:" + command, deadline, errorMsg, &refused)) {
+        QByteArray header;
+        QByteArray data;
+        while (readExactly(socket, SHELL_HEADER_SIZE, header, deadline)) {
+            const quint32 length = qFromLittleEndian<quint32>(header.constData() + 1);
+            if (!readExactly(socket, length, data, deadline)) {
+                break;
+            }
+            switch (static_cast<quint8>(header[0])) {
+            case ShellStdout:
+                result.standardOutput.append(data);
+                break;
+            case ShellStderr:
+                result.standardError.append(data);
+                break;
+            case ShellExit:
+                result.exitCode = data.isEmpty() ? -1 : static_cast<quint8>(data[0]);
+                return true;
+            default:
+                break;
+            }
+        }
+        errorMsg = socket.state() == QAbstractSocket::ConnectedState ? QString("Timeout while running %1").arg(command)
+                                                                       : QString("Shell closed before %1 finished").arg(command);
+        return false;
+    }
+    
+    // Older devices refuse shell v2; any other failure, e.g. an offline device, would
+    // fail the plain shell the same way
+    if (!refused) {
+        return false;
+    }
+    
+    // The plain shell service sends output until it closes
+    QTcpSocket legacySocket;
+    if (!openDeviceService(legacySocket, serial, "shell:" + command, deadline, errorMsg)) {
+        return false;
+    }
+    for (;;) {
+        result.standardOutput.append(legacySocket.readAll());
+        if (legacySocket.state() != QAbstractSocket::ConnectedState) {
+            break;
+        }
+        if (!legacySocket.waitForReadyRead(deadline.remainingTime())
+            && legacySocket.state() == QAbstractSocket::ConnectedState) {
+            errorMsg = QString("Timeout while running %1").arg(command);
+            return false;
+        }
+    }
+    result.exitCode = 0;
+    return true;
+}
+
+QByteArray AdbClient::encodeRequest(const QString &service)
+{
+    const QByteArray data = service.toUtf8();
+    return QByteArray::number(data.size(), 16).rightJustified(LENGTH_PREFIX_SIZE, '0') + data;
+}
+
+bool AdbClient::takeMessage(QByteArray &buffer, QByteArray &payload)
+{
+    while (buffer.size() >= LENGTH_PREFIX_SIZE) {
+        bool ok = false;
+        const int length = QByteArrayView(buffer.constData(), LENGTH_PREFIX_SIZE).toInt(&ok, 16);
+        if (!ok || length < 0) {
+            // Not framed, e.g. a message printed by adb; drop the line once it is complete
+            const qsizetype lineEnd = buffer.indexOf('\n');
+            if (lineEnd < 0) {
+                return false;
+            }
+            buffer.remove(0, lineEnd + 1);
+            continue;
+        }
+        if (buffer.size() < LENGTH_PREFIX_SIZE + length) {
+            return false;
+        }
+        
+        payload = buffer.mid(LENGTH_PREFIX_SIZE, length);
+        buffer.remove(0, LENGTH_PREFIX_SIZE + length);
+        return true;
+    }
+    return false;
+}
+
+QString AdbClient::quoteArgument(const QString &argument)
+{
+    static const QRegularExpression plain("^[A-Za-z0-9_./:=@%+,-]+$");
+    if (plain.match(argument).hasMatch()) {
+        return argument;
+    }
+    
+    // Single quotes keep everything literal, a quote itself is closed, escaped and reopened
+    QString quoted = argument;
+    quoted.replace('\'', "'\\''");
+    return QChar('\'') + quoted + QChar('\'');
+}
+
+bool AdbClient::openService(QTcpSocket &socket, const QString &service,
+                            const QDeadlineTimer &deadline, QString &errorMsg) const
+{
+    socket.connectToHost(m_host, m_port);
+    if (!socket.waitForConnected(deadline.remainingTime())) {
+        errorMsg = QString("Can't connect to the adb server at %1:%2: %3")
+                       .arg(m_host).arg(m_port).arg(socket.errorString());
+        return false;
+    }
+    
+    socket.write(encodeRequest(service));
+    return readStatus(socket, deadline, errorMsg);
+}
+
+bool AdbClient::openDeviceService(QTcpSocket &socket, const QString &serial, const QString &service,
+                                  const QDeadlineTimer &deadline, QString &errorMsg,
+                                  bool *serviceRefused) const
+{
+    // After the transport is selected the same connection carries the device service
+    if (!openService(socket, "host:transport:" + serial, deadline, errorMsg)) {
+        return false;
+    }
+    socket.write(encodeRequest(service));
+    return readStatus(socket, deadline, errorMsg, serviceRefused);
+}
@@ -0,0 +1,110 @@
+#ifndef ADBCLIENT_H
+#define ADBCLIENT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QDeadlineTimer>
+
+class QTcpSocket;
+
+/**
+ * Talks to the local adb server directly instead of running the adb executable
+ * Requests use the server's smart socket protocol: a host service such as
+ * host:devices-l, or host:transport:<serial> followed by a device service such
+ * as shell. The server closes a connection once its service ends, so every call
+ * opens its own connection; calls don't share state and may run on several
+ * threads at once. Calls block the calling thread until done or timed out.
+ * The address can point at a fake server that emulates these services
+ */
+class AdbClient
+{
+public:
+    static const quint16 DEFAULT_PORT = 5037;
+    
+    // Shell v2 packets are an ID byte and a little-endian length, then the data
+    static constexpr int SHELL_HEADER_SIZE = 5;
+    enum ShellPacketId : quint8 {
+        ShellStdin = 0,
+        ShellStdout = 1,
+        ShellStderr = 2,
+        ShellExit = 3
+    };
+    
+    // Output of a shell command
+    struct ShellResult {
+        QByteArray standardOutput;
+        QByteArray standardError;  // Mixed into standardOutput by devices without shell v2
+        int exitCode = -1;         // 0 if the device can't report it
+    };
+    
+    explicit AdbClient(const QString &host = "127.0.0.1", quint16 port = DEFAULT_PORT);
+    
+    QString host() const;
+    quint16 port() const;
+    
+    /**
+     * Run a host service that answers with one length-prefixed message
+     * @param service e.g. "host:devices-l" or "host:version"
+     * @param reply Receives the message
+     * @param timeoutMs Time allowed for the whole request
+     * @param errorMsg Output parameter for error messages
+     * @return false if the server can't be reached or refused the request
+     */
+    bool hostQuery(const QString &service, QByteArray &reply, int timeoutMs, QString &errorMsg) const;
+    
+    /**
+     * Run a shell command on a device
+     * Arguments are quoted, so values with spaces or shell characters arrive as given.
+     * Shell v2 is tried first; the plain shell only when the device refuses v2.
+     * @param serial Device serial
+     * @param arguments Command and its arguments
+     * @param result Receives the output and exit code
+     * @param timeoutMs Time allowed for the whole command
+     * @param errorMsg Output parameter for error messages
+     * @return false if the command couldn't be run to its end
+     */
+    bool shell(const QString &serial, const QStringList &arguments, ShellResult &result,
+               int timeoutMs, QString &errorMsg) const;
+    
+    /**
+     * Connect, select a device and request one of its services
+     * On success the socket carries the service's own data, e.g. shell v2 packets
+     * @param socket Unconnected socket
+     * @param serial Device serial
+     * @param service Device service such as "shell,v2,raw:"
+     * @param deadline Time allowed for connecting and the replies
+     * @param errorMsg Output parameter for error messages
+     * @param serviceRefused Optional, set if the device was selected but the server
+     *                       answered FAIL to the service itself
+     * @return false if the server can't be reached or refused the device or service
+     */
+    bool openDeviceService(QTcpSocket &socket, const QString &serial, const QString &service,
+                           const QDeadlineTimer &deadline, QString &errorMsg,
+                           bool *serviceRefused = nullptr) const;
+    
+    // Length-prefixed request for a service
+    static QByteArray encodeRequest(const QString &service);
+    
+    /**
+     * Take the next length-prefixed message: four hex digits giving the payload
+     * length, then the payload; unframed lines before a message are dropped
+     * @param buffer Received data, the message is removed from it
+     * @param payload Receives the payload
+     * @return false if the buffer doesn't hold a complete message yet
+     */
+    static bool takeMessage(QByteArray &buffer, QByteArray &payload);
+    
+    // Quote an argument for the device's shell
+    static QString quoteArgument(const QString &argument);
+
+private:
+    // Connect and request a service, consuming the server's OKAY
+    bool openService(QTcpSocket &socket, const QString &service,
+                     const QDeadlineTimer &deadline, QString &errorMsg) const;
+    
+    QString m_host;
+    quint16 m_port;
+};
+
+#endif // ADBCLIENT_H
@@ -3,17 +3,13 @@
 
 #include <QStringList>
 
-
+// Arguments of the adb executable for logcat; the other commands are run by the
+// device's shell through AdbClient::shell()
 namespace AdbCommand {
 
-inline QStringList listDevices()
-{
-    return QStringList() << "devices" << "-l";
-}
-
-inline QStringList getDeviceModel(const QString &deviceId)
+inline QStringList getDeviceModel()
 {
-    return QStringList() << "-s" << deviceId << "shell" << "getprop" << "ro.product.model";
+    return QStringList() << "getprop" << "ro.product.model";
 }
 
 inline QStringList startLogcat(const QString &deviceId)
@@ -21,49 +17,49 @@ inline QStringList startLogcat(const QString &deviceId)
     return QStringList() << "-s" << deviceId << "logcat" << "-v" << "time";
 }
 
-inline QStringList listSettings(const QString &deviceId, const QString &namespace_)
+inline QStringList listSettings(const QString &namespace_)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "settings" << "list" << namespace_;
+    return QStringList() << "settings" << "list" << namespace_;
 }
 
-inline QStringList getSetting(const QString &deviceId, const QString &namespace_, const QString &setting)
+inline QStringList getSetting(const QString &namespace_, const QString &setting)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "settings" << "get" << namespace_ << setting;
+    return QStringList() << "settings" << "get" << namespace_ << setting;
 }
 
-inline QStringList putSetting(const QString &deviceId, const QString &namespace_, const QString &setting, const QString &value)
+inline QStringList putSetting(const QString &namespace_, const QString &setting, const QString &value)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "settings" << "put" << namespace_ << setting << value;
+    return QStringList() << "settings" << "put" << namespace_ << setting << value;
 }
 
-inline QStringList listProperties(const QString &deviceId)
+inline QStringList listProperties()
 {
-    return QStringList() << "-s" << deviceId << "shell" << "getprop";
+    return QStringList() << "getprop";
 }
 
-inline QStringList getProperty(const QString &deviceId, const QString &property)
+inline QStringList getProperty(const QString &property)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "getprop" << property;
+    return QStringList() << "getprop" << property;
 }
 
-inline QStringList setProperty(const QString &deviceId, const QString &property, const QString &value)
+inline QStringList setProperty(const QString &property, const QString &value)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "setprop" << property << value;
+    return QStringList() << "setprop" << property << value;
 }
 
-inline QStringList getPropertyDefinitions(const QString &deviceId)
+inline QStringList getPropertyDefinitions()
 {
-    return QStringList() << "-s" << deviceId << "shell" << "cmd" << "cradle_manager" << "get" << "configuration";
+    return QStringList() << "cmd" << "cradle_manager" << "get" << "configuration";
 }
 
-inline QStringList getCradleProperty(const QString &deviceId, const QString &propertyId)
+inline QStringList getCradleProperty(const QString &propertyId)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "cmd" << "cradle_manager" << "get" << propertyId;
+    return QStringList() << "cmd" << "cradle_manager" << "get" << propertyId;
 }
 
-inline QStringList setCradleProperty(const QString &deviceId, const QString &propertyId, const QString &value)
+inline QStringList setCradleProperty(const QString &propertyId, const QString &value)
 {
-    return QStringList() << "-s" << deviceId << "shell" << "cmd" << "cradle_manager" << "set" << propertyId << value;
+    return QStringList() << "cmd" << "cradle_manager" << "set" << propertyId << value;
 }
 
 } // namespace AdbCommand
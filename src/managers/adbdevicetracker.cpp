@@ -0,0 +1,128 @@
+#include "adbdevicetracker.h"
+#include <QTcpSocket>
+#include <QProcess>
+#include <QTimer>
+
+namespace {
+
+// Reconnect delays after the connection dropped; a list received resets the delay
+const int MIN_RECONNECT_DELAY_MS = 500;
+const int MAX_RECONNECT_DELAY_MS = 30000;
+
+const char TRACK_DEVICES_SERVICE[] = "host:track-devices-l";
+
+} // namespace
+
+AdbDeviceTracker::AdbDeviceTracker(QObject *parent)
+    : QObject(parent)
+    , m_socket(nullptr)
+    , m_reconnectTimer(new QTimer(this))
+    , m_awaitingStatus(false)
+    , m_serverStartRequested(false)
+    , m_reconnectDelayMs(MIN_RECONNECT_DELAY_MS)
+{
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &AdbDeviceTracker::connectToServer);
+}
+
+AdbDeviceTracker::~AdbDeviceTracker()
+{
+    stop();
+}
+
+void AdbDeviceTracker::start(const QString &adbPath, const AdbClient &client)
+{
+    stop();
+    m_adbPath = adbPath;
+    m_client = client;
+    m_reconnectDelayMs = MIN_RECONNECT_DELAY_MS;
+    m_serverStartRequested = false;
+    connectToServer();
+}
+
+void AdbDeviceTracker::stop()
+{
+    m_reconnectTimer->stop();
+    if (m_socket) {
+        disconnect(m_socket, nullptr, this, nullptr);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    m_buffer.clear();
+}
+
+void AdbDeviceTracker::connectToServer()
+{
+    // Nothing is waited for, the connection, reply and errors arrive as signals
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::connected, this, [this]() {
+        m_socket->write(AdbClient::encodeRequest(TRACK_DEVICES_SERVICE));
+    });
+    connect(m_socket, &QTcpSocket::readyRead, this, &AdbDeviceTracker::readReply);
+    connect(m_socket, &QTcpSocket::disconnected, this, &AdbDeviceTracker::onConnectionLost);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError error) {
+        // No server listening; start one, it is picked up by the next attempt
+        if (error == QAbstractSocket::ConnectionRefusedError && !m_serverStartRequested) {
+            m_serverStartRequested = true;
+            if (!QProcess::startDetached(m_adbPath, {"start-server"})) {
+                emit errorOccurred(QString("Failed to start the adb server with %1").arg(m_adbPath));
+            }
+        }
+        onConnectionLost();
+    });
+    
+    m_buffer.clear();
+    m_awaitingStatus = true;
+    m_socket->connectToHost(m_client.host(), m_client.port());
+}
+
+void AdbDeviceTracker::readReply()
+{
+    m_buffer.append(m_socket->readAll());
+    
+    if (m_awaitingStatus) {
+        if (m_buffer.size() < 4) {
+            return;
+        }
+        if (!m_buffer.startsWith("OKAY")) {
+            emit errorOccurred("The adb server refused to track devices");
+            onConnectionLost();
+            return;
+        }
+        m_buffer.remove(0, 4);
+        m_awaitingStatus = false;
+    }
+    
+    // Only the newest list matters if several arrived at once
+    QByteArray payload;
+    bool received = false;
+    while (AdbClient::takeMessage(m_buffer, payload)) {
+        received = true;
+    }
+    
+    if (received) {
+        m_reconnectDelayMs = MIN_RECONNECT_DELAY_MS;
+        m_serverStartRequested = false;
+        emit devicesListed(QString::fromUtf8(payload));
+    }
+}
+
+void AdbDeviceTracker::onConnectionLost()
+{
+    if (!m_socket) {
+        return;
+    }
+    
+    // Deleted later, this runs inside one of its signals
+    disconnect(m_socket, nullptr, this, nullptr);
+    m_socket->abort();
+    m_socket->deleteLater();
+    m_socket = nullptr;
+    
+    // The server went away with its devices; report an empty list until it is back
+    emit devicesListed(QString());
+    
+    m_reconnectTimer->start(m_reconnectDelayMs);
+    m_reconnectDelayMs = qMin(m_reconnectDelayMs * 2, MAX_RECONNECT_DELAY_MS);
+}
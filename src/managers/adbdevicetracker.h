@@ -0,0 +1,59 @@
+#ifndef ADBDEVICETRACKER_H
+#define ADBDEVICETRACKER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include "adbclient.h"
+
+class QTimer;
+class QTcpSocket;
+
+/**
+ * Follows the device list through the adb server's host:track-devices-l service
+ * The server pushes the complete list whenever a device is attached, detached
+ * or changes state, so nothing is polled and the GUI thread never waits for
+ * adb. When the connection drops (e.g. the server was killed or restarted) it
+ * is opened again after a delay that doubles up to a limit; a server that isn't
+ * running is started with `adb start-server` in the background
+ */
+class AdbDeviceTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AdbDeviceTracker(QObject *parent = nullptr);
+    ~AdbDeviceTracker() override;
+    
+    /**
+     * Start tracking, restarting if already running
+     * @param adbPath adb executable, used to start the server when it isn't running
+     * @param client Address of the adb server
+     */
+    void start(const QString &adbPath, const AdbClient &client);
+    
+    // Stop tracking without reconnecting
+    void stop();
+
+signals:
+    // Full device list in `adb devices -l` format, sent on every change
+    void devicesListed(const QString &deviceList);
+    
+    void errorOccurred(const QString &error);
+
+private:
+    void connectToServer();
+    void readReply();
+    void onConnectionLost();
+    
+    QString m_adbPath;
+    AdbClient m_client;
+    QTcpSocket *m_socket;
+    QTimer *m_reconnectTimer;
+    QByteArray m_buffer;         // Reply not yet split into messages
+    bool m_awaitingStatus;       // The server's OKAY hasn't arrived yet
+    bool m_serverStartRequested; // adb start-server was run since the last list
+    int m_reconnectDelayMs;      // Delay before the next attempt, doubles on every failure
+};
+
+#endif // ADBDEVICETRACKER_H
@@ -6,25 +6,27 @@
 AdbManager::AdbManager(QObject *parent)
     : QObject(parent)
     , m_adbPath("adb")
-    , m_logcatProcess(nullptr)
-    , m_deviceDetectionTimer(new QTimer(this))
+    , m_logcatThread(nullptr)
+    , m_logcatReader(nullptr)
+    , m_deviceTracker(new AdbDeviceTracker(this))
+    , m_settingsFetcher(new AdbSettingsFetcher(this))
     , m_logcatRunning(false)
 {
-    // Set up device detection timer (check every 2 seconds)
-    m_deviceDetectionTimer->setInterval(2000);
-    connect(m_deviceDetectionTimer, &QTimer::timeout, this, &AdbManager::detectDevices);
-    m_deviceDetectionTimer->start();
+    // The adb server pushes device changes, nothing is polled
+    connect(m_deviceTracker, &AdbDeviceTracker::devicesListed, this, &AdbManager::parseDeviceList);
+    connect(m_deviceTracker, &AdbDeviceTracker::errorOccurred, this, &AdbManager::errorOccurred);
+    m_deviceTracker->start(m_adbPath, m_client);
     
-    // Initial device detection
-    detectDevices();
+    connect(m_settingsFetcher, &AdbSettingsFetcher::namespaceFetched, this, &AdbManager::settingsFetched);
+    connect(m_settingsFetcher, &AdbSettingsFetcher::errorOccurred, this, &AdbManager::errorOccurred);
 }
 
 AdbManager::~AdbManager()
 {
     stopLogcat();
-    if (m_deviceDetectionTimer) {
-        m_deviceDetectionTimer->stop();
-    }
+    m_deviceTracker->stop();
+    m_settingsFetcher->stop();
+    qDeleteAll(m_shellSessions);
 }
 
 AdbManager& AdbManager::instance()
@@ -38,20 +40,6 @@ QList<AdbDevice> AdbManager::getConnectedDevices()
     return m_connectedDevices;
 }
 
-void AdbManager::detectDevices()
-{
-    QProcess process;
-    process.start(m_adbPath, AdbCommand::listDevices());
-    
-    if (!process.waitForFinished(3000)) {
-        emit errorOccurred("Failed to execute adb devices command");
-        return;
-    }
-    
-    QString output = process.readAllStandardOutput();
-    parseDeviceList(output);
-}
-
 void AdbManager::parseDeviceList(const QString &output)
 {
     QList<AdbDevice> newDevices;
@@ -87,11 +75,11 @@ void AdbManager::parseDeviceList(const QString &output)
         }
     }
     
-    // Check if device list changed
+    // Check if device list changed; a device that was just authorized gets its model name
     bool changed = (newDevices.size() != m_connectedDevices.size());
     if (!changed) {
         for (int i = 0; i < newDevices.size(); ++i) {
-            if (newDevices[i].id != m_connectedDevices[i].id) {
+            if (newDevices[i].id != m_connectedDevices[i].id || newDevices[i].name != m_connectedDevices[i].name) {
                 changed = true;
                 break;
             }
@@ -100,6 +88,7 @@ void AdbManager::parseDeviceList(const QString &output)
     
     if (changed) {
         m_connectedDevices = newDevices;
+        closeShellSessions(newDevices);
         
         // If current device is not in the new list, clear it
         if (!m_currentDeviceId.isEmpty()) {
@@ -121,11 +110,10 @@ void AdbManager::parseDeviceList(const QString &output)
 
 QString AdbManager::getDeviceName(const QString &deviceId)
 {
-    QProcess process;
-    process.start(m_adbPath, AdbCommand::getDeviceModel(deviceId));
-    
-    if (process.waitForFinished(2000)) {
-        QString name = process.readAllStandardOutput().trimmed();
+    AdbClient::ShellResult result;
+    QString error;
+    if (m_client.shell(deviceId, AdbCommand::getDeviceModel(), result, 2000, error)) {
+        QString name = QString::fromUtf8(result.standardOutput).trimmed();
         if (!name.isEmpty()) {
             return name;
         }
@@ -142,50 +130,55 @@ QString AdbManager::getCurrentDeviceId() const
 void AdbManager::setCurrentDeviceId(const QString &deviceId)
 {
     if (m_currentDeviceId != deviceId) {
+        // Settings still being listed belong to the previous device
+        m_settingsFetcher->stop();
         m_currentDeviceId = deviceId;
         qDebug() << "AdbManager: Current device set to" << deviceId;
     }
 }
 
-bool AdbManager::startLogcat(const QString &deviceId)
+bool AdbManager::startLogcat(const QString &deviceId, const LogConverterPtr &converter)
 {
-    if (m_logcatRunning) {
+    // Also clean up after a process that already exited on its own
+    if (m_logcatThread) {
         stopLogcat();
     }
     
     m_currentDeviceId = deviceId;
-    m_logcatProcess = new QProcess(this);
+    
+    // Reading and parsing run on their own thread, the GUI only receives ready batches
+    m_logcatThread = new QThread(this);
+    m_logcatReader = new LogcatReader(m_adbPath, AdbCommand::startLogcat(deviceId),
+                                      converter, &m_logcatQueue);
+    m_logcatReader->moveToThread(m_logcatThread);
     
     // Connect signals
-    connect(m_logcatProcess, &QProcess::readyReadStandardOutput, this, [this]() {
-        while (m_logcatProcess && m_logcatProcess->canReadLine()) {
-            QString line = m_logcatProcess->readLine().trimmed();
-            if (!line.isEmpty()) {
-                emit logcatLineReceived(line);
-            }
-        }
-    });
+    connect(m_logcatReader, &LogcatReader::entriesAvailable, this, &AdbManager::logcatEntriesAvailable);
     
-    connect(m_logcatProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
-        QString errorMsg = QString("Logcat process error: %1").arg(error);
-        emit errorOccurred(errorMsg);
+    connect(m_logcatReader, &LogcatReader::errorOccurred, this, [this](const QString &error) {
+        emit errorOccurred(error);
         m_logcatRunning = false;
     });
     
-    connect(m_logcatProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
-        Q_UNUSED(exitCode);
-        Q_UNUSED(exitStatus);
+    connect(m_logcatReader, &LogcatReader::finished, this, [this]() {
         m_logcatRunning = false;
         emit logcatStopped();
     });
     
+    m_logcatThread->start();
+    
     // Start logcat with time format
-    m_logcatProcess->start(m_adbPath, AdbCommand::startLogcat(deviceId));
-    if (!m_logcatProcess->waitForStarted(3000)) {
+    bool started = false;
+    QMetaObject::invokeMethod(m_logcatReader, &LogcatReader::start,
+                              Qt::BlockingQueuedConnection, &started);
+    if (!started) {
         emit errorOccurred("Failed to start logcat");
-        delete m_logcatProcess;
-        m_logcatProcess = nullptr;
+        m_logcatThread->quit();
+        m_logcatThread->wait();
+        delete m_logcatReader;
+        m_logcatReader = nullptr;
+        delete m_logcatThread;
+        m_logcatThread = nullptr;
         return false;
     }
     
@@ -196,16 +189,30 @@ bool AdbManager::startLogcat(const QString &deviceId)
 
 void AdbManager::stopLogcat()
 {
-    if (m_logcatProcess) {
-        m_logcatProcess->kill();
-        m_logcatProcess->waitForFinished(1000);
-        m_logcatProcess->deleteLater();
-        m_logcatProcess = nullptr;
+    if (m_logcatThread) {
+        // Kill the process on its own thread, then let the thread finish
+        QMetaObject::invokeMethod(m_logcatReader, &LogcatReader::stop, Qt::BlockingQueuedConnection);
+        m_logcatThread->quit();
+        m_logcatThread->wait();
+        delete m_logcatReader;
+        m_logcatReader = nullptr;
+        delete m_logcatThread;
+        m_logcatThread = nullptr;
     }
     m_logcatRunning = false;
     emit logcatStopped();
 }
 
+bool AdbManager::takeLogcatEntries(QVector<LogEntry> &entries)
+{
+    const qsizetype previousSize = entries.size();
+    QVector<LogEntry> batch;
+    while (m_logcatQueue.pop(batch)) {
+        entries.append(std::move(batch));
+    }
+    return entries.size() > previousSize;
+}
+
 bool AdbManager::isLogcatRunning() const
 {
     return m_logcatRunning;
@@ -218,71 +225,30 @@ QString AdbManager::getAdbPath() const
 
 void AdbManager::setAdbPath(const QString &path)
 {
-    m_adbPath = path;
+    if (m_adbPath != path) {
+        m_adbPath = path;
+        m_deviceTracker->start(m_adbPath, m_client);
+    }
 }
 
 void AdbManager::fetchSettings(const QString &deviceId)
 {
-    QVector<SettingEntry> settings;
-    int lineNum = 1;
-    
-    // Fetch settings from global, system, and secure namespaces
-    QStringList namespaces = {"global", "system", "secure"};
-    
-    for (const QString &ns : namespaces) {
-        QProcess process;
-        
-        process.start(m_adbPath, AdbCommand::listSettings(deviceId, ns));
-        if (!process.waitForFinished(5000)) {
-            emit errorOccurred(QString("Failed to fetch %1 settings").arg(ns));
-            continue;
-        }
-        
-        QString output = process.readAllStandardOutput();
-        QStringList lines = output.split('\n', Qt::SkipEmptyParts);
-        
-        for (const QString &line : lines) {
-            QString trimmedLine = line.trimmed();
-            if (trimmedLine.isEmpty()) continue;
-            
-            // Parse format: "setting_name=value"
-            int equalPos = trimmedLine.indexOf('=');
-            if (equalPos > 0) {
-                QString settingName = trimmedLine.left(equalPos);
-                QString value = trimmedLine.mid(equalPos + 1);
-                
-                // Truncate long values for display
-                QString displayValue = value;
-                if (displayValue.length() > 50) {
-                    displayValue = displayValue.left(47) + "...";
-                }
-                
-                SettingEntry entry;
-                entry.line = QString::number(lineNum++);
-                entry.group = ns.at(0).toUpper() + ns.mid(1); // Capitalize first letter
-                entry.setting = settingName;
-                entry.value = displayValue;
-                settings.append(entry);
-            }
-        }
-    }
-    
-    emit settingsFetched(settings);
+    // One command lists global, system, and secure; each is emitted as soon as it is parsed
+    m_settingsFetcher->start(m_client, deviceId, {"global", "system", "secure"});
 }
 
 void AdbManager::fetchProperties(const QString &deviceId)
 {
     QVector<PropertyEntry> properties;
     
-    QProcess process;
-    
-    process.start(m_adbPath, AdbCommand::listProperties(deviceId));
-    if (!process.waitForFinished(5000)) {
+    AdbClient::ShellResult result;
+    QString error;
+    if (!m_client.shell(deviceId, AdbCommand::listProperties(), result, 5000, error)) {
         emit errorOccurred("Failed to fetch system properties");
         return;
     }
     
-    QString output = process.readAllStandardOutput();
+    QString output = QString::fromUtf8(result.standardOutput);
     QStringList lines = output.split('\n', Qt::SkipEmptyParts);
     
     int lineNum = 1;
@@ -317,51 +283,104 @@ void AdbManager::fetchProperties(const QString &deviceId)
 
 bool AdbManager::setSetting(const QString &deviceId, const QString &group, const QString &setting, const QString &value, QString &error)
 {
-    QProcess process;
+    AdbClient::ShellResult result;
     QString namespace_ = group.toLower();
     
-    process.start(m_adbPath, AdbCommand::putSetting(deviceId, namespace_, setting, value));
-    if (!process.waitForFinished(5000)) {
-        error = "Timeout while setting value";
+    if (!runShell(deviceId, AdbCommand::putSetting(namespace_, setting, value), result, 5000, error)) {
         return false;
     }
+    return checkSetResult(result, error);
+}
+
+bool AdbManager::setSetting(const QString &deviceId, const QString &group, const QString &setting, const QString &value,
+                            QString &verifiedValue, QString &error)
+{
+    // Set and read back in one round trip
+    QVector<AdbClient::ShellResult> results;
+    QString namespace_ = group.toLower();
     
-    // Check for errors in stderr
-    QString errorOutput = process.readAllStandardError();
-    if (!errorOutput.isEmpty()) {
-        error = errorOutput.trimmed();
+    if (!runShellCommands(deviceId, {AdbCommand::putSetting(namespace_, setting, value),
+                                     AdbCommand::getSetting(namespace_, setting)}, results, 5000, error)) {
         return false;
     }
+    verifiedValue = QString::fromUtf8(results[1].standardOutput).trimmed();
+    return checkSetResult(results[0], error);
+}
+
+bool AdbManager::setProperty(const QString &deviceId, const QString &property, const QString &value, QString &error)
+{
+    AdbClient::ShellResult result;
     
-    // Check exit code
-    if (process.exitCode() != 0) {
-        error = QString("Command failed with exit code %1").arg(process.exitCode());
+    if (!runShell(deviceId, AdbCommand::setProperty(property, value), result, 5000, error)) {
         return false;
     }
+    return checkSetResult(result, error);
+}
+
+bool AdbManager::setProperty(const QString &deviceId, const QString &property, const QString &value,
+                             QString &verifiedValue, QString &error)
+{
+    // Set and read back in one round trip
+    QVector<AdbClient::ShellResult> results;
     
-    return true;
+    if (!runShellCommands(deviceId, {AdbCommand::setProperty(property, value),
+                                     AdbCommand::getProperty(property)}, results, 5000, error)) {
+        return false;
+    }
+    verifiedValue = QString::fromUtf8(results[1].standardOutput).trimmed();
+    return checkSetResult(results[0], error);
 }
 
-bool AdbManager::setProperty(const QString &deviceId, const QString &property, const QString &value, QString &error)
+bool AdbManager::applyChanges(const QString &deviceId, const QVector<ConfigChange> &changes,
+                              QVector<ConfigChangeResult> &results, QString &error)
 {
-    QProcess process;
+    results.clear();
+    
+    // Every change is set and then read back; the pairs are sent as one script
+    QList<QStringList> commands;
+    for (const ConfigChange &change : changes) {
+        if (change.kind == ConfigChange::Setting) {
+            const QString namespace_ = change.group.toLower();
+            commands.append(AdbCommand::putSetting(namespace_, change.name, change.value));
+            commands.append(AdbCommand::getSetting(namespace_, change.name));
+        } else {
+            commands.append(AdbCommand::setProperty(change.name, change.value));
+            commands.append(AdbCommand::getProperty(change.name));
+        }
+    }
     
-    process.start(m_adbPath, AdbCommand::setProperty(deviceId, property, value));
-    if (!process.waitForFinished(5000)) {
-        error = "Timeout while setting property";
+    QVector<AdbClient::ShellResult> shellResults;
+    const int timeoutMs = 5000 + 100 * commands.size();
+    if (!runShellCommands(deviceId, commands, shellResults, timeoutMs, error)) {
         return false;
     }
     
+    for (int i = 0; i < changes.size(); ++i) {
+        ConfigChangeResult result;
+        result.verifiedValue = QString::fromUtf8(shellResults[2 * i + 1].standardOutput).trimmed();
+        if (checkSetResult(shellResults[2 * i], result.error)) {
+            result.applied = result.verifiedValue == changes[i].value;
+            if (!result.applied) {
+                result.error = "Value not applied, it may be read-only or require special permissions";
+            }
+        }
+        results.append(result);
+    }
+    return true;
+}
+
+bool AdbManager::checkSetResult(const AdbClient::ShellResult &result, QString &error)
+{
     // Check for errors in stderr
-    QString errorOutput = process.readAllStandardError();
+    QString errorOutput = QString::fromUtf8(result.standardError);
     if (!errorOutput.isEmpty()) {
         error = errorOutput.trimmed();
         return false;
     }
     
     // Check exit code
-    if (process.exitCode() != 0) {
-        error = QString("Command failed with exit code %1").arg(process.exitCode());
+    if (result.exitCode != 0) {
+        error = QString("Command failed with exit code %1").arg(result.exitCode);
         return false;
     }
     
@@ -370,43 +389,105 @@ bool AdbManager::setProperty(const QString &deviceId, const QString &property, c
 
 QString AdbManager::verifySetting(const QString &deviceId, const QString &group, const QString &setting)
 {
-    QProcess process;
+    AdbClient::ShellResult result;
+    QString error;
     QString namespace_ = group.toLower();
     
-    process.start(m_adbPath, AdbCommand::getSetting(deviceId, namespace_, setting));
-    if (!process.waitForFinished(3000)) {
+    if (!runShell(deviceId, AdbCommand::getSetting(namespace_, setting), result, 3000, error)) {
         return QString(); // Return empty on timeout
     }
     
-    QString value = process.readAllStandardOutput().trimmed();
+    QString value = QString::fromUtf8(result.standardOutput).trimmed();
     return value;
 }
 
 QString AdbManager::verifyProperty(const QString &deviceId, const QString &property)
 {
-    QProcess process;
+    AdbClient::ShellResult result;
+    QString error;
     
-    process.start(m_adbPath, AdbCommand::getProperty(deviceId, property));
-    if (!process.waitForFinished(3000)) {
+    if (!runShell(deviceId, AdbCommand::getProperty(property), result, 3000, error)) {
         return QString(); // Return empty on timeout
     }
     
-    QString value = process.readAllStandardOutput().trimmed();
+    QString value = QString::fromUtf8(result.standardOutput).trimmed();
     return value;
 }
 
-void AdbManager::fetchPropertyDefinitions(const QString &deviceId)
+bool AdbManager::runShell(const QString &deviceId, const QStringList &arguments,
+                          AdbClient::ShellResult &result, int timeoutMs, QString &error)
 {
-    QProcess process;
-    process.start(m_adbPath, AdbCommand::getPropertyDefinitions(deviceId));
+    QVector<AdbClient::ShellResult> results;
+    if (!runShellCommands(deviceId, {arguments}, results, timeoutMs, error)) {
+        return false;
+    }
+    result = results.first();
+    return true;
+}
+
+bool AdbManager::runShellCommands(const QString &deviceId, const QList<QStringList> &commands,
+                                  QVector<AdbClient::ShellResult> &results, int timeoutMs, QString &error)
+{
+    // A broken session is dropped and reopened by the next call, commands are never sent twice
+    AdbShellSession *session = m_shellSessions.value(deviceId);
+    if (session && !session->isOpen()) {
+        m_shellSessions.remove(deviceId);
+        delete session;
+        session = nullptr;
+    }
+    if (!session) {
+        session = new AdbShellSession();
+        QString openError;
+        if (session->open(m_client, deviceId, timeoutMs, openError)) {
+            m_shellSessions.insert(deviceId, session);
+        } else {
+            delete session;
+            session = nullptr;
+        }
+    }
+    if (session) {
+        return session->run(commands, results, timeoutMs, error);
+    }
     
-    if (!process.waitForFinished(5000)) {
-        emit errorOccurred("Failed to fetch property definitions: timeout");
+    // Devices without shell v2 run every command on a connection of its own
+    results.clear();
+    for (const QStringList &arguments : commands) {
+        AdbClient::ShellResult result;
+        if (!m_client.shell(deviceId, arguments, result, timeoutMs, error)) {
+            return false;
+        }
+        results.append(result);
+    }
+    return true;
+}
+
+void AdbManager::closeShellSessions(const QList<AdbDevice> &devices)
+{
+    for (auto it = m_shellSessions.begin(); it != m_shellSessions.end(); ) {
+        bool listed = false;
+        for (const AdbDevice &device : devices) {
+            listed = listed || device.id == it.key();
+        }
+        if (listed) {
+            ++it;
+        } else {
+            delete it.value();
+            it = m_shellSessions.erase(it);
+        }
+    }
+}
+
+void AdbManager::fetchPropertyDefinitions(const QString &deviceId)
+{
+    AdbClient::ShellResult result;
+    QString error;
+    if (!m_client.shell(deviceId, AdbCommand::getPropertyDefinitions(), result, 5000, error)) {
+        emit errorOccurred(QString("Failed to fetch property definitions: %1").arg(error));
         return;
     }
     
-    QString output = process.readAllStandardOutput();
-    QString errorOutput = process.readAllStandardError();
+    QString output = QString::fromUtf8(result.standardOutput);
+    QString errorOutput = QString::fromUtf8(result.standardError);
     
     if (!errorOutput.isEmpty()) {
         qDebug() << "Property definition fetch error:" << errorOutput;
@@ -494,16 +575,13 @@ void AdbManager::fetchPropertyDefinitions(const QString &deviceId)
 
 bool AdbManager::getPropertyDefinitionValue(const QString &deviceId, const QString &propertyId, QString &value, QString &error)
 {
-    QProcess process;
-    process.start(m_adbPath, AdbCommand::getCradleProperty(deviceId, propertyId));
-    
-    if (!process.waitForFinished(3000)) {
-        error = "Command timeout";
+    AdbClient::ShellResult result;
+    if (!runShell(deviceId, AdbCommand::getCradleProperty(propertyId), result, 3000, error)) {
         return false;
     }
     
-    value = process.readAllStandardOutput().trimmed();
-    QString errorOutput = process.readAllStandardError().trimmed();
+    value = QString::fromUtf8(result.standardOutput).trimmed();
+    QString errorOutput = QString::fromUtf8(result.standardError).trimmed();
     
     if (!errorOutput.isEmpty()) {
         error = errorOutput;
@@ -515,15 +593,12 @@ bool AdbManager::getPropertyDefinitionValue(const QString &deviceId, const QStri
 
 bool AdbManager::setPropertyDefinitionValue(const QString &deviceId, const QString &propertyId, const QString &value, QString &error)
 {
-    QProcess process;
-    process.start(m_adbPath, AdbCommand::setCradleProperty(deviceId, propertyId, value));
-    
-    if (!process.waitForFinished(3000)) {
-        error = "Command timeout";
+    AdbClient::ShellResult result;
+    if (!runShell(deviceId, AdbCommand::setCradleProperty(propertyId, value), result, 3000, error)) {
         return false;
     }
     
-    QString errorOutput = process.readAllStandardError().trimmed();
+    QString errorOutput = QString::fromUtf8(result.standardError).trimmed();
     
     if (!errorOutput.isEmpty()) {
         error = errorOutput;
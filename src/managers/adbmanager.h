@@ -6,7 +6,14 @@
 #include <QStringList>
 #include <QProcess>
 #include <QTimer>
+#include <QThread>
 #include <QMap>
+#include "ilogconverter.h"
+#include "logcatreader.h"
+#include "adbdevicetracker.h"
+#include "adbclient.h"
+#include "adbshellsession.h"
+#include "adbsettingsfetcher.h"
 #include "settingsmodel.h"
 #include "propertiesmodel.h"
 #include "propertydefinition.h"
@@ -17,6 +24,22 @@ struct AdbDevice {
     bool isOnline;
 };
 
+// One setting or property to write to a device
+struct ConfigChange {
+    enum Kind { Setting, Property };
+    Kind kind;
+    QString group;   // Settings namespace, unused for properties
+    QString name;
+    QString value;
+};
+
+// Outcome of one ConfigChange
+struct ConfigChangeResult {
+    bool applied = false;   // Set without error and read back with the new value
+    QString verifiedValue;  // Value read back after setting it
+    QString error;
+};
+
 class AdbManager : public QObject
 {
     Q_OBJECT
@@ -30,9 +53,16 @@ public:
     
     // Public methods
     QList<AdbDevice> getConnectedDevices();
-    bool startLogcat(const QString &deviceId);
+    bool startLogcat(const QString &deviceId, const LogConverterPtr &converter);
     void stopLogcat();
     bool isLogcatRunning() const;
+    
+    /**
+     * Move the entries parsed by the logcat thread since the last call
+     * @param entries Receives the entries, appended in arrival order
+     * @return True if any entries were taken
+     */
+    bool takeLogcatEntries(QVector<LogEntry> &entries);
     QString getAdbPath() const;
     void setAdbPath(const QString &path);
     
@@ -41,10 +71,32 @@ public:
     void setCurrentDeviceId(const QString &deviceId);
     
     // Configuration methods
-    void fetchSettings(const QString &deviceId);
+    void fetchSettings(const QString &deviceId);  // Returns at once, settingsFetched follows per namespace
     void fetchProperties(const QString &deviceId);
     bool setSetting(const QString &deviceId, const QString &group, const QString &setting, const QString &value, QString &error);
     bool setProperty(const QString &deviceId, const QString &property, const QString &value, QString &error);
+    
+    /**
+     * Set a value and read it back in one round trip to the device
+     * @param verifiedValue Receives the value read back after setting it
+     * @return false if setting failed; error then holds the reason
+     */
+    bool setSetting(const QString &deviceId, const QString &group, const QString &setting, const QString &value,
+                    QString &verifiedValue, QString &error);
+    bool setProperty(const QString &deviceId, const QString &property, const QString &value,
+                     QString &verifiedValue, QString &error);
+    
+    /**
+     * Write several settings and properties in one batch and read every one back
+     * All commands go to the device's shell at once, so the whole batch costs
+     * one round trip instead of two per change
+     * @param changes Changes in the order they are applied
+     * @param results Receives one result per change, in the same order
+     * @param error Output parameter for errors that stopped the whole batch
+     * @return false if the batch couldn't be run; results is then empty
+     */
+    bool applyChanges(const QString &deviceId, const QVector<ConfigChange> &changes,
+                      QVector<ConfigChangeResult> &results, QString &error);
     QString verifySetting(const QString &deviceId, const QString &group, const QString &setting);
     QString verifyProperty(const QString &deviceId, const QString &property);
     
@@ -52,28 +104,45 @@ public:
     void fetchPropertyDefinitions(const QString &deviceId);
     bool getPropertyDefinitionValue(const QString &deviceId, const QString &propertyId, QString &value, QString &error);
     bool setPropertyDefinitionValue(const QString &deviceId, const QString &propertyId, const QString &value, QString &error);
-    
+
 signals:
     void devicesChanged(const QList<AdbDevice> &devices);
-    void logcatLineReceived(const QString &line);
+    void logcatEntriesAvailable();
     void logcatStarted();
     void logcatStopped();
     void errorOccurred(const QString &error);
     void settingsFetched(const QVector<SettingEntry> &settings);
     void propertiesFetched(const QVector<PropertyEntry> &properties);
     void propertyDefinitionsFetched(const QVector<PropertyDefinition> &propertyDefinitions);
-    
+
 private:
     explicit AdbManager(QObject *parent = nullptr);
     ~AdbManager();
     
-    void detectDevices();
     void parseDeviceList(const QString &output);
     QString getDeviceName(const QString &deviceId);
     
+    // Run commands in the device's shell session, opened on first use; devices without
+    // shell v2 get one connection per command
+    bool runShellCommands(const QString &deviceId, const QList<QStringList> &commands,
+                          QVector<AdbClient::ShellResult> &results, int timeoutMs, QString &error);
+    bool runShell(const QString &deviceId, const QStringList &arguments,
+                  AdbClient::ShellResult &result, int timeoutMs, QString &error);
+    
+    // Close the sessions of devices no longer listed
+    void closeShellSessions(const QList<AdbDevice> &devices);
+    
+    // Error on stderr or a non-zero exit code of a set command
+    static bool checkSetResult(const AdbClient::ShellResult &result, QString &error);
+    
     QString m_adbPath;
-    QProcess *m_logcatProcess;
-    QTimer *m_deviceDetectionTimer;
+    AdbClient m_client;           // Runs shell commands through the adb server, safe to share between threads
+    QThread *m_logcatThread;
+    LogcatReader *m_logcatReader; // Lives in m_logcatThread
+    LogBatchQueue m_logcatQueue;  // Filled by m_logcatReader, drained on the GUI thread
+    AdbDeviceTracker *m_deviceTracker;
+    AdbSettingsFetcher *m_settingsFetcher;
+    QMap<QString, AdbShellSession*> m_shellSessions; // Per device id, only used on the GUI thread
     QList<AdbDevice> m_connectedDevices;
     QString m_currentDeviceId;
     bool m_logcatRunning;
@@ -0,0 +1,268 @@
+#include "adbsettingsfetcher.h"
+#include <QTcpSocket>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+namespace {
+
+// Time allowed for the whole listing
+const int FETCH_TIMEOUT_MS = 15000;
+
+const int STATUS_SIZE = 4;
+
+// Longer values are shortened for display
+const int MAX_DISPLAY_LENGTH = 50;
+
+} // namespace
+
+AdbSettingsFetcher::AdbSettingsFetcher(QObject *parent)
+    : QObject(parent)
+    , m_socket(nullptr)
+    , m_timeoutTimer(new QTimer(this))
+    , m_state(State::Idle)
+    , m_legacyShell(false)
+    , m_namespacesDone(0)
+    , m_lineNum(1)
+{
+    m_timeoutTimer->setSingleShot(true);
+    connect(m_timeoutTimer, &QTimer::timeout, this, [this]() {
+        fail("Timeout while fetching settings");
+    });
+}
+
+AdbSettingsFetcher::~AdbSettingsFetcher()
+{
+    stop();
+}
+
+void AdbSettingsFetcher::start(const AdbClient &client, const QString &deviceId, const QStringList &namespaces)
+{
+    stop();
+    m_client = client;
+    m_deviceId = deviceId;
+    m_namespaces = namespaces;
+    m_legacyShell = false;
+    m_sentinel = "__TLP_" + QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+    m_namespacesDone = 0;
+    m_lineNum = 1;
+    m_timeoutTimer->start(FETCH_TIMEOUT_MS);
+    connectToServer();
+}
+
+void AdbSettingsFetcher::stop()
+{
+    m_timeoutTimer->stop();
+    closeSocket();
+    m_state = State::Idle;
+    m_pending.clear();
+}
+
+bool AdbSettingsFetcher::isRunning() const
+{
+    return m_state != State::Idle;
+}
+
+void AdbSettingsFetcher::connectToServer()
+{
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::connected, this, [this]() {
+        m_socket->write(AdbClient::encodeRequest("host:transport:" + m_deviceId));
+    });
+    connect(m_socket, &QTcpSocket::readyRead, this, &AdbSettingsFetcher::readReply);
+    connect(m_socket, &QTcpSocket::disconnected, this, [this]() {
+        // Output may still be waiting to be read when the shell closes
+        readReply();
+        if (m_state != State::Idle) {
+            fail("The shell closed before all settings were listed");
+        }
+    });
+    connect(m_socket, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError error) {
+        // A closing shell is handled by disconnected
+        if (error != QAbstractSocket::RemoteHostClosedError) {
+            fail(QString("Can't fetch settings from the adb server: %1").arg(m_socket->errorString()));
+        }
+    });
+    
+    m_buffer.clear();
+    m_line.clear();
+    m_pending.clear();
+    m_state = State::AwaitingTransport;
+    m_socket->connectToHost(m_client.host(), m_client.port());
+}
+
+void AdbSettingsFetcher::readReply()
+{
+    if (!m_socket) {
+        return;
+    }
+    m_buffer.append(m_socket->readAll());
+    
+    // The transport and the shell each answer with a status first
+    while (m_state == State::AwaitingTransport || m_state == State::AwaitingShell) {
+        if (!readStatus()) {
+            return;
+        }
+        if (m_state == State::AwaitingTransport) {
+            const QString service = (m_legacyShell ? "shell:" : "shell,v2,raw:") + script();
+            m_socket->write(AdbClient::encodeRequest(service));
+            m_state = State::AwaitingShell;
+        } else {
+            m_state = State::Streaming;
+        }
+    }
+    
+    if (m_legacyShell) {
+        const QByteArray data = m_buffer;
+        m_buffer.clear();
+        readOutput(data);
+        return;
+    }
+    
+    // Shell v2 packets; stderr isn't needed, the sentinels carry the exit codes
+    while (m_state == State::Streaming && m_buffer.size() >= AdbClient::SHELL_HEADER_SIZE) {
+        const quint32 length = qFromLittleEndian<quint32>(m_buffer.constData() + 1);
+        if (m_buffer.size() - AdbClient::SHELL_HEADER_SIZE < qint64(length)) {
+            break;
+        }
+        
+        const quint8 id = static_cast<quint8>(m_buffer[0]);
+        const QByteArray data = m_buffer.mid(AdbClient::SHELL_HEADER_SIZE, length);
+        m_buffer.remove(0, AdbClient::SHELL_HEADER_SIZE + length);
+        if (id == AdbClient::ShellStdout) {
+            readOutput(data);
+        } else if (id == AdbClient::ShellExit) {
+            fail("The shell exited before all settings were listed");
+        }
+    }
+}
+
+bool AdbSettingsFetcher::readStatus()
+{
+    if (m_buffer.size() < STATUS_SIZE) {
+        return false;
+    }
+    if (m_buffer.startsWith("OKAY")) {
+        m_buffer.remove(0, STATUS_SIZE);
+        return true;
+    }
+    
+    QByteArray message;
+    if (m_buffer.startsWith("FAIL")) {
+        QByteArray rest = m_buffer.mid(STATUS_SIZE);
+        if (!AdbClient::takeMessage(rest, message)) {
+            return false; // Message not complete yet
+        }
+    }
+    
+    // Older devices refuse shell v2; ask again for the plain shell
+    if (m_state == State::AwaitingShell && !m_legacyShell) {
+        closeSocket();
+        m_legacyShell = true;
+        connectToServer();
+        return false;
+    }
+    
+    fail(message.isEmpty() ? QString("Unexpected reply from the adb server")
+                           : QString::fromUtf8(message));
+    return false;
+}
+
+void AdbSettingsFetcher::readOutput(const QByteArray &data)
+{
+    m_line.append(data);
+    
+    qsizetype start = 0;
+    qsizetype end;
+    while (m_state == State::Streaming && (end = m_line.indexOf('\n', start)) >= 0) {
+        parseLine(m_line.mid(start, end - start));
+        start = end + 1;
+    }
+    m_line.remove(0, start);
+}
+
+void AdbSettingsFetcher::parseLine(const QByteArray &line)
+{
+    const QString trimmedLine = QString::fromUtf8(line).trimmed();
+    if (trimmedLine.isEmpty()) {
+        return;
+    }
+    
+    // Sentinel after a namespace: "<sentinel> <namespace> <exit code>"
+    if (line.startsWith(m_sentinel + ' ')) {
+        const QStringList fields = trimmedLine.split(' ');
+        const QString ns = fields.value(1);
+        if (fields.value(2) == "0") {
+            emit namespaceFetched(m_pending);
+        } else {
+            emit errorOccurred(QString("Failed to fetch %1 settings").arg(ns));
+        }
+        m_pending.clear();
+        
+        if (++m_namespacesDone == m_namespaces.size()) {
+            finish();
+        }
+        return;
+    }
+    
+    // Parse format: "setting_name=value"
+    int equalPos = trimmedLine.indexOf('=');
+    if (equalPos > 0 && m_namespacesDone < m_namespaces.size()) {
+        const QString &ns = m_namespaces.at(m_namespacesDone);
+        QString value = trimmedLine.mid(equalPos + 1);
+        
+        // Truncate long values for display
+        if (value.length() > MAX_DISPLAY_LENGTH) {
+            value = value.left(MAX_DISPLAY_LENGTH - 3) + "...";
+        }
+        
+        SettingEntry entry;
+        entry.line = QString::number(m_lineNum++);
+        entry.group = ns.at(0).toUpper() + ns.mid(1); // Capitalize first letter
+        entry.setting = trimmedLine.left(equalPos);
+        entry.value = value;
+        m_pending.append(entry);
+    }
+}
+
+void AdbSettingsFetcher::fail(const QString &error)
+{
+    if (m_state == State::Idle) {
+        return;
+    }
+    stop();
+    emit errorOccurred(error);
+    emit finished();
+}
+
+void AdbSettingsFetcher::finish()
+{
+    stop();
+    emit finished();
+}
+
+void AdbSettingsFetcher::closeSocket()
+{
+    if (!m_socket) {
+        return;
+    }
+    
+    // Deleted later, this may run inside one of its signals
+    disconnect(m_socket, nullptr, this, nullptr);
+    m_socket->abort();
+    m_socket->deleteLater();
+    m_socket = nullptr;
+}
+
+QString AdbSettingsFetcher::script() const
+{
+    QStringList quoted;
+    for (const QString &ns : m_namespaces) {
+        quoted.append(AdbClient::quoteArgument(ns));
+    }
+    
+    // The leading newline puts the sentinel on a line of its own
+    return QString("for ns in %1; do settings list \"$ns\" </dev/null; "
+                   "printf '\\n%s %s %d\\n' %2 \"$ns\" $?; done")
+        .arg(quoted.join(' '), QString::fromLatin1(m_sentinel));
+}
@@ -0,0 +1,88 @@
+#ifndef ADBSETTINGSFETCHER_H
+#define ADBSETTINGSFETCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include "adbclient.h"
+#include "settingentry.h"
+
+class QTimer;
+class QTcpSocket;
+
+/**
+ * Lists the settings of all namespaces with one shell command
+ * A single script runs `settings list` for every namespace and prints a
+ * sentinel line with the namespace and its exit code after each, so the device
+ * is asked once instead of once per namespace. The reply is read as signals
+ * arrive and parsed line by line; every namespace is reported as soon as its
+ * sentinel was read, the GUI thread never waits for the device
+ */
+class AdbSettingsFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AdbSettingsFetcher(QObject *parent = nullptr);
+    ~AdbSettingsFetcher() override;
+    
+    /**
+     * Start listing, cancelling a fetch that is still running
+     * @param client Address of the adb server
+     * @param deviceId Device serial
+     * @param namespaces Namespaces in the order they are listed, e.g. "global"
+     */
+    void start(const AdbClient &client, const QString &deviceId, const QStringList &namespaces);
+    
+    // Cancel without reporting anything
+    void stop();
+    
+    bool isRunning() const;
+
+signals:
+    // Settings of one namespace, sent once per namespace as it completes
+    void namespaceFetched(const QVector<SettingEntry> &settings);
+    
+    // Sent after the last namespace, or after an error ended the fetch
+    void finished();
+    
+    void errorOccurred(const QString &error);
+
+private:
+    enum class State {
+        Idle,
+        AwaitingTransport,  // host:transport sent, waiting for OKAY
+        AwaitingShell,      // Shell service sent, waiting for OKAY
+        Streaming           // Shell output arriving
+    };
+    
+    void connectToServer();
+    void readReply();
+    bool readStatus();
+    void readOutput(const QByteArray &data);
+    void parseLine(const QByteArray &line);
+    void fail(const QString &error);
+    void finish();
+    void closeSocket();
+    
+    // Shell script listing every namespace, each followed by its sentinel
+    QString script() const;
+    
+    AdbClient m_client;
+    QString m_deviceId;
+    QStringList m_namespaces;
+    QTcpSocket *m_socket;
+    QTimer *m_timeoutTimer;
+    State m_state;
+    bool m_legacyShell;               // The device refused shell v2; output comes unframed
+    QByteArray m_sentinel;            // Random per fetch, so a setting can't fake it
+    QByteArray m_buffer;              // Received but not yet decoded
+    QByteArray m_line;                // Start of a line whose end hasn't arrived
+    QVector<SettingEntry> m_pending;  // Settings of the namespace being listed
+    int m_namespacesDone;
+    int m_lineNum;                    // Continues across namespaces
+};
+
+#endif // ADBSETTINGSFETCHER_H
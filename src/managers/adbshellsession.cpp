@@ -0,0 +1,151 @@
+#include "adbshellsession.h"
+#include <QTcpSocket>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+AdbShellSession::AdbShellSession()
+    : m_socket(nullptr)
+    , m_commandCount(0)
+{}
+
+AdbShellSession::~AdbShellSession()
+{
+    close();
+}
+
+bool AdbShellSession::open(const AdbClient &client, const QString &serial, int timeoutMs, QString &errorMsg)
+{
+    close();
+    
+    // No command: the device runs an interactive shell reading its input, raw means no terminal
+    m_socket = new QTcpSocket();
+    if (!client.openDeviceService(*m_socket, serial, "shell,v2,raw:", QDeadlineTimer(timeoutMs), errorMsg)) {
+        close();
+        return false;
+    }
+    
+    m_serial = serial;
+    m_sentinelPrefix = "__TLP_" + QByteArray::number(QRandomGenerator::global()->generate64(), 16) + "_";
+    return true;
+}
+
+void AdbShellSession::close()
+{
+    if (m_socket) {
+        m_socket->abort();
+        delete m_socket;
+        m_socket = nullptr;
+    }
+    m_serial.clear();
+    m_received.clear();
+    m_stdout.clear();
+    m_stderr.clear();
+}
+
+bool AdbShellSession::isOpen() const
+{
+    return m_socket && m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+QString AdbShellSession::serial() const
+{
+    return m_serial;
+}
+
+bool AdbShellSession::run(const QList<QStringList> &commands, QVector<AdbClient::ShellResult> &results,
+                          int timeoutMs, QString &errorMsg)
+{
+    results.clear();
+    if (!isOpen()) {
+        errorMsg = "Shell session is closed";
+        return false;
+    }
+    
+    // Every command is followed by its sentinel on both streams; the leading newline
+    // puts it on a line of its own even after output without a trailing newline
+    QVector<QByteArray> sentinels;
+    QByteArray script;
+    for (const QStringList &arguments : commands) {
+        QStringList quoted;
+        for (const QString &argument : arguments) {
+            quoted.append(AdbClient::quoteArgument(argument));
+        }
+        const QByteArray sentinel = m_sentinelPrefix + QByteArray::number(++m_commandCount);
+        sentinels.append(sentinel);
+        script += quoted.join(' ').toUtf8() + " </dev/null; "
+                  + "printf '\\n%s %d\\n' " + sentinel + " $?; "
+                  + "printf '\\n%s\\n' " + sentinel + " >&2\n";
+    }
+    
+    QByteArray packet(AdbClient::SHELL_HEADER_SIZE, Qt::Uninitialized);
+    packet[0] = static_cast<char>(AdbClient::ShellStdin);
+    qToLittleEndian<quint32>(script.size(), packet.data() + 1);
+    m_socket->write(packet + script);
+    
+    const QDeadlineTimer deadline(timeoutMs);
+    for (const QByteArray &sentinel : std::as_const(sentinels)) {
+        const QByteArray outMarker = '\n' + sentinel + ' ';
+        const QByteArray errMarker = '\n' + sentinel + '\n';
+        qsizetype outPos = -1;
+        qsizetype outEnd = -1;
+        qsizetype errPos = -1;
+        for (;;) {
+            outPos = m_stdout.indexOf(outMarker);
+            outEnd = outPos < 0 ? -1 : m_stdout.indexOf('\n', outPos + outMarker.size());
+            errPos = m_stderr.indexOf(errMarker);
+            if (outEnd >= 0 && errPos >= 0) {
+                break;
+            }
+            if (!readPackets(deadline)) {
+                // The shell's position in the script is unknown now
+                errorMsg = isOpen() ? QString("Timeout while waiting for the shell on %1").arg(m_serial)
+                                    : QString("The shell on %1 exited").arg(m_serial);
+                close();
+                return false;
+            }
+        }
+        
+        AdbClient::ShellResult result;
+        const qsizetype codeStart = outPos + outMarker.size();
+        result.standardOutput = m_stdout.left(outPos);
+        result.exitCode = m_stdout.mid(codeStart, outEnd - codeStart).toInt();
+        result.standardError = m_stderr.left(errPos);
+        m_stdout.remove(0, outEnd + 1);
+        m_stderr.remove(0, errPos + errMarker.size());
+        results.append(result);
+    }
+    return true;
+}
+
+bool AdbShellSession::readPackets(const QDeadlineTimer &deadline)
+{
+    if (m_socket->bytesAvailable() == 0 && !m_socket->waitForReadyRead(deadline.remainingTime())) {
+        return false;
+    }
+    m_received.append(m_socket->readAll());
+    
+    bool exited = false;
+    while (m_received.size() >= AdbClient::SHELL_HEADER_SIZE) {
+        const quint32 length = qFromLittleEndian<quint32>(m_received.constData() + 1);
+        if (m_received.size() - AdbClient::SHELL_HEADER_SIZE < qint64(length)) {
+            break;
+        }
+        
+        const QByteArray data = m_received.mid(AdbClient::SHELL_HEADER_SIZE, length);
+        switch (static_cast<quint8>(m_received[0])) {
+        case AdbClient::ShellStdout:
+            m_stdout.append(data);
+            break;
+        case AdbClient::ShellStderr:
+            m_stderr.append(data);
+            break;
+        case AdbClient::ShellExit:
+            exited = true;
+            break;
+        default:
+            break;
+        }
+        m_received.remove(0, AdbClient::SHELL_HEADER_SIZE + length);
+    }
+    return !exited;
+}
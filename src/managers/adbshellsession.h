@@ -0,0 +1,74 @@
+#ifndef ADBSHELLSESSION_H
+#define ADBSHELLSESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QList>
+#include <QDeadlineTimer>
+#include "adbclient.h"
+
+class QTcpSocket;
+
+/**
+ * A long-lived shell on one device for short commands
+ * Starting a shell costs a round trip to the device and a process there, so the
+ * shell is kept open and commands are written to its input. Every command is
+ * followed by a unique sentinel line on stdout (carrying the exit code) and on
+ * stderr, which mark where its output ends. Several commands are written at once
+ * and their results read afterwards, e.g. a set and the read-back that verifies
+ * it. Needs shell v2 for separate stdout and stderr. Like AdbClient, calls block
+ * until done; a session must only be used by one thread at a time
+ */
+class AdbShellSession
+{
+public:
+    AdbShellSession();
+    ~AdbShellSession();
+    
+    // Delete copy constructor and assignment operator
+    AdbShellSession(const AdbShellSession&) = delete;
+    AdbShellSession& operator=(const AdbShellSession&) = delete;
+    
+    /**
+     * Start the shell
+     * @param client Address of the adb server
+     * @param serial Device serial
+     * @param timeoutMs Time allowed for connecting
+     * @param errorMsg Output parameter for error messages
+     * @return false if the device is gone or doesn't support shell v2
+     */
+    bool open(const AdbClient &client, const QString &serial, int timeoutMs, QString &errorMsg);
+    
+    void close();
+    bool isOpen() const;
+    QString serial() const;
+    
+    /**
+     * Run commands one after another in the shell
+     * All commands are sent before the first result is read. Commands get no
+     * input, so they can't consume the ones that follow
+     * @param commands Command and arguments of every command, quoted like AdbClient::shell()
+     * @param results Receives the output and exit code of every command, in order
+     * @param timeoutMs Time allowed for all commands
+     * @param errorMsg Output parameter for error messages
+     * @return false if not all results arrived; the session is then closed
+     */
+    bool run(const QList<QStringList> &commands, QVector<AdbClient::ShellResult> &results,
+             int timeoutMs, QString &errorMsg);
+
+private:
+    // Wait for data and decode the complete packets, false on timeout or exit
+    bool readPackets(const QDeadlineTimer &deadline);
+    
+    QTcpSocket *m_socket;
+    QString m_serial;
+    QByteArray m_sentinelPrefix;  // Random per session, so output can't fake a sentinel
+    quint64 m_commandCount;
+    QByteArray m_received;        // Packets not yet decoded
+    QByteArray m_stdout;          // Output not yet assigned to a command
+    QByteArray m_stderr;
+};
+
+#endif // ADBSHELLSESSION_H
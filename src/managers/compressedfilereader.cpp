@@ -0,0 +1,495 @@
+#include "compressedfilereader.h"
+#include <QtEndian>
+#include <cstring>
+
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TOOLLOGPRO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+// Compressed input is read from the file in blocks of this size
+const qint64 INPUT_BLOCK_SIZE = 256 * 1024;
+
+const quint32 ZIP_LOCAL_HEADER = 0x04034b50;
+const quint32 ZIP_CENTRAL_HEADER = 0x02014b50;
+const quint32 ZIP_END_OF_DIRECTORY = 0x06054b50;
+const qint64 ZIP_LOCAL_HEADER_SIZE = 30;
+const qint64 ZIP_CENTRAL_HEADER_SIZE = 46;
+const qint64 ZIP_END_RECORD_SIZE = 22;
+const qint64 ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+const quint16 ZIP_STORED = 0;
+const quint16 ZIP_DEFLATED = 8;
+const quint16 ZIP_ENCRYPTED_FLAG = 0x1;
+
+quint16 readLe16(const char *data)
+{
+    return qFromLittleEndian<quint16>(data);
+}
+
+quint32 readLe32(const char *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+} // namespace
+
+// Decompression state of the current format
+struct CompressedFileReader::Decoder {
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+    z_stream zlib;
+    bool zlibActive = false;
+    
+    // 15 + 16 decodes gzip members, -15 raw deflate data as found in zip entries
+    bool startZlib(int windowBits) {
+        endZlib();
+        std::memset(&zlib, 0, sizeof(zlib));
+        zlibActive = (inflateInit2(&zlib, windowBits) == Z_OK);
+        return zlibActive;
+    }
+    
+    void endZlib() {
+        if (zlibActive) {
+            inflateEnd(&zlib);
+            zlibActive = false;
+        }
+    }
+#endif
+#ifdef TOOLLOGPRO_HAVE_ZSTD
+    ZSTD_DStream *zstd = nullptr;
+    bool zstdFrameDone = false;
+#endif
+
+    ~Decoder() {
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+        endZlib();
+#endif
+#ifdef TOOLLOGPRO_HAVE_ZSTD
+        ZSTD_freeDStream(zstd);
+#endif
+    }
+};
+
+CompressedFileReader::CompressedFileReader()
+    : m_format(Format::None)
+    , m_finished(false)
+    , m_inputPos(0)
+    , m_zipEntry(-1)
+    , m_zipRemaining(0)
+    , m_zipEntryDone(false)
+    , m_lastByte('\n')
+{}
+
+CompressedFileReader::~CompressedFileReader() = default;
+
+CompressedFileReader::Format CompressedFileReader::detectFormat(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Format::None;
+    }
+    return detectFormat(QByteArrayView(file.read(4)));
+}
+
+CompressedFileReader::Format CompressedFileReader::detectFormat(QByteArrayView header)
+{
+    if (header.size() >= 2 && static_cast<uchar>(header[0]) == 0x1f && static_cast<uchar>(header[1]) == 0x8b) {
+        return Format::Gzip;
+    }
+    if (header.size() >= 4 && std::memcmp(header.data(), "\x28\xB5\x2F\xFD", 4) == 0) {
+        return Format::Zstd;
+    }
+    // Local file header, or the end record of an empty archive
+    if (header.size() >= 4 && (std::memcmp(header.data(), "PK\x03\x04", 4) == 0
+                               || std::memcmp(header.data(), "PK\x05\x06", 4) == 0)) {
+        return Format::Zip;
+    }
+    return Format::None;
+}
+
+bool CompressedFileReader::open(const QString &filePath, QString &errorMsg)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        errorMsg = QString("Failed to open file: %1").arg(m_file.errorString());
+        return false;
+    }
+    
+    m_format = detectFormat(QByteArrayView(m_file.peek(4)));
+    m_decoder.reset(new Decoder());
+    
+    switch (m_format) {
+    case Format::Gzip:
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+        if (!m_decoder->startZlib(15 + 16)) {
+            errorMsg = "Failed to initialize the gzip decoder";
+            return false;
+        }
+        return true;
+#else
+        errorMsg = "Reading gzip files needs zlib, which this build doesn't include";
+        return false;
+#endif
+    case Format::Zstd:
+#ifdef TOOLLOGPRO_HAVE_ZSTD
+        m_decoder->zstd = ZSTD_createDStream();
+        if (!m_decoder->zstd || ZSTD_isError(ZSTD_initDStream(m_decoder->zstd))) {
+            errorMsg = "Failed to initialize the zstd decoder";
+            return false;
+        }
+        return true;
+#else
+        errorMsg = "Reading zstd files needs libzstd, which this build doesn't include";
+        return false;
+#endif
+    case Format::Zip:
+        return readZipDirectory(errorMsg);
+    case Format::None:
+        break;
+    }
+    
+    errorMsg = "File is not compressed";
+    return false;
+}
+
+bool CompressedFileReader::read(QByteArray &buffer, qint64 maxBytes, QString &errorMsg)
+{
+    if (m_finished || maxBytes <= 0) {
+        return true;
+    }
+    
+    switch (m_format) {
+    case Format::Gzip:
+        return readGzip(buffer, maxBytes, errorMsg);
+    case Format::Zstd:
+        return readZstd(buffer, maxBytes, errorMsg);
+    case Format::Zip:
+        return readZip(buffer, maxBytes, errorMsg);
+    case Format::None:
+        break;
+    }
+    
+    errorMsg = "File is not compressed";
+    return false;
+}
+
+bool CompressedFileReader::atEnd() const
+{
+    return m_finished;
+}
+
+qint64 CompressedFileReader::pos() const
+{
+    return m_file.pos();
+}
+
+qint64 CompressedFileReader::size() const
+{
+    return m_file.size();
+}
+
+qint64 CompressedFileReader::fillInput(qint64 limit)
+{
+    // Keep the bytes not consumed yet, e.g. the start of the next gzip member
+    m_input.remove(0, m_inputPos);
+    m_inputPos = 0;
+    
+    const QByteArray data = m_file.read(qMin(INPUT_BLOCK_SIZE, limit));
+    m_input.append(data);
+    return data.size();
+}
+
+bool CompressedFileReader::readGzip(QByteArray &buffer, qint64 maxBytes, QString &errorMsg)
+{
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+    z_stream &zlib = m_decoder->zlib;
+    const qsizetype start = buffer.size();
+    buffer.resize(start + maxBytes);
+    zlib.next_out = reinterpret_cast<Bytef *>(buffer.data() + start);
+    zlib.avail_out = static_cast<uInt>(maxBytes);
+    
+    while (zlib.avail_out > 0 && !m_finished) {
+        if (m_inputPos == m_input.size() && fillInput(INPUT_BLOCK_SIZE) == 0) {
+            buffer.resize(start + maxBytes - zlib.avail_out);
+            errorMsg = "Unexpected end of gzip data";
+            return false;
+        }
+        
+        zlib.next_in = reinterpret_cast<Bytef *>(m_input.data() + m_inputPos);
+        zlib.avail_in = static_cast<uInt>(m_input.size() - m_inputPos);
+        const int result = inflate(&zlib, Z_NO_FLUSH);
+        m_inputPos = m_input.size() - zlib.avail_in;
+        
+        if (result == Z_STREAM_END) {
+            // Concatenated members decode as one file, anything else after a member is padding
+            if (m_input.size() - m_inputPos < 2) {
+                fillInput(INPUT_BLOCK_SIZE);
+            }
+            if (m_input.size() - m_inputPos >= 2
+                && static_cast<uchar>(m_input[m_inputPos]) == 0x1f
+                && static_cast<uchar>(m_input[m_inputPos + 1]) == 0x8b) {
+                inflateReset(&zlib);
+            } else {
+                m_finished = true;
+            }
+        } else if (result != Z_OK) {
+            buffer.resize(start + maxBytes - zlib.avail_out);
+            errorMsg = QString("Corrupt gzip data: %1").arg(zlib.msg ? zlib.msg : "unknown error");
+            return false;
+        }
+    }
+    
+    buffer.resize(start + maxBytes - zlib.avail_out);
+    return true;
+#else
+    Q_UNUSED(buffer);
+    Q_UNUSED(maxBytes);
+    errorMsg = "Reading gzip files needs zlib, which this build doesn't include";
+    return false;
+#endif
+}
+
+bool CompressedFileReader::readZstd(QByteArray &buffer, qint64 maxBytes, QString &errorMsg)
+{
+#ifdef TOOLLOGPRO_HAVE_ZSTD
+    const qsizetype start = buffer.size();
+    buffer.resize(start + maxBytes);
+    ZSTD_outBuffer output = {buffer.data() + start, static_cast<size_t>(maxBytes), 0};
+    
+    // Consecutive frames decode as one file
+    while (output.pos < output.size) {
+        const bool haveInput = m_inputPos < m_input.size() || fillInput(INPUT_BLOCK_SIZE) > 0;
+        if (!haveInput && m_decoder->zstdFrameDone) {
+            m_finished = true;
+            break;
+        }
+        
+        ZSTD_inBuffer input = {m_input.constData() + m_inputPos, static_cast<size_t>(m_input.size() - m_inputPos), 0};
+        const size_t produced = output.pos;
+        const size_t result = ZSTD_decompressStream(m_decoder->zstd, &output, &input);
+        m_inputPos += input.pos;
+        
+        if (ZSTD_isError(result)) {
+            buffer.resize(start + output.pos);
+            errorMsg = QString("Corrupt zstd data: %1").arg(ZSTD_getErrorName(result));
+            return false;
+        }
+        
+        // Without input the decoder can only flush what it buffered
+        if (!haveInput && output.pos == produced && result != 0) {
+            buffer.resize(start + output.pos);
+            errorMsg = "Unexpected end of zstd data";
+            return false;
+        }
+        m_decoder->zstdFrameDone = (result == 0);
+    }
+    
+    buffer.resize(start + output.pos);
+    return true;
+#else
+    Q_UNUSED(buffer);
+    Q_UNUSED(maxBytes);
+    errorMsg = "Reading zstd files needs libzstd, which this build doesn't include";
+    return false;
+#endif
+}
+
+bool CompressedFileReader::readZipDirectory(QString &errorMsg)
+{
+    // The end record is at the end of the archive, followed only by a comment
+    const qint64 fileSize = m_file.size();
+    const qint64 tailSize = qMin(fileSize, ZIP_END_RECORD_SIZE + ZIP_MAX_COMMENT_SIZE);
+    if (!m_file.seek(fileSize - tailSize)) {
+        errorMsg = QString("Failed to read zip file: %1").arg(m_file.errorString());
+        return false;
+    }
+    const QByteArray tail = m_file.read(tailSize);
+    
+    qsizetype endRecord = -1;
+    for (qsizetype i = tail.size() - ZIP_END_RECORD_SIZE; i >= 0; --i) {
+        if (readLe32(tail.constData() + i) == ZIP_END_OF_DIRECTORY) {
+            endRecord = i;
+            break;
+        }
+    }
+    if (endRecord < 0) {
+        errorMsg = "Corrupt zip file: central directory not found";
+        return false;
+    }
+    
+    const char *record = tail.constData() + endRecord;
+    const quint16 entryCount = readLe16(record + 10);
+    const quint32 directorySize = readLe32(record + 12);
+    const quint32 directoryOffset = readLe32(record + 16);
+    if (entryCount == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+        errorMsg = "ZIP64 archives are not supported";
+        return false;
+    }
+    
+    if (!m_file.seek(directoryOffset)) {
+        errorMsg = "Corrupt zip file: bad central directory offset";
+        return false;
+    }
+    const QByteArray directory = m_file.read(directorySize);
+    
+    qsizetype pos = 0;
+    for (int i = 0; i < entryCount; ++i) {
+        if (directory.size() - pos < ZIP_CENTRAL_HEADER_SIZE
+            || readLe32(directory.constData() + pos) != ZIP_CENTRAL_HEADER) {
+            errorMsg = "Corrupt zip file: bad central directory entry";
+            return false;
+        }
+        
+        const char *header = directory.constData() + pos;
+        const quint16 flags = readLe16(header + 8);
+        const quint16 method = readLe16(header + 10);
+        const quint32 compressedSize = readLe32(header + 20);
+        const quint16 nameLength = readLe16(header + 28);
+        const quint32 headerOffset = readLe32(header + 42);
+        const QString name = QString::fromUtf8(header + ZIP_CENTRAL_HEADER_SIZE,
+                                               qMin<qsizetype>(nameLength, directory.size() - pos - ZIP_CENTRAL_HEADER_SIZE));
+        pos += ZIP_CENTRAL_HEADER_SIZE + nameLength + readLe16(header + 30) + readLe16(header + 32);
+        
+        // Directories have no contents
+        if (name.endsWith('/')) {
+            continue;
+        }
+        
+        if (flags & ZIP_ENCRYPTED_FLAG) {
+            errorMsg = QString("Encrypted zip entries are not supported: %1").arg(name);
+            return false;
+        }
+        if (compressedSize == 0xFFFFFFFF || headerOffset == 0xFFFFFFFF) {
+            errorMsg = "ZIP64 archives are not supported";
+            return false;
+        }
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+        const bool supported = (method == ZIP_STORED || method == ZIP_DEFLATED);
+#else
+        const bool supported = (method == ZIP_STORED);
+#endif
+        if (!supported) {
+            errorMsg = QString("Unsupported zip compression method %1: %2").arg(method).arg(name);
+            return false;
+        }
+        
+        m_zipEntries.append({headerOffset, compressedSize, method});
+    }
+    
+    m_zipEntry = -1;
+    m_zipEntryDone = true;
+    return true;
+}
+
+bool CompressedFileReader::startZipEntry(QString &errorMsg)
+{
+    const ZipEntry &entry = m_zipEntries[m_zipEntry];
+    
+    // The local header repeats the name and may have a different extra field
+    char header[ZIP_LOCAL_HEADER_SIZE];
+    if (!m_file.seek(entry.headerOffset)
+        || m_file.read(header, ZIP_LOCAL_HEADER_SIZE) != ZIP_LOCAL_HEADER_SIZE
+        || readLe32(header) != ZIP_LOCAL_HEADER) {
+        errorMsg = "Corrupt zip file: bad local file header";
+        return false;
+    }
+    
+    const qint64 dataOffset = entry.headerOffset + ZIP_LOCAL_HEADER_SIZE
+                              + readLe16(header + 26) + readLe16(header + 28);
+    if (!m_file.seek(dataOffset)) {
+        errorMsg = "Corrupt zip file: bad entry offset";
+        return false;
+    }
+    
+    m_input.clear();
+    m_inputPos = 0;
+    m_zipRemaining = entry.compressedSize;
+    m_zipEntryDone = (entry.method == ZIP_STORED && entry.compressedSize == 0);
+
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+    if (entry.method == ZIP_DEFLATED && !m_decoder->startZlib(-15)) {
+        errorMsg = "Failed to initialize the deflate decoder";
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool CompressedFileReader::readZip(QByteArray &buffer, qint64 maxBytes, QString &errorMsg)
+{
+    const qsizetype start = buffer.size();
+    
+    while (!m_finished && buffer.size() - start < maxBytes) {
+        if (m_zipEntryDone) {
+            // Keep the last line of one entry apart from the first line of the next
+            if (m_lastByte != '\n') {
+                buffer.append('\n');
+                m_lastByte = '\n';
+            }
+            if (++m_zipEntry >= m_zipEntries.size()) {
+                m_finished = true;
+                break;
+            }
+            if (!startZipEntry(errorMsg)) {
+                return false;
+            }
+            continue;
+        }
+        
+        const qint64 space = maxBytes - (buffer.size() - start);
+        const qsizetype before = buffer.size();
+        
+        if (m_zipEntries[m_zipEntry].method == ZIP_STORED) {
+            const QByteArray data = m_file.read(qMin(space, m_zipRemaining));
+            if (data.isEmpty()) {
+                errorMsg = "Unexpected end of zip data";
+                return false;
+            }
+            buffer.append(data);
+            m_zipRemaining -= data.size();
+            m_zipEntryDone = (m_zipRemaining == 0);
+        } else {
+#ifdef TOOLLOGPRO_HAVE_ZLIB
+            z_stream &zlib = m_decoder->zlib;
+            buffer.resize(before + space);
+            zlib.next_out = reinterpret_cast<Bytef *>(buffer.data() + before);
+            zlib.avail_out = static_cast<uInt>(space);
+            
+            while (zlib.avail_out > 0 && !m_zipEntryDone) {
+                if (m_inputPos == m_input.size()) {
+                    // Never read past the entry, the next one starts with its own header
+                    const qint64 read = fillInput(m_zipRemaining);
+                    m_zipRemaining -= read;
+                    if (read == 0) {
+                        buffer.resize(before + space - zlib.avail_out);
+                        errorMsg = "Unexpected end of zip data";
+                        return false;
+                    }
+                }
+                
+                zlib.next_in = reinterpret_cast<Bytef *>(m_input.data() + m_inputPos);
+                zlib.avail_in = static_cast<uInt>(m_input.size() - m_inputPos);
+                const int result = inflate(&zlib, Z_NO_FLUSH);
+                m_inputPos = m_input.size() - zlib.avail_in;
+                
+                if (result == Z_STREAM_END) {
+                    m_zipEntryDone = true;
+                } else if (result != Z_OK) {
+                    buffer.resize(before + space - zlib.avail_out);
+                    errorMsg = QString("Corrupt zip data: %1").arg(zlib.msg ? zlib.msg : "unknown error");
+                    return false;
+                }
+            }
+            buffer.resize(before + space - zlib.avail_out);
+#endif
+        }
+        
+        if (buffer.size() > before) {
+            m_lastByte = buffer.back();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef COMPRESSEDFILEREADER_H
+#define COMPRESSEDFILEREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QScopedPointer>
+
+/**
+ * Streaming reader for compressed log files
+ * Decompresses gzip (including multi-member files), zstd and zip archives in
+ * blocks, so compressed logs can be parsed without a temporary file. Zip
+ * entries are read one after another as if they were a single file. gzip and
+ * deflated zip entries need zlib, zstd needs libzstd; builds without them
+ * report an error for those formats
+ */
+class CompressedFileReader
+{
+public:
+    enum class Format {
+        None,
+        Gzip,
+        Zstd,
+        Zip
+    };
+    
+    CompressedFileReader();
+    ~CompressedFileReader();
+    
+    // Delete copy constructor and assignment operator
+    CompressedFileReader(const CompressedFileReader&) = delete;
+    CompressedFileReader& operator=(const CompressedFileReader&) = delete;
+    
+    /**
+     * Detect the compression of a file from its magic bytes
+     * @param filePath Path to the file
+     * @return Format::None for uncompressed or unreadable files
+     */
+    static Format detectFormat(const QString &filePath);
+    static Format detectFormat(QByteArrayView header);
+    
+    /**
+     * Open a compressed file for reading
+     * @param filePath Path to the file
+     * @param errorMsg Output parameter for error messages
+     * @return false if the file can't be read or its format isn't supported
+     */
+    bool open(const QString &filePath, QString &errorMsg);
+    
+    /**
+     * Decompress the next block
+     * @param buffer Receives up to maxBytes of decompressed data, appended
+     * @param maxBytes Maximum number of bytes to append
+     * @param errorMsg Output parameter for error messages
+     * @return false if the data is corrupt or truncated
+     */
+    bool read(QByteArray &buffer, qint64 maxBytes, QString &errorMsg);
+    
+    bool atEnd() const;
+    
+    // Compressed bytes consumed so far and in total, for progress reporting
+    qint64 pos() const;
+    qint64 size() const;
+
+private:
+    // Member of a zip archive
+    struct ZipEntry {
+        qint64 headerOffset;
+        qint64 compressedSize;
+        quint16 method;
+    };
+    
+    struct Decoder;
+    
+    bool readZipDirectory(QString &errorMsg);
+    bool startZipEntry(QString &errorMsg);
+    qint64 fillInput(qint64 limit);
+    bool readGzip(QByteArray &buffer, qint64 maxBytes, QString &errorMsg);
+    bool readZstd(QByteArray &buffer, qint64 maxBytes, QString &errorMsg);
+    bool readZip(QByteArray &buffer, qint64 maxBytes, QString &errorMsg);
+    
+    QFile m_file;
+    Format m_format;
+    bool m_finished;
+    QByteArray m_input;            // Compressed bytes read from the file
+    qsizetype m_inputPos;          // First byte of m_input not yet consumed
+    QScopedPointer<Decoder> m_decoder;
+    
+    QVector<ZipEntry> m_zipEntries;
+    qsizetype m_zipEntry;          // Entry being read, -1 before the first
+    qint64 m_zipRemaining;         // Compressed bytes left in the current entry
+    bool m_zipEntryDone;
+    char m_lastByte;               // Last byte delivered, to keep zip entries on separate lines
+};
+
+#endif // COMPRESSEDFILEREADER_H
@@ -0,0 +1,283 @@
+#include "fileloader.h"
+#include "filemanager.h"
+#include "filetailreader.h"
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+FileLoader::FileLoader(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+    , m_loading(false)
+    , m_followThread(nullptr)
+    , m_tailReader(nullptr)
+    , m_mode(LoadMode::Parse)
+{}
+
+FileLoader::~FileLoader()
+{
+    stopFollowing();
+    cancel();
+    m_future.waitForFinished();
+}
+
+void FileLoader::start(const QString &filePath, const QVector<LogConverterPtr> &converters)
+{
+    startLoad(QStringList(filePath), converters, LoadMode::Parse);
+}
+
+void FileLoader::startIndexed(const QString &filePath, const QVector<LogConverterPtr> &converters)
+{
+    startLoad(QStringList(filePath), converters, LoadMode::Index);
+}
+
+void FileLoader::startMerged(const QStringList &filePaths, const QVector<LogConverterPtr> &converters)
+{
+    startLoad(filePaths, converters, LoadMode::Merge);
+}
+
+void FileLoader::startSession(const QString &filePath)
+{
+    startLoad(QStringList(filePath), QVector<LogConverterPtr>(), LoadMode::Session);
+}
+
+void FileLoader::startLoad(const QStringList &filePaths, const QVector<LogConverterPtr> &converters, LoadMode mode)
+{
+    // Only one load at a time, so the queue keeps a single producer
+    stopFollowing();
+    cancel();
+    m_future.waitForFinished();
+    discardEntries();
+    
+    const int generation = ++m_generation;
+    m_cancelled.storeRelaxed(0);
+    m_loading = true;
+    m_filePath = filePaths.join(", ");
+    m_converters = converters;
+    m_mode = mode;
+    m_result = Result();
+    
+    // Created here so the index and its file belong to this thread
+    QSharedPointer<LogFileIndex> index;
+    if (mode == LoadMode::Index) {
+        index.reset(new LogFileIndex());
+    }
+    
+    m_future = QtConcurrent::run([this, filePaths, converters, mode, generation, index]() {
+        // Results stay with the worker until they are handed to the loader's thread
+        FileManager fileManager;
+        Result result;
+        
+        const FileManager::LogBatchHandler onBatch =
+            [this, generation, &result](QVector<LogEntry> &batch, qint64 bytesRead, qint64 totalBytes) {
+                result.loadedBytes = totalBytes;
+                if (!batch.isEmpty()) {
+                    m_queue.push({generation, std::move(batch)});
+                }
+                
+                // Notify on the loader's thread, ignoring loads that were replaced meanwhile
+                QMetaObject::invokeMethod(this, [this, generation, bytesRead, totalBytes]() {
+                    if (generation == m_generation) {
+                        emit entriesAvailable();
+                        emit progressChanged(bytesRead, totalBytes);
+                    }
+                }, Qt::QueuedConnection);
+            };
+        
+        bool success = false;
+        switch (mode) {
+        case LoadMode::Parse:
+            success = fileManager.readFromFileAuto(filePaths.first(), converters, result.usedConverter,
+                                                   onBatch, &m_cancelled, result.errorString);
+            break;
+        case LoadMode::Index:
+            success = fileManager.indexFileAuto(filePaths.first(), converters, result.usedConverter, *index,
+                                                onBatch, &m_cancelled, result.errorString);
+            break;
+        case LoadMode::Merge:
+            success = fileManager.mergeFilesAuto(filePaths, converters, result.usedConverter,
+                                                 onBatch, &m_cancelled, result.errorString);
+            break;
+        case LoadMode::Session:
+            success = fileManager.readSession(filePaths.first(), onBatch, &m_cancelled,
+                                              result.sessionState, result.errorString);
+            break;
+        }
+        
+        result.lineCount = fileManager.getLastLineCount();
+        result.parsedCount = fileManager.getLastParsedCount();
+        if (success && index) {
+            result.index = index;
+        }
+        
+        QMetaObject::invokeMethod(this, [this, generation, success, result]() {
+            if (generation == m_generation) {
+                m_result = result;
+                m_loading = false;
+                emit finished(success);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileLoader::cancel()
+{
+    // Pending notifications and results of the old load are dropped by the generation check
+    ++m_generation;
+    m_cancelled.storeRelaxed(1);
+    m_loading = false;
+}
+
+bool FileLoader::isLoading() const
+{
+    return m_loading;
+}
+
+bool FileLoader::startFollowing(QString &errorMsg)
+{
+    stopFollowing();
+    
+    // Results arrive with finished()
+    if (m_loading) {
+        errorMsg = "The file is still loading";
+        return false;
+    }
+    if (m_mode == LoadMode::Session) {
+        errorMsg = "Sessions can't be followed";
+        return false;
+    }
+    
+    if (m_filePath.isEmpty() || !m_result.usedConverter) {
+        errorMsg = "No completely loaded file to follow";
+        return false;
+    }
+    
+    // Appended lines are added to the loaded entries, an index only covers the file it was built for
+    if (m_mode == LoadMode::Index) {
+        errorMsg = "Indexed files can't be followed";
+        return false;
+    }
+    
+    if (m_mode == LoadMode::Merge) {
+        errorMsg = "Merged files can't be followed";
+        return false;
+    }
+    
+    if (FileManager::isCompressed(m_filePath)) {
+        errorMsg = "Compressed files can't be followed";
+        return false;
+    }
+    
+    // The detected format first, the reader's thread gets converters of its own
+    QVector<LogConverterPtr> converters;
+    converters.append(m_result.usedConverter->clone());
+    for (const LogConverterPtr &converter : std::as_const(m_converters)) {
+        if (converter != m_result.usedConverter) {
+            converters.append(converter->clone());
+        }
+    }
+    
+    m_followThread = new QThread(this);
+    m_tailReader = new FileTailReader(m_filePath, m_result.loadedBytes, converters, &m_followQueue);
+    m_tailReader->moveToThread(m_followThread);
+    
+    connect(m_tailReader, &FileTailReader::entriesAvailable, this, &FileLoader::entriesAvailable);
+    connect(m_tailReader, &FileTailReader::restarted, this, &FileLoader::followRestarted);
+    
+    m_followThread->start();
+    
+    bool started = false;
+    QMetaObject::invokeMethod(m_tailReader, &FileTailReader::start,
+                              Qt::BlockingQueuedConnection, &started);
+    if (!started) {
+        stopFollowing();
+        errorMsg = QString("Failed to open %1").arg(m_filePath);
+        return false;
+    }
+    return true;
+}
+
+void FileLoader::stopFollowing()
+{
+    if (m_followThread) {
+        // Close the file and its watcher on their own thread, then let the thread finish
+        QMetaObject::invokeMethod(m_tailReader, &FileTailReader::stop, Qt::BlockingQueuedConnection);
+        m_followThread->quit();
+        m_followThread->wait();
+        delete m_tailReader;
+        m_tailReader = nullptr;
+        delete m_followThread;
+        m_followThread = nullptr;
+    }
+    
+    QVector<LogEntry> batch;
+    while (m_followQueue.pop(batch)) {
+    }
+}
+
+bool FileLoader::isFollowing() const
+{
+    return m_followThread != nullptr;
+}
+
+bool FileLoader::takeEntries(QVector<LogEntry> &entries)
+{
+    const qsizetype previousSize = entries.size();
+    Batch batch;
+    while (m_queue.pop(batch)) {
+        // Drop what a cancelled load queued before it noticed
+        if (batch.generation == m_generation) {
+            entries.append(std::move(batch.entries));
+        }
+    }
+    
+    // Lines appended to a followed file come after everything it was loaded with
+    QVector<LogEntry> appended;
+    while (m_followQueue.pop(appended)) {
+        entries.append(std::move(appended));
+    }
+    return entries.size() > previousSize;
+}
+
+QSharedPointer<LogFileIndex> FileLoader::takeIndex()
+{
+    QSharedPointer<LogFileIndex> index;
+    index.swap(m_result.index);
+    return index;
+}
+
+void FileLoader::discardEntries()
+{
+    Batch batch;
+    while (m_queue.pop(batch)) {
+    }
+}
+
+QString FileLoader::filePath() const
+{
+    return m_filePath;
+}
+
+LogConverterPtr FileLoader::usedConverter() const
+{
+    return m_result.usedConverter;
+}
+
+QString FileLoader::errorString() const
+{
+    return m_result.errorString;
+}
+
+int FileLoader::lineCount() const
+{
+    return m_result.lineCount;
+}
+
+int FileLoader::parsedCount() const
+{
+    return m_result.parsedCount;
+}
+
+const SessionState *FileLoader::sessionState() const
+{
+    return m_mode == LoadMode::Session ? &m_result.sessionState : nullptr;
+}
@@ -0,0 +1,157 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QSharedPointer>
+#include "ilogconverter.h"
+#include "spscqueue.h"
+#include "logfileindex.h"
+#include "logcatreader.h"
+#include "logsession.h"
+
+class QThread;
+class FileTailReader;
+
+/**
+ * Loads a log file on a background thread
+ * Parsed batches are queued for the GUI thread as soon as they are ready, so
+ * the first rows can be shown while the rest of the file is still being read.
+ * Large files can be indexed instead, leaving the entries to be parsed on demand.
+ * A loaded file can then be followed as it grows, see FileTailReader. Session
+ * files are read without parsing and restore their marks and filters.
+ * Signals are only emitted on the thread that owns the loader and never for a
+ * load that was cancelled or replaced
+ */
+class FileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileLoader(QObject *parent = nullptr);
+    ~FileLoader() override;
+    
+    /**
+     * Start loading a file, cancelling the current load if there is one
+     * @param filePath Path to the log file
+     * @param converters Converters to detect the format with
+     */
+    void start(const QString &filePath, const QVector<LogConverterPtr> &converters);
+    
+    /**
+     * Start indexing a file for on-demand parsing, cancelling the current load if there is one
+     * No entries are queued; the index is available from takeIndex() once finished
+     * @param filePath Path to the log file
+     * @param converters Converters to detect the format with
+     */
+    void startIndexed(const QString &filePath, const QVector<LogConverterPtr> &converters);
+    
+    /**
+     * Start merging several files into one timeline, cancelling the current load if there is one
+     * Entries are queued in timestamp order once all files are parsed, see FileManager::mergeFilesAuto()
+     * @param filePaths Files to merge
+     * @param converters Converters to detect the formats with
+     */
+    void startMerged(const QStringList &filePaths, const QVector<LogConverterPtr> &converters);
+    
+    /**
+     * Start reading a session file, cancelling the current load if there is one
+     * The saved marks and filter inputs are available from sessionState() once finished
+     * @param filePath Path to the session file
+     */
+    void startSession(const QString &filePath);
+    
+    // Stop the current load, entries not yet taken are discarded
+    void cancel();
+    
+    bool isLoading() const;
+    
+    /**
+     * Follow the last loaded file, queueing the entries appended after the load
+     * Call once finished() was emitted; stopped by the next load
+     * @param errorMsg Output parameter for error messages
+     * @return false if there is no completely loaded file that can be followed
+     */
+    bool startFollowing(QString &errorMsg);
+    
+    // Stop following, entries not yet taken are discarded
+    void stopFollowing();
+    
+    bool isFollowing() const;
+    
+    /**
+     * Move the entries parsed since the last call
+     * @param entries Receives the entries, appended in file order
+     * @return True if any entries were taken
+     */
+    bool takeEntries(QVector<LogEntry> &entries);
+    
+    // Index built by the last successful startIndexed(), null otherwise
+    QSharedPointer<LogFileIndex> takeIndex();
+    
+    // Results of the last load, valid once finished() was emitted
+    QString filePath() const;      // Comma-separated for merged files
+    LogConverterPtr usedConverter() const;
+    QString errorString() const;
+    int lineCount() const;
+    int parsedCount() const;
+    const SessionState *sessionState() const;  // Null unless the last load read a session
+
+signals:
+    void entriesAvailable();
+    void progressChanged(qint64 bytesRead, qint64 totalBytes);
+    void finished(bool success);
+    
+    // The followed file was truncated or rotated and is followed from its start
+    void followRestarted(const QString &reason);
+
+private:
+    // Entries parsed by one load
+    struct Batch {
+        int generation = 0;
+        QVector<LogEntry> entries;
+    };
+    
+    enum class LoadMode {
+        Parse,
+        Index,
+        Merge,
+        Session
+    };
+    
+    // Filled by the worker and handed to the loader's thread with finished()
+    struct Result {
+        LogConverterPtr usedConverter;
+        QString errorString;
+        int lineCount = 0;
+        int parsedCount = 0;
+        qint64 loadedBytes = 0;    // Size of the file when it was read
+        QSharedPointer<LogFileIndex> index;
+        SessionState sessionState;
+    };
+    
+    void startLoad(const QStringList &filePaths, const QVector<LogConverterPtr> &converters, LoadMode mode);
+    void discardEntries();
+    
+    QFuture<void> m_future;
+    QAtomicInt m_cancelled;
+    int m_generation;              // Identifies the current load, bumped on start and cancel
+    bool m_loading;                // A load was started and its results haven't arrived yet
+    SpscQueue<Batch> m_queue;      // A cancelled load may still push a batch before it stops
+    QVector<LogConverterPtr> m_converters;
+    
+    QThread *m_followThread;
+    FileTailReader *m_tailReader;  // Lives in m_followThread
+    LogBatchQueue m_followQueue;   // Filled by m_tailReader
+    
+    // Set when a load starts; the results of the last load, only touched on the loader's thread
+    QString m_filePath;
+    LoadMode m_mode;
+    Result m_result;
+};
+
+#endif // FILELOADER_H
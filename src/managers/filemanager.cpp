@@ -1,8 +1,493 @@
 #include "filemanager.h"
+#include "logfileindex.h"
+#include "logcache.h"
+#include "compressedfilereader.h"
+#include "logsession.h"
 #include <QFile>
-#include <QTextStream>
+#include <QStringEncoder>
+#include <QHash>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QThread>
+#include <QPair>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <cstring>
+
+namespace {
+
+// Files are parsed in newline-aligned chunks of about this size; the first one is
+// small so the first rows are delivered quickly
+const qint64 FIRST_CHUNK_SIZE = 64 * 1024;
+const qint64 CHUNK_SIZE = 1024 * 1024;
+
+// Parsing checks for cancellation every this many lines
+const int CANCEL_CHECK_LINES = 4096;
+
+// Saved files are written in blocks of this size
+const qsizetype SAVE_BLOCK_SIZE = 4 * 1024 * 1024;
+
+// Entries requested from the source of a save at a time
+const qsizetype SAVE_CHUNK_ENTRIES = 65536;
+
+// Merged entries are delivered in batches of this size
+const qsizetype MERGE_BATCH_SIZE = 64 * 1024;
+
+// Lines of every merged file that are parsed ahead of the merge
+const qsizetype MERGE_CHUNK_LINES = 16 * 1024;
+
+// Format detection reads up to this many lines from the head, middle and tail
+const qint64 SAMPLE_REGION_BYTES = 64 * 1024;
+const int SAMPLE_REGION_LINES = 64;
+
+// Chunks parsed at the same time
+int parseSlotCount()
+{
+    return qMax(1, QThread::idealThreadCount() * 2);
+}
+
+bool isSkippedLine(QByteArrayView trimmedLine)
+{
+    // Empty lines and logcat header lines (e.g., "--------- beginning of system")
+    return trimmedLine.isEmpty() || trimmedLine.startsWith("---------");
+}
+
+// Newline-aligned byte range of a file and the results of parsing it
+struct ParseChunk {
+    qint64 begin;
+    qint64 end;
+    QVector<LogConverterPtr> converters; // Preferred format first
+    bool indexOnly = false;              // Record lines instead of parsing them
+    QVector<LogEntry> logs;
+    QVector<LogFileIndex::LineInfo> lines;
+    int lineCount = 0;
+    int parsedCount = 0;
+};
+
+void parseLines(const char *data, ParseChunk &chunk, const QAtomicInt *cancelled)
+{
+    int current = 0; // Converter that parsed the previous line
+    qint64 pos = chunk.begin;
+    while (pos < chunk.end) {
+        if (cancelled && chunk.lineCount % CANCEL_CHECK_LINES == 0 && cancelled->loadRelaxed()) {
+            return;
+        }
+        
+        const char *lineStart = data + pos;
+        const char *lineEnd = static_cast<const char *>(std::memchr(lineStart, '\n', chunk.end - pos));
+        qint64 lineLength = lineEnd ? lineEnd - lineStart : chunk.end - pos;
+        pos += lineLength + 1;
+        chunk.lineCount++;
+        
+        // Drop the CR of CRLF line endings
+        if (lineLength > 0 && lineStart[lineLength - 1] == '\r') {
+            lineLength--;
+        }
+        
+        const QByteArrayView line(lineStart, lineLength);
+        if (isSkippedLine(line.trimmed())) {
+            continue;
+        }
+        
+        // Try to parse the line, converters read the bytes without decoding the whole line;
+        // an index only needs the level and timestamp
+        LogEntry entry;
+        auto parse = [&chunk, &entry, line](int converter) {
+            if (chunk.indexOnly) {
+                return chunk.converters[converter]->scanUtf8(line, entry.level, entry.timestamp);
+            }
+            entry = chunk.converters[converter]->convertUtf8(line);
+            return entry.isValid();
+        };
+        bool parsed = parse(current);
+        
+        // Mixed files: try the other formats and keep using whichever matched
+        for (int i = 0; !parsed && i < chunk.converters.size(); ++i) {
+            if (i != current && parse(i)) {
+                parsed = true;
+                current = i;
+            }
+        }
+        
+        if (!parsed) {
+            continue;
+        }
+        chunk.parsedCount++;
+        if (chunk.indexOnly) {
+            chunk.lines.append({lineStart - data, entry.timestamp, entry.level, static_cast<quint8>(current)});
+        } else {
+            chunk.logs.append(std::move(entry));
+        }
+    }
+}
+
+// Split [begin, end) of data at line boundaries and parse the chunks in waves,
+// handing each wave to deliver in file order before the next one is parsed.
+// slotConverters keeps the converters of every parallel slot between calls,
+// slot 0 uses the given ones. Returns false if cancelled
+bool parseInWaves(const char *data,
+                  qint64 begin,
+                  qint64 end,
+                  bool smallFirstChunk,
+                  const QVector<LogConverterPtr> &converters,
+                  QVector<QVector<LogConverterPtr>> &slotConverters,
+                  bool indexOnly,
+                  const QAtomicInt *cancelled,
+                  const std::function<void(ParseChunk &)> &deliver)
+{
+    QVector<QPair<qint64, qint64>> ranges;
+    qint64 pos = begin;
+    while (pos < end) {
+        const qint64 size = (smallFirstChunk && ranges.isEmpty()) ? FIRST_CHUNK_SIZE : CHUNK_SIZE;
+        qint64 rangeEnd = end;
+        if (end - pos > size) {
+            // End the chunk just after the first newline past its nominal size
+            const char *newline = static_cast<const char *>(
+                std::memchr(data + pos + size, '\n', end - pos - size));
+            if (newline) {
+                rangeEnd = newline - data + 1;
+            }
+        }
+        ranges.append(qMakePair(pos, rangeEnd));
+        pos = rangeEnd;
+    }
+    
+    if (slotConverters.isEmpty()) {
+        slotConverters.append(converters);
+    }
+    
+    qsizetype next = 0;
+    while (next < ranges.size()) {
+        const qsizetype waveSize = (smallFirstChunk && next == 0)
+            ? 1 : qMin<qsizetype>(parseSlotCount(), ranges.size() - next);
+        
+        QVector<ParseChunk> wave(waveSize);
+        for (qsizetype i = 0; i < waveSize; ++i) {
+            while (slotConverters.size() <= i) {
+                QVector<LogConverterPtr> clones;
+                for (const LogConverterPtr &converter : converters) {
+                    clones.append(converter->clone());
+                }
+                slotConverters.append(clones);
+            }
+            wave[i].begin = ranges[next + i].first;
+            wave[i].end = ranges[next + i].second;
+            wave[i].converters = slotConverters[i];
+            wave[i].indexOnly = indexOnly;
+        }
+        
+        // Read and parse lines, every chunk with its own converters
+        if (wave.size() == 1) {
+            parseLines(data, wave.first(), cancelled);
+        } else {
+            QtConcurrent::blockingMap(wave, [data, cancelled](ParseChunk &chunk) {
+                parseLines(data, chunk, cancelled);
+            });
+        }
+        
+        if (cancelled && cancelled->loadRelaxed()) {
+            return false;
+        }
+        
+        for (ParseChunk &chunk : wave) {
+            deliver(chunk);
+        }
+        next += waveSize;
+    }
+    return true;
+}
+
+// One file being merged: its lines are indexed, ordered by timestamp through the
+// index, and parsed a chunk at a time as the merge reaches them
+struct MergeRun {
+    QString filePath;
+    quint32 sourceId = 0;
+    QVector<LogConverterPtr> converters;
+    LogConverterPtr usedConverter;
+    QScopedPointer<QTemporaryFile> decompressed; // Plain copy of a compressed file
+    LogFileIndex index;
+    QVector<LogConverterPtr> lineConverters;     // Clones for parsing lines of the index
+    QVector<qint64> keys;      // Merge key of every line
+    QVector<qsizetype> order;  // Lines in timestamp order, empty if the file already is
+    qsizetype position = 0;    // Place in the timestamp order of the next merged entry
+    QVector<LogEntry> logs;    // Parsed entries from position on
+    qsizetype logPosition = 0; // Entry of logs at position
+    QString errorMsg;
+    int lineCount = 0;
+    int parsedCount = 0;
+    bool ok = false;
+    
+    qsizetype lineAt(qsizetype i) const { return order.isEmpty() ? i : order[i]; }
+};
+
+// Put a run in timestamp order; entries without a timestamp (brief format) take the
+// key of the entry before them, so the stable sort keeps them right after it. Those
+// at the start of a file have the lowest key. Only the line numbers are sorted
+void sortRun(MergeRun &run)
+{
+    const QVector<qint64> &timestamps = run.index.timestamps();
+    run.keys.resize(timestamps.size());
+    qint64 previous = LogEntry::NoTimestamp;
+    for (qsizetype i = 0; i < timestamps.size(); ++i) {
+        if (timestamps[i] != LogEntry::NoTimestamp) {
+            previous = timestamps[i];
+        }
+        run.keys[i] = previous;
+    }
+    
+    // A single buffer is already in order; files with several buffers are nearly so
+    if (std::is_sorted(run.keys.cbegin(), run.keys.cend())) {
+        return;
+    }
+    
+    run.order.resize(run.keys.size());
+    std::iota(run.order.begin(), run.order.end(), 0);
+    std::stable_sort(run.order.begin(), run.order.end(), [&run](qsizetype a, qsizetype b) {
+        return run.keys[a] < run.keys[b];
+    });
+}
+
+// Parse the next chunk of a run in timestamp order
+void fillRun(MergeRun &run)
+{
+    const qsizetype count = qMin(MERGE_CHUNK_LINES, run.keys.size() - run.position);
+    if (run.order.isEmpty()) {
+        run.logs = run.index.parseLines(run.position, count);
+    } else {
+        run.logs.clear();
+        run.logs.reserve(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            run.logs.append(run.index.parseLine(run.order[run.position + i], run.lineConverters));
+        }
+    }
+    run.logPosition = 0;
+}
+
+// Decompress a file into target block by block, so it can be indexed like a plain file
+bool decompressTo(const QString &filePath, QFile &target, const QAtomicInt *cancelled, QString &errorMsg)
+{
+    CompressedFileReader reader;
+    if (!reader.open(filePath, errorMsg)) {
+        return false;
+    }
+    
+    QByteArray buffer;
+    while (!reader.atEnd()) {
+        if (cancelled && cancelled->loadRelaxed()) {
+            errorMsg = "Loading cancelled";
+            return false;
+        }
+        buffer.clear();
+        if (!reader.read(buffer, CHUNK_SIZE, errorMsg)) {
+            return false;
+        }
+        if (target.write(buffer) != buffer.size()) {
+            errorMsg = QString("Failed to decompress file: %1").arg(target.errorString());
+            return false;
+        }
+    }
+    if (!target.flush()) {
+        errorMsg = QString("Failed to decompress file: %1").arg(target.errorString());
+        return false;
+    }
+    return true;
+}
+
+// Formats entries as threadtime lines straight into a reusable UTF-8 buffer
+// that is written to the file in large blocks
+class LogLineWriter
+{
+public:
+    explicit LogLineWriter(QFile &file)
+        : m_file(file)
+        , m_buffer(SAVE_BLOCK_SIZE, Qt::Uninitialized)
+        , m_used(0)
+        , m_ok(true)
+        , m_encoder(QStringConverter::Utf8, QStringConverter::Flag::Stateless)
+    {}
+    
+    void appendText(const QByteArray &text) {
+        char *out = reserve(text.size());
+        std::memcpy(out, text.constData(), text.size());
+        m_used += text.size();
+    }
+    
+    // Format: MM-DD HH:MM:SS.mmm  PID  TID LEVEL TAG: message, the threadtime
+    // format the converters parse. Returns true if the buffer was written to make room
+    bool append(const LogEntry &entry) {
+        const QByteArray &tag = tagBytes(entry.tagId);
+        const qsizetype flushes = m_flushes;
+        char *const start = reserve(MAX_FIXED_FIELDS_SIZE + tag.size()
+                                    + m_encoder.requiredSpace(entry.message.size()) + 1);
+        char *out = start;
+        
+        // Date and time, with placeholders for entries without a timestamp
+        if (entry.timestamp != LogEntry::NoTimestamp) {
+            out = writeTwoDigits(out, entry.month());
+            *out++ = '-';
+            out = writeTwoDigits(out, entry.day());
+        } else {
+            out = writeText(out, "01-01");
+        }
+        *out++ = ' ';
+        
+        const int msecs = entry.msecsOfDay();
+        if (msecs >= 0) {
+            out = writeTwoDigits(out, msecs / 3600000);
+            *out++ = ':';
+            out = writeTwoDigits(out, (msecs / 60000) % 60);
+            *out++ = ':';
+            out = writeTwoDigits(out, (msecs / 1000) % 60);
+            *out++ = '.';
+            *out++ = static_cast<char>('0' + (msecs % 1000) / 100);
+            out = writeTwoDigits(out, msecs % 100);
+        } else {
+            out = writeText(out, "00:00:00.000");
+        }
+        
+        out = writeText(out, "  ");
+        out = writeId(out, entry.pid);
+        out = writeText(out, "  ");
+        out = writeId(out, entry.tid);
+        *out++ = ' ';
+        
+        const QChar level = LogEntry::levelChar(entry.level);
+        *out++ = level.isNull() ? '?' : level.toLatin1();
+        *out++ = ' ';
+        
+        std::memcpy(out, tag.constData(), tag.size());
+        out += tag.size();
+        out = writeText(out, ": ");
+        out = m_encoder.appendToBuffer(out, entry.message);
+        *out++ = '\n';
+        
+        m_used += out - start;
+        return m_flushes != flushes;
+    }
+    
+    // Write what is left in the buffer
+    bool finish() {
+        flush();
+        return m_ok;
+    }
+
+private:
+    // Longest date, time, IDs, level and separators
+    static constexpr qsizetype MAX_FIXED_FIELDS_SIZE = 64;
+    
+    // Pointer to at least size free bytes, writing the buffer first if needed
+    char *reserve(qsizetype size) {
+        if (m_used + size > m_buffer.size()) {
+            flush();
+            if (size > m_buffer.size()) {
+                m_buffer.resize(size);
+            }
+        }
+        return m_buffer.data() + m_used;
+    }
+    
+    void flush() {
+        if (m_used > 0 && m_ok) {
+            m_ok = (m_file.write(m_buffer.constData(), m_used) == m_used);
+        }
+        m_used = 0;
+        ++m_flushes;
+    }
+    
+    // Tag text, "Unknown" for entries without one; encoded once per tag
+    const QByteArray &tagBytes(quint32 tagId) {
+        auto it = m_tags.find(tagId);
+        if (it == m_tags.end()) {
+            const QString tag = tagId == 0 ? QString() : LogStringPool::instance().at(tagId);
+            it = m_tags.insert(tagId, tag.isEmpty() ? QByteArray("Unknown") : QByteArray(m_encoder.encode(tag)));
+        }
+        return it.value();
+    }
+    
+    static char *writeText(char *out, const char *text) {
+        while (*text) {
+            *out++ = *text++;
+        }
+        return out;
+    }
+    
+    static char *writeTwoDigits(char *out, int value) {
+        *out++ = static_cast<char>('0' + value / 10);
+        *out++ = static_cast<char>('0' + value % 10);
+        return out;
+    }
+    
+    // Right-aligned in 5 characters like QString::arg(id, 5), "    ?" without an ID
+    static char *writeId(char *out, qint32 id) {
+        if (id == LogEntry::NoId) {
+            return writeText(out, "    ?");
+        }
+        
+        char digits[12];
+        int count = 0;
+        quint32 magnitude = id < 0 ? 0u - static_cast<quint32>(id) : static_cast<quint32>(id);
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (id < 0) {
+            digits[count++] = '-';
+        }
+        
+        for (int i = count; i < 5; ++i) {
+            *out++ = ' ';
+        }
+        while (count > 0) {
+            *out++ = digits[--count];
+        }
+        return out;
+    }
+    
+    QFile &m_file;
+    QByteArray m_buffer;
+    qsizetype m_used;
+    qsizetype m_flushes = 0;
+    bool m_ok;
+    QStringEncoder m_encoder;
+    QHash<quint32, QByteArray> m_tags;
+};
+
+// Split a block of bytes into lines worth scoring
+void appendSampleLines(const QByteArray &block, bool dropFirstLine, QList<QByteArray> &lines)
+{
+    QList<QByteArray> blockLines = block.split('\n');
+    
+    // A region starting mid-file begins with a partial line; the last one may be cut too
+    if (dropFirstLine && !blockLines.isEmpty()) {
+        blockLines.removeFirst();
+    }
+    if (blockLines.size() > 1) {
+        blockLines.removeLast();
+    }
+    
+    int taken = 0;
+    for (QByteArray &line : blockLines) {
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (isSkippedLine(QByteArrayView(line).trimmed())) {
+            continue;
+        }
+        lines.append(line);
+        if (++taken == SAMPLE_REGION_LINES) {
+            break;
+        }
+    }
+}
+
+} // namespace
 
 FileManager::FileManager()
     : m_lastLineCount(0)
@@ -15,75 +500,231 @@ QVector<LogEntry> FileManager::readFromFile(const QString &filePath,
                                              QString &errorMsg)
 {
     QVector<LogEntry> logs;
+    readWithConverters(filePath, QVector<LogConverterPtr>({converter}), collectInto(logs), nullptr, nullptr, errorMsg);
+    return logs;
+}
+
+FileManager::LogBatchHandler FileManager::collectInto(QVector<LogEntry> &logs)
+{
+    return [&logs](QVector<LogEntry> &batch, qint64 bytesRead, qint64 totalBytes) {
+        Q_UNUSED(bytesRead);
+        Q_UNUSED(totalBytes);
+        logs.append(std::move(batch));
+    };
+}
+
+bool FileManager::readWithConverters(const QString &filePath,
+                                     const QVector<LogConverterPtr> &converters,
+                                     const LogBatchHandler &onBatch,
+                                     const QAtomicInt *cancelled,
+                                     LogFileIndex *index,
+                                     QString &errorMsg)
+{
     m_lastLineCount = 0;
     m_lastParsedCount = 0;
     
     // Validate input
     if (filePath.isEmpty()) {
         errorMsg = "File path is empty";
-        return logs;
+        return false;
     }
     
-    if (!converter) {
+    if (converters.isEmpty() || converters.contains(LogConverterPtr())) {
         errorMsg = "Log converter is null";
-        return logs;
+        return false;
     }
     
-    // Check if file exists
-    QFileInfo fileInfo(filePath);
-    if (!fileInfo.exists()) {
-        errorMsg = QString("File does not exist: %1").arg(filePath);
-        return logs;
+    // Map the file and split lines straight from the mapped bytes; files that can't
+    // be mapped (empty, pipes, some special files) are read into memory instead.
+    // An index keeps the mapping open for parsing its lines later
+    QFile file(filePath);
+    QByteArray contents;
+    const char *data = nullptr;
+    qint64 length = 0;
+    uchar *mapped = nullptr;
+    if (index) {
+        // An index parses lines from the mapped file later, which needs the plain bytes
+        if (isCompressed(filePath)) {
+            errorMsg = "Compressed files can't be indexed";
+            return false;
+        }
+        if (!index->open(filePath, errorMsg)) {
+            return false;
+        }
+        data = index->data();
+        length = index->length();
+    } else {
+        // Check if file exists
+        QFileInfo fileInfo(filePath);
+        if (!fileInfo.exists()) {
+            errorMsg = QString("File does not exist: %1").arg(filePath);
+            return false;
+        }
+        
+        if (!fileInfo.isFile()) {
+            errorMsg = QString("Path is not a file: %1").arg(filePath);
+            return false;
+        }
+        
+        if (isCompressed(filePath)) {
+            return readCompressed(filePath, converters, onBatch, cancelled, errorMsg);
+        }
+        
+        // Open file for reading
+        if (!file.open(QIODevice::ReadOnly)) {
+            errorMsg = QString("Failed to open file: %1").arg(file.errorString());
+            return false;
+        }
+        
+        length = file.size();
+        mapped = length > 0 ? file.map(0, length) : nullptr;
+        if (mapped) {
+            data = reinterpret_cast<const char *>(mapped);
+        } else {
+            contents = file.readAll();
+            data = contents.constData();
+            length = contents.size();
+        }
     }
     
-    if (!fileInfo.isFile()) {
-        errorMsg = QString("Path is not a file: %1").arg(filePath);
-        return logs;
+    // Skip a UTF-8 byte order mark, like QTextStream does
+    qint64 pos = 0;
+    if (length >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        pos = 3;
     }
     
-    // Open file for reading
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        errorMsg = QString("Failed to open file: %1").arg(file.errorString());
-        return logs;
+    // Parse in chunks on their own threads; every parallel slot gets its own converters
+    QVector<QVector<LogConverterPtr>> slotConverters;
+    const bool completed = parseInWaves(data, pos, length, true, converters, slotConverters,
+                                        index != nullptr, cancelled, [&](ParseChunk &chunk) {
+        m_lastLineCount += chunk.lineCount;
+        m_lastParsedCount += chunk.parsedCount;
+        if (index) {
+            index->appendLines(chunk.lines);
+        }
+        onBatch(chunk.logs, chunk.end, length);
+    });
+    if (!completed) {
+        errorMsg = "Loading cancelled";
+        return false;
     }
     
-    // Read and parse lines
-    QTextStream in(&file);
+    if (mapped) {
+        file.unmap(mapped);
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    if (index) {
+        index->setConverters(converters);
+    }
     
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        m_lastLineCount++;
+    // Success
+    errorMsg.clear();
+    return true;
+}
+
+bool FileManager::readCompressed(const QString &filePath,
+                                 const QVector<LogConverterPtr> &converters,
+                                 const LogBatchHandler &onBatch,
+                                 const QAtomicInt *cancelled,
+                                 QString &errorMsg)
+{
+    CompressedFileReader reader;
+    if (!reader.open(filePath, errorMsg)) {
+        return false;
+    }
+    
+    // Decompression is sequential, so blocks of a full wave of chunks are decompressed
+    // and parsed in parallel; the partial line at the end of a block moves to the next one
+    const qint64 blockSize = parseSlotCount() * CHUNK_SIZE;
+    QVector<QVector<LogConverterPtr>> slotConverters;
+    QByteArray buffer;
+    bool firstBlock = true;
+    auto deliver = [&](ParseChunk &chunk) {
+        m_lastLineCount += chunk.lineCount;
+        m_lastParsedCount += chunk.parsedCount;
+        onBatch(chunk.logs, reader.pos(), reader.size());
+    };
+    
+    while (!reader.atEnd()) {
+        if (!reader.read(buffer, blockSize, errorMsg)) {
+            return false;
+        }
         
-        // Skip empty lines
-        if (line.trimmed().isEmpty()) {
-            continue;
+        // Skip a UTF-8 byte order mark, like QTextStream does
+        qint64 begin = 0;
+        if (firstBlock && buffer.startsWith("\xEF\xBB\xBF")) {
+            begin = 3;
         }
         
-        // Skip logcat header lines (e.g., "--------- beginning of system")
-        if (line.trimmed().startsWith("---------")) {
+        // Parse up to the last complete line, the rest of the data once it has ended
+        const qint64 end = reader.atEnd() ? buffer.size() : buffer.lastIndexOf('\n') + 1;
+        if (end <= begin) {
             continue;
         }
         
-        // Try to parse the line
-        LogEntry entry = converter->convert(line);
-        
-        if (entry.isValid()) {
-            logs.append(entry);
-            m_lastParsedCount++;
+        if (!parseInWaves(buffer.constData(), begin, end, firstBlock, converters, slotConverters,
+                          false, cancelled, deliver)) {
+            errorMsg = "Loading cancelled";
+            return false;
         }
+        buffer.remove(0, end);
+        firstBlock = false;
     }
     
-    file.close();
-    
-    // Success
     errorMsg.clear();
+    return true;
+}
+
+QVector<LogEntry> FileManager::readFromBuffer(QByteArrayView data, const QVector<LogConverterPtr> &converters)
+{
+    m_lastLineCount = 0;
+    m_lastParsedCount = 0;
+    
+    QVector<LogEntry> logs;
+    if (converters.isEmpty() || converters.contains(LogConverterPtr())) {
+        return logs;
+    }
+    
+    QVector<QVector<LogConverterPtr>> slotConverters;
+    parseInWaves(data.data(), 0, data.size(), false, converters, slotConverters, false, nullptr,
+                 [this, &logs](ParseChunk &chunk) {
+        m_lastLineCount += chunk.lineCount;
+        m_lastParsedCount += chunk.parsedCount;
+        logs.append(std::move(chunk.logs));
+    });
     return logs;
 }
 
+bool FileManager::isCompressed(const QString &filePath)
+{
+    return CompressedFileReader::detectFormat(filePath) != CompressedFileReader::Format::None;
+}
+
+bool FileManager::saveToFile(const QString &filePath,
+                              const QVector<LogEntry> &logs,
+                              QString &errorMsg)
+{
+    return saveToFile(filePath, logs, SaveProgressHandler(), errorMsg);
+}
+
 bool FileManager::saveToFile(const QString &filePath,
                               const QVector<LogEntry> &logs,
+                              const SaveProgressHandler &onProgress,
                               QString &errorMsg)
+{
+    const EntryChunkReader readChunk = [&logs](qsizetype first, qsizetype count, QVector<LogEntry> &entries) {
+        entries.append(logs.mid(first, count));
+    };
+    return saveToFile(filePath, logs.size(), readChunk, onProgress, errorMsg);
+}
+
+bool FileManager::saveToFile(const QString &filePath,
+                             qsizetype entryCount,
+                             const EntryChunkReader &readChunk,
+                             const SaveProgressHandler &onProgress,
+                             QString &errorMsg)
 {
     // Validate input
     if (filePath.isEmpty()) {
@@ -98,142 +739,471 @@ bool FileManager::saveToFile(const QString &filePath,
         return false;
     }
     
-    QTextStream out(&file);
+    LogLineWriter writer(file);
     
     // Write header
-    out << "# Log file saved by ToolLogPro\n";
-    out << "# Format: MM-DD HH:MM:SS.mmm PID TID LEVEL TAG: message (threadtime format)\n";
-    out << "# Total entries: " << logs.size() << "\n";
-    out << "\n";
+    writer.appendText("# Log file saved by ToolLogPro\n");
+    writer.appendText("# Format: MM-DD HH:MM:SS.mmm PID TID LEVEL TAG: message (threadtime format)\n");
+    writer.appendText("# Total entries: " + QByteArray::number(entryCount) + "\n");
+    writer.appendText("\n");
     
-    // Write log entries
-    for (const LogEntry &entry : logs) {
-        out << formatLogEntry(entry) << "\n";
+    // Write log entries a chunk at a time, reporting progress whenever a block went to the file
+    QVector<LogEntry> chunk;
+    for (qsizetype first = 0; first < entryCount; first += SAVE_CHUNK_ENTRIES) {
+        chunk.clear();
+        readChunk(first, qMin(SAVE_CHUNK_ENTRIES, entryCount - first), chunk);
+        for (qsizetype i = 0; i < chunk.size(); ++i) {
+            if (writer.append(chunk[i]) && onProgress) {
+                onProgress(first + i, entryCount);
+            }
+        }
     }
     
+    if (!writer.finish()) {
+        errorMsg = QString("Failed to write file: %1").arg(file.errorString());
+        return false;
+    }
     file.close();
+    if (onProgress) {
+        onProgress(entryCount, entryCount);
+    }
     
     // Success
     errorMsg.clear();
     return true;
 }
 
+bool FileManager::saveSession(const QString &filePath,
+                              qsizetype entryCount,
+                              const EntryChunkReader &readChunk,
+                              const SessionState &state,
+                              const SaveProgressHandler &onProgress,
+                              QString &errorMsg)
+{
+    return LogSession::write(filePath, entryCount, readChunk, state, onProgress, errorMsg);
+}
+
+bool FileManager::readSession(const QString &filePath,
+                              const LogBatchHandler &onBatch,
+                              const QAtomicInt *cancelled,
+                              SessionState &state,
+                              QString &errorMsg)
+{
+    m_lastLineCount = 0;
+    m_lastParsedCount = 0;
+    
+    LogSession::Reader reader;
+    if (!reader.open(filePath, errorMsg)) {
+        return false;
+    }
+    state = reader.state();
+    
+    // Blocks are independent, a wave of them is decoded in parallel
+    struct SessionBlock {
+        qsizetype index;
+        QVector<LogEntry> logs;
+        bool ok;
+    };
+    const qsizetype blockCount = reader.blocks().size();
+    const qint64 fileSize = QFileInfo(filePath).size();
+    for (qsizetype next = 0; next < blockCount; ) {
+        if (cancelled && cancelled->loadRelaxed()) {
+            errorMsg = "Loading cancelled";
+            return false;
+        }
+        
+        QVector<SessionBlock> wave;
+        const qsizetype waveSize = qMin<qsizetype>(parseSlotCount(), blockCount - next);
+        for (qsizetype i = 0; i < waveSize; ++i) {
+            wave.append({next + i, QVector<LogEntry>(), false});
+        }
+        QtConcurrent::blockingMap(wave, [&reader](SessionBlock &block) {
+            block.ok = reader.readBlock(block.index, block.logs);
+        });
+        
+        for (SessionBlock &block : wave) {
+            if (!block.ok) {
+                errorMsg = QString("Corrupt session file: block %1 can't be read").arg(block.index);
+                return false;
+            }
+            m_lastLineCount += block.logs.size();
+            m_lastParsedCount += block.logs.size();
+            onBatch(block.logs, fileSize * (block.index + 1) / blockCount, fileSize);
+        }
+        next += waveSize;
+    }
+    
+    errorMsg.clear();
+    return true;
+}
+
+bool FileManager::isSession(const QString &filePath)
+{
+    return LogSession::isSessionFile(filePath);
+}
+
 QVector<LogEntry> FileManager::readFromFileAuto(const QString &filePath,
                                                  const QVector<LogConverterPtr> &converters,
                                                  LogConverterPtr &usedConverter,
                                                  QString &errorMsg)
 {
-    QVector<LogEntry> bestResult;
-    LogConverterPtr bestConverter;
-    int bestParsedCount = 0;
-    int bestLineCount = 0;
+    QVector<LogEntry> logs;
+    if (!readFromFileAuto(filePath, converters, usedConverter, collectInto(logs), nullptr, errorMsg)) {
+        return QVector<LogEntry>();
+    }
+    return logs;
+}
+
+bool FileManager::readFromFileAuto(const QString &filePath,
+                                   const QVector<LogConverterPtr> &converters,
+                                   LogConverterPtr &usedConverter,
+                                   const LogBatchHandler &onBatch,
+                                   const QAtomicInt *cancelled,
+                                   QString &errorMsg)
+{
+    usedConverter.reset();
+    if (converters.isEmpty()) {
+        errorMsg = "No log converters given";
+        return false;
+    }
     
-    // Try each converter
-    for (const LogConverterPtr &converter : converters) {
-        QString converterError;
-        QVector<LogEntry> result = readFromFile(filePath, converter, converterError);
-        
-        // Check if this converter performed better
-        if (m_lastParsedCount > bestParsedCount) {
-            bestParsedCount = m_lastParsedCount;
-            bestLineCount = m_lastLineCount;
-            bestResult = result;
-            bestConverter = converter;
-        }
-        
-        // If we got 100% parse rate, use this converter
-        if (m_lastLineCount > 0 && m_lastParsedCount == m_lastLineCount) {
-            break;
+    // Entries cached by an earlier open are delivered without parsing
+    const bool cacheable = LogCache::isCacheable(filePath);
+    if (cacheable && LogCache::readEntries(filePath, converters, usedConverter, onBatch, cancelled,
+                                           m_lastLineCount, m_lastParsedCount)) {
+        if (cancelled && cancelled->loadRelaxed()) {
+            errorMsg = "Loading cancelled";
+            return false;
         }
+        errorMsg.clear();
+        return true;
+    }
+    
+    // Parse once with the best match, the others only handle lines it can't parse;
+    // the entries are written to the cache on the way
+    const QVector<LogConverterPtr> ordered = orderBySample(filePath, converters);
+    QScopedPointer<LogCache::EntryWriter> cacheWriter(cacheable ? new LogCache::EntryWriter(filePath) : nullptr);
+    LogBatchHandler handler = onBatch;
+    if (cacheWriter) {
+        handler = [&cacheWriter, &onBatch](QVector<LogEntry> &batch, qint64 bytesRead, qint64 totalBytes) {
+            cacheWriter->append(batch);
+            onBatch(batch, bytesRead, totalBytes);
+        };
+    }
+    if (!readWithConverters(filePath, ordered, handler, cancelled, nullptr, errorMsg)) {
+        return false;
     }
     
     // Check if we found any valid converter
-    if (bestParsedCount == 0) {
+    if (m_lastParsedCount == 0) {
         errorMsg = "No converter could parse the file successfully";
-        usedConverter.reset();
-        return QVector<LogEntry>();
+        return false;
     }
     
-    // Restore the counts from the best converter
-    m_lastParsedCount = bestParsedCount;
-    m_lastLineCount = bestLineCount;
+    if (cacheWriter) {
+        cacheWriter->finish(ordered, m_lastLineCount);
+    }
     
-    // Return best result
-    usedConverter = bestConverter;
+    usedConverter = ordered.first();
     errorMsg.clear();
-    return bestResult;
+    return true;
 }
 
-int FileManager::getLastLineCount() const
+bool FileManager::mergeFilesAuto(const QStringList &filePaths,
+                                 const QVector<LogConverterPtr> &converters,
+                                 LogConverterPtr &usedConverter,
+                                 const LogBatchHandler &onBatch,
+                                 const QAtomicInt *cancelled,
+                                 QString &errorMsg)
 {
-    return m_lastLineCount;
+    usedConverter.reset();
+    m_lastLineCount = 0;
+    m_lastParsedCount = 0;
+    
+    if (filePaths.isEmpty()) {
+        errorMsg = "No files given";
+        return false;
+    }
+    
+    if (converters.isEmpty() || converters.contains(LogConverterPtr())) {
+        errorMsg = "No log converters given";
+        return false;
+    }
+    
+    // Index all files at once, each with converters of its own; only the line index
+    // of every file is kept, entries are parsed as the merge reaches them
+    std::vector<MergeRun> runs(filePaths.size());
+    qint64 totalBytes = 0;
+    for (qsizetype i = 0; i < filePaths.size(); ++i) {
+        MergeRun &run = runs[i];
+        run.filePath = filePaths[i];
+        run.sourceId = LogStringPool::instance().intern(QFileInfo(run.filePath).fileName());
+        for (const LogConverterPtr &converter : converters) {
+            run.converters.append(converter->clone());
+        }
+        totalBytes += QFileInfo(run.filePath).size();
+    }
+    
+    QVector<QFuture<void>> futures;
+    for (MergeRun &run : runs) {
+        futures.append(QtConcurrent::run([&run, cancelled]() {
+            FileManager fileManager;
+            const LogBatchHandler ignoreProgress = [](QVector<LogEntry> &, qint64, qint64) {};
+            if (isCompressed(run.filePath)) {
+                // Compressed files can't be mapped, an uncached plain copy is indexed instead
+                run.decompressed.reset(new QTemporaryFile);
+                run.ok = run.decompressed->open()
+                         && decompressTo(run.filePath, *run.decompressed, cancelled, run.errorMsg)
+                         && fileManager.indexFile(run.decompressed->fileName(), run.converters,
+                                                  run.usedConverter, run.index, ignoreProgress,
+                                                  cancelled, false, run.errorMsg);
+                if (!run.ok && run.errorMsg.isEmpty()) {
+                    run.errorMsg = QString("Failed to create temporary file: %1").arg(run.decompressed->errorString());
+                }
+            } else {
+                run.ok = fileManager.indexFileAuto(run.filePath, run.converters, run.usedConverter,
+                                                   run.index, ignoreProgress, cancelled, run.errorMsg);
+            }
+            run.lineCount = fileManager.getLastLineCount();
+            run.parsedCount = fileManager.getLastParsedCount();
+            if (run.ok) {
+                run.lineConverters = run.index.cloneConverters();
+                sortRun(run);
+            }
+        }));
+    }
+    
+    // Report progress per indexed file, the merge needs the first entry of every file
+    qint64 bytesRead = 0;
+    QVector<LogEntry> batch;
+    for (qsizetype i = 0; i < futures.size(); ++i) {
+        futures[i].waitForFinished();
+        bytesRead += QFileInfo(runs[i].filePath).size();
+        onBatch(batch, bytesRead, totalBytes);
+    }
+    
+    if (cancelled && cancelled->loadRelaxed()) {
+        errorMsg = "Loading cancelled";
+        return false;
+    }
+    
+    for (const MergeRun &run : runs) {
+        if (!run.ok) {
+            errorMsg = QString("%1: %2").arg(QFileInfo(run.filePath).fileName(), run.errorMsg);
+            return false;
+        }
+        m_lastLineCount += run.lineCount;
+        m_lastParsedCount += run.parsedCount;
+    }
+    
+    // k-way merge: the heap holds the key of the next entry of every run, ties go to the earlier file
+    using Head = std::pair<qint64, qsizetype>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+    for (qsizetype i = 0; i < qsizetype(runs.size()); ++i) {
+        if (!runs[i].keys.isEmpty()) {
+            heap.push({runs[i].keys[runs[i].lineAt(0)], i});
+        }
+    }
+    
+    auto deliverBatch = [&]() {
+        if (cancelled && cancelled->loadRelaxed()) {
+            errorMsg = "Loading cancelled";
+            return false;
+        }
+        onBatch(batch, totalBytes, totalBytes);
+        batch.clear();
+        return true;
+    };
+    
+    batch.reserve(MERGE_BATCH_SIZE);
+    while (!heap.empty()) {
+        const qsizetype current = heap.top().second;
+        heap.pop();
+        
+        // Entries without a timestamp of their own go out right after the entry
+        // before them, no other file's entry can come between them
+        MergeRun &run = runs[current];
+        const QVector<qint64> &timestamps = run.index.timestamps();
+        do {
+            if (run.logPosition == run.logs.size()) {
+                fillRun(run);
+            }
+            LogEntry &entry = run.logs[run.logPosition++];
+            entry.sourceId = run.sourceId;
+            batch.append(std::move(entry));
+            ++run.position;
+            
+            if (batch.size() == MERGE_BATCH_SIZE && !deliverBatch()) {
+                return false;
+            }
+        } while (run.position < run.keys.size()
+                 && timestamps[run.lineAt(run.position)] == LogEntry::NoTimestamp);
+        
+        if (run.position < run.keys.size()) {
+            heap.push({run.keys[run.lineAt(run.position)], current});
+        } else {
+            // Release a finished run right away, its file stays mapped until the end
+            run.logs = QVector<LogEntry>();
+            run.keys = QVector<qint64>();
+            run.order = QVector<qsizetype>();
+        }
+    }
+    
+    if (!batch.isEmpty() && !deliverBatch()) {
+        return false;
+    }
+    
+    usedConverter = runs.front().usedConverter;
+    errorMsg.clear();
+    return true;
 }
 
-int FileManager::getLastParsedCount() const
+bool FileManager::indexFileAuto(const QString &filePath,
+                                const QVector<LogConverterPtr> &converters,
+                                LogConverterPtr &usedConverter,
+                                LogFileIndex &index,
+                                const LogBatchHandler &onProgress,
+                                const QAtomicInt *cancelled,
+                                QString &errorMsg)
 {
-    return m_lastParsedCount;
+    return indexFile(filePath, converters, usedConverter, index, onProgress, cancelled, true, errorMsg);
 }
 
-QString FileManager::formatLogEntry(const LogEntry &entry) const
+bool FileManager::indexFile(const QString &filePath,
+                            const QVector<LogConverterPtr> &converters,
+                            LogConverterPtr &usedConverter,
+                            LogFileIndex &index,
+                            const LogBatchHandler &onProgress,
+                            const QAtomicInt *cancelled,
+                            bool useCache,
+                            QString &errorMsg)
 {
-    // Format: MM-DD HH:MM:SS.mmm PID TID LEVEL TAG: message
-    // This matches the threadtime format that converters can parse
-    QString formatted;
-    
-    // Extract MM-DD from date (handles both YYYY-MM-DD and MM-DD formats)
-    QString dateStr;
-    if (!entry.date.isEmpty()) {
-        if (entry.date.contains('-')) {
-            QStringList dateParts = entry.date.split('-');
-            if (dateParts.size() == 3) {
-                // Format: YYYY-MM-DD, extract MM-DD
-                dateStr = QString("%1-%2").arg(dateParts[1]).arg(dateParts[2]);
-            } else if (dateParts.size() == 2) {
-                // Already in MM-DD format
-                dateStr = entry.date;
-            }
-        } else {
-            dateStr = entry.date;
-        }
+    usedConverter.reset();
+    if (converters.isEmpty()) {
+        errorMsg = "No log converters given";
+        return false;
     }
     
-    if (!dateStr.isEmpty()) {
-        formatted += dateStr;
-    } else {
-        formatted += "01-01";
+    // An index cached by an earlier open only needs the file to be mapped again
+    m_lastLineCount = 0;
+    m_lastParsedCount = 0;
+    if (useCache && LogCache::isCacheable(filePath)
+        && LogCache::readIndex(filePath, converters, usedConverter, index, m_lastLineCount)) {
+        m_lastParsedCount = static_cast<int>(index.size());
+        errorMsg.clear();
+        return true;
     }
     
-    formatted += " ";
+    // Same detection as readFromFileAuto(), lines are only located and classified
+    const QVector<LogConverterPtr> ordered = orderBySample(filePath, converters);
+    if (!readWithConverters(filePath, ordered, onProgress, cancelled, &index, errorMsg)) {
+        index.close();
+        return false;
+    }
     
-    // Add time
-    if (!entry.time.isEmpty()) {
-        formatted += entry.time;
-    } else {
-        formatted += "00:00:00.000";
+    if (m_lastParsedCount == 0) {
+        index.close();
+        errorMsg = "No converter could parse the file successfully";
+        return false;
     }
     
-    formatted += "  ";
+    if (useCache && LogCache::isCacheable(filePath)) {
+        LogCache::writeIndex(filePath, index, m_lastLineCount);
+    }
     
-    if (!entry.pid.isEmpty()) {
-        formatted += QString("%1").arg(entry.pid, 5);
-    } else {
-        formatted += "    ?";
+    usedConverter = ordered.first();
+    errorMsg.clear();
+    return true;
+}
+
+QVector<LogConverterPtr> FileManager::orderBySample(const QString &filePath,
+                                                    const QVector<LogConverterPtr> &converters)
+{
+    // Score every converter on a small sample instead of parsing the whole file with each
+    const QList<QByteArray> sample = sampleLines(filePath);
+    qsizetype bestIndex = 0;
+    int bestScore = -1;
+    for (qsizetype i = 0; i < converters.size(); ++i) {
+        int score = 0;
+        for (const QByteArray &line : sample) {
+            if (converters[i] && converters[i]->convertUtf8(line).isValid()) {
+                score++;
+            }
+        }
+        
+        // Ties keep the earlier converter
+        if (score > bestScore) {
+            bestScore = score;
+            bestIndex = i;
+        }
     }
     
-    formatted += "  ";
+    QVector<LogConverterPtr> ordered = converters;
+    ordered.move(bestIndex, 0);
+    return ordered;
+}
+
+QList<QByteArray> FileManager::sampleLines(const QString &filePath)
+{
+    QList<QByteArray> lines;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return lines;
+    }
     
-    if (!entry.tid.isEmpty()) {
-        formatted += QString("%1").arg(entry.tid, 5);
-    } else {
-        formatted += "    ?";
+    // Compressed files can't be read at an offset, their head is decompressed instead
+    if (isCompressed(filePath)) {
+        CompressedFileReader reader;
+        QByteArray contents;
+        QString errorMsg;
+        if (reader.open(filePath, errorMsg)) {
+            while (!reader.atEnd() && contents.size() < 3 * SAMPLE_REGION_BYTES
+                   && reader.read(contents, 3 * SAMPLE_REGION_BYTES - contents.size(), errorMsg)) {
+            }
+        }
+        if (contents.startsWith("\xEF\xBB\xBF")) {
+            contents.remove(0, 3);
+        }
+        // Only a completely decompressed file ends with a complete line
+        if (reader.atEnd()) {
+            contents.append('\n');
+        }
+        appendSampleLines(contents, false, lines);
+        return lines;
     }
     
-    formatted += " ";
-    formatted += entry.level.isEmpty() ? "?" : entry.level;
-    formatted += " ";
-    formatted += entry.tag.isEmpty() ? "Unknown" : entry.tag;
-    formatted += ": ";
-    formatted += entry.message;
+    const qint64 size = file.size();
     
-    return formatted;
+    // Small files are sampled completely
+    if (size <= 3 * SAMPLE_REGION_BYTES) {
+        QByteArray contents = file.readAll();
+        if (contents.startsWith("\xEF\xBB\xBF")) {
+            contents.remove(0, 3);
+        }
+        appendSampleLines(contents + '\n', false, lines);
+        return lines;
+    }
+    
+    // Head, middle and tail, so a format change partway through the file still counts
+    const qint64 offsets[] = {0, size / 2, size - SAMPLE_REGION_BYTES};
+    for (qint64 offset : offsets) {
+        if (file.seek(offset)) {
+            QByteArray block = file.read(SAMPLE_REGION_BYTES);
+            if (offset == 0 && block.startsWith("\xEF\xBB\xBF")) {
+                block.remove(0, 3);
+            }
+            appendSampleLines(block, offset > 0, lines);
+        }
+    }
+    return lines;
+}
+
+int FileManager::getLastLineCount() const
+{
+    return m_lastLineCount;
+}
+
+int FileManager::getLastParsedCount() const
+{
+    return m_lastParsedCount;
 }
@@ -2,9 +2,17 @@
 #define FILEMANAGER_H
 
 #include <QString>
+#include <QStringList>
 #include <QVector>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QAtomicInt>
+#include <functional>
 #include "ilogconverter.h"
 
+class LogFileIndex;
+struct SessionState;
+
 /**
  * FileManager handles reading and writing log files
  * Uses ILogConverter for parsing log lines
@@ -13,6 +21,30 @@
 class FileManager
 {
 public:
+    /**
+     * Receives parsed entries in file order while a file is being read
+     * @param batch Entries parsed from the next part of the file, may be moved from
+     * @param bytesRead Bytes of the file processed so far
+     * @param totalBytes Size of the file
+     */
+    using LogBatchHandler = std::function<void(QVector<LogEntry> &batch, qint64 bytesRead, qint64 totalBytes)>;
+    
+    /**
+     * Receives the progress of a save
+     * @param entriesWritten Entries written to the file so far
+     * @param totalEntries Number of entries being saved
+     */
+    using SaveProgressHandler = std::function<void(qsizetype entriesWritten, qsizetype totalEntries)>;
+    
+    /**
+     * Supplies the entries being saved a chunk at a time, so a large source is never
+     * held in memory as a whole
+     * @param first Position of the first entry of the chunk
+     * @param count Number of entries in the chunk
+     * @param entries Receives the entries, appended in order
+     */
+    using EntryChunkReader = std::function<void(qsizetype first, qsizetype count, QVector<LogEntry> &entries)>;
+    
     FileManager();
     ~FileManager() = default;
     
@@ -38,9 +70,82 @@ public:
                     const QVector<LogEntry> &logs,
                     QString &errorMsg);
     
+    /**
+     * Save logs to a file like saveToFile(), reporting progress
+     * Entries are formatted straight into a UTF-8 buffer that is written in large
+     * blocks; safe to call from a worker thread
+     * @param filePath Path where to save the log file
+     * @param logs Vector of log entries to save
+     * @param onProgress Optional, called on the calling thread after each written block
+     * @param errorMsg Output parameter for error messages
+     * @return true if successful, false otherwise
+     */
+    bool saveToFile(const QString &filePath,
+                    const QVector<LogEntry> &logs,
+                    const SaveProgressHandler &onProgress,
+                    QString &errorMsg);
+    
+    /**
+     * Save logs to a file like saveToFile(), reading the entries in chunks
+     * @param filePath Path where to save the log file
+     * @param entryCount Number of entries to save
+     * @param readChunk Called on the calling thread for every chunk, in order
+     * @param onProgress Optional, called on the calling thread after each written block
+     * @param errorMsg Output parameter for error messages
+     * @return true if successful, false otherwise
+     */
+    bool saveToFile(const QString &filePath,
+                    qsizetype entryCount,
+                    const EntryChunkReader &readChunk,
+                    const SaveProgressHandler &onProgress,
+                    QString &errorMsg);
+    
+    /**
+     * Save logs and the state around them as a session file, see LogSession
+     * @param filePath Path where to save the session
+     * @param entryCount Number of entries to save
+     * @param readChunk Called on the calling thread for every block of entries, in order
+     * @param state Marks and filter inputs to restore with the entries
+     * @param onProgress Optional, called on the calling thread after each written block
+     * @param errorMsg Output parameter for error messages
+     * @return true if successful, false otherwise
+     */
+    bool saveSession(const QString &filePath,
+                     qsizetype entryCount,
+                     const EntryChunkReader &readChunk,
+                     const SessionState &state,
+                     const SaveProgressHandler &onProgress,
+                     QString &errorMsg);
+    
+    /**
+     * Read a session file saved by saveSession()
+     * Blocks are decoded in parallel and delivered in order
+     * @param filePath Path to the session file
+     * @param onBatch Called on the calling thread for each block, in file order
+     * @param cancelled Optional flag, reading stops soon after it becomes non-zero
+     * @param state Receives the marks and filter inputs saved with the entries
+     * @param errorMsg Output parameter for error messages
+     * @return true if the session was read completely
+     */
+    bool readSession(const QString &filePath,
+                     const LogBatchHandler &onBatch,
+                     const QAtomicInt *cancelled,
+                     SessionState &state,
+                     QString &errorMsg);
+    
+    /**
+     * Check whether a file is a session saved by saveSession()
+     * @param filePath Path to the file
+     * @return true if the file starts with the session magic bytes
+     */
+    static bool isSession(const QString &filePath);
+    
     /**
      * Read logs from file and try multiple converters
-     * Automatically detects the best converter based on successful parsing
+     * Picks the converter that parses most lines of a sample from the head, middle
+     * and tail of the file, then parses the file once; lines it can't parse are
+     * given to the other converters. Files of a few MB and up are cached, see LogCache.
+     * gzip, zstd and zip files are decompressed while they are parsed
      * @param filePath Path to the log file
      * @param converters List of converters to try
      * @param usedConverter Output parameter for the converter that worked
@@ -52,6 +157,90 @@ public:
                                         LogConverterPtr &usedConverter,
                                         QString &errorMsg);
     
+    /**
+     * Read logs from file like readFromFileAuto(), delivering them in batches as they are parsed
+     * @param filePath Path to the log file
+     * @param converters List of converters to try
+     * @param usedConverter Output parameter for the converter that worked
+     * @param onBatch Called on the calling thread for each batch, in file order
+     * @param cancelled Optional flag, reading stops soon after it becomes non-zero
+     * @param errorMsg Output parameter for error messages
+     * @return true if the file was read completely and had valid entries
+     */
+    bool readFromFileAuto(const QString &filePath,
+                          const QVector<LogConverterPtr> &converters,
+                          LogConverterPtr &usedConverter,
+                          const LogBatchHandler &onBatch,
+                          const QAtomicInt *cancelled,
+                          QString &errorMsg);
+    
+    /**
+     * Read several files into one timeline ordered by timestamp
+     * Every file is indexed like indexFileAuto(), all files at the same time;
+     * compressed files are decompressed to a temporary file first. Each file's
+     * lines are put in timestamp order through its index, then the files are
+     * merged through a heap that holds the next entry of every file. Entries are
+     * parsed a chunk per file at a time, so memory grows with the number of
+     * lines, not with the parsed entries. Entries are tagged with the name of
+     * their file; equal timestamps keep the order of filePaths.
+     * Entries without a timestamp (brief format) follow the entry before them in
+     * their file; a file without any timestamps comes before the other files.
+     * Logcat lines have no year and the current one is assumed, so logs that
+     * span the turn of a year are not in order around it
+     * @param filePaths Files to merge, e.g. rotated logs or buffer dumps
+     * @param converters List of converters to try, every file detects its own format
+     * @param usedConverter Output parameter for the converter of the first file
+     * @param onBatch Called on the calling thread; progress while indexing, then the
+     *                merged entries in order
+     * @param cancelled Optional flag, reading stops soon after it becomes non-zero
+     * @param errorMsg Output parameter for error messages
+     * @return true if every file was read and the merge completed
+     */
+    bool mergeFilesAuto(const QStringList &filePaths,
+                        const QVector<LogConverterPtr> &converters,
+                        LogConverterPtr &usedConverter,
+                        const LogBatchHandler &onBatch,
+                        const QAtomicInt *cancelled,
+                        QString &errorMsg);
+    
+    /**
+     * Index a file for on-demand parsing instead of reading its entries
+     * Detects the format like readFromFileAuto(), then records the offset, level
+     * and timestamp of every log line; the index keeps the file mapped
+     * @param filePath Path to the log file
+     * @param converters List of converters to try
+     * @param usedConverter Output parameter for the converter that worked
+     * @param index Receives the lines and the converters that parse them
+     * @param onProgress Called after each part of the file, with an empty batch
+     * @param cancelled Optional flag, indexing stops soon after it becomes non-zero
+     * @param errorMsg Output parameter for error messages
+     * @return true if the file was indexed completely and had valid entries
+     */
+    bool indexFileAuto(const QString &filePath,
+                       const QVector<LogConverterPtr> &converters,
+                       LogConverterPtr &usedConverter,
+                       LogFileIndex &index,
+                       const LogBatchHandler &onProgress,
+                       const QAtomicInt *cancelled,
+                       QString &errorMsg);
+    
+    /**
+     * Parse log lines from memory, e.g. the data appended to a followed file
+     * Lines are parsed like readWithConverters() does for a file
+     * @param data Log lines, the last one may lack its newline
+     * @param converters Converters to use, preferred format first
+     * @return Parsed entries in order
+     */
+    QVector<LogEntry> readFromBuffer(QByteArrayView data, const QVector<LogConverterPtr> &converters);
+    
+    /**
+     * Check whether a file is gzip, zstd or zip compressed
+     * Compressed files are decompressed while they are read and can't be indexed
+     * @param filePath Path to the file
+     * @return true if the file starts with the magic bytes of a supported format
+     */
+    static bool isCompressed(const QString &filePath);
+    
     /**
      * Get the number of lines read in last operation
      * @return Line count
@@ -63,12 +252,57 @@ public:
      * @return Parsed entry count
      */
     int getLastParsedCount() const;
-    
+
 private:
     int m_lastLineCount;
     int m_lastParsedCount;
     
-    QString formatLogEntry(const LogEntry &entry) const;
+    /**
+     * Read logs from a file, trying the converters in order for each line
+     * The converter that parsed the previous line is tried first, so mixed-format
+     * files fall back per region rather than per file
+     * @param filePath Path to the log file
+     * @param converters Converters to use, preferred format first
+     * @param onBatch Receives the parsed entries in file order
+     * @param cancelled Optional flag, reading stops soon after it becomes non-zero
+     * @param index If set, the file is mapped through the index and its lines are
+     *              recorded there instead of being parsed; batches are then empty
+     * @param errorMsg Output parameter for error messages
+     * @return true if the file was read completely
+     */
+    bool readWithConverters(const QString &filePath,
+                            const QVector<LogConverterPtr> &converters,
+                            const LogBatchHandler &onBatch,
+                            const QAtomicInt *cancelled,
+                            LogFileIndex *index,
+                            QString &errorMsg);
+    
+    // indexFileAuto(), optionally without reading or writing the index cache
+    bool indexFile(const QString &filePath,
+                   const QVector<LogConverterPtr> &converters,
+                   LogConverterPtr &usedConverter,
+                   LogFileIndex &index,
+                   const LogBatchHandler &onProgress,
+                   const QAtomicInt *cancelled,
+                   bool useCache,
+                   QString &errorMsg);
+    
+    // readWithConverters() for compressed files, decompressing them block by block
+    bool readCompressed(const QString &filePath,
+                        const QVector<LogConverterPtr> &converters,
+                        const LogBatchHandler &onBatch,
+                        const QAtomicInt *cancelled,
+                        QString &errorMsg);
+    
+    // Batch handler that appends every batch to logs
+    static LogBatchHandler collectInto(QVector<LogEntry> &logs);
+    
+    // Converters ordered by how many sample lines they parse, best first
+    static QVector<LogConverterPtr> orderBySample(const QString &filePath,
+                                                  const QVector<LogConverterPtr> &converters);
+    
+    // Lines from the head, middle and tail of a file for format detection
+    static QList<QByteArray> sampleLines(const QString &filePath);
 };
 
 #endif // FILEMANAGER_H
@@ -0,0 +1,185 @@
+#include "filetailreader.h"
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Appended data is read in steps of at most this size
+const qint64 READ_BLOCK_SIZE = 4 * 1024 * 1024;
+
+// Watchers miss changes on some file systems (network mounts), so the file is
+// also checked at this interval
+const int POLL_INTERVAL_MS = 1000;
+
+} // namespace
+
+FileTailReader::FileTailReader(const QString &filePath, qint64 offset,
+                               const QVector<LogConverterPtr> &converters, LogBatchQueue *queue)
+    : QObject(nullptr)
+    , m_filePath(filePath)
+    , m_converters(converters)
+    , m_queue(queue)
+    , m_watcher(nullptr)
+    , m_pollTimer(nullptr)
+    , m_offset(offset)
+    , m_atFileStart(offset == 0)
+{}
+
+FileTailReader::~FileTailReader()
+{
+    stop();
+}
+
+bool FileTailReader::start()
+{
+    if (!openFile(m_offset)) {
+        return false;
+    }
+    
+    // The directory is watched too, a rotated file reappears there under its old name
+    m_watcher = new QFileSystemWatcher(this);
+    m_watcher->addPath(m_filePath);
+    m_watcher->addPath(QFileInfo(m_filePath).absolutePath());
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &FileTailReader::checkFile);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &FileTailReader::checkFile);
+    
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(POLL_INTERVAL_MS);
+    connect(m_pollTimer, &QTimer::timeout, this, &FileTailReader::checkFile);
+    m_pollTimer->start();
+    
+    // Lines appended between the load and now
+    checkFile();
+    return true;
+}
+
+void FileTailReader::stop()
+{
+    delete m_watcher;
+    m_watcher = nullptr;
+    delete m_pollTimer;
+    m_pollTimer = nullptr;
+    m_file.close();
+    m_buffer.clear();
+}
+
+bool FileTailReader::openFile(qint64 offset)
+{
+    // Unbuffered, so reads see data appended after a previous read hit the end
+    m_file.close();
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return false;
+    }
+    
+    m_birthTime = QFileInfo(m_filePath).birthTime();
+    m_offset = offset;
+    m_atFileStart = (offset == 0);
+    m_buffer.clear();
+    return true;
+}
+
+bool FileTailReader::isFollowedFile(const QFileInfo &info) const
+{
+#ifdef Q_OS_UNIX
+    // Device and inode identify the file behind the path and the open handle
+    Q_UNUSED(info);
+    struct stat pathStat;
+    struct stat fileStat;
+    if (::stat(QFile::encodeName(m_filePath).constData(), &pathStat) != 0
+        || ::fstat(m_file.handle(), &fileStat) != 0) {
+        return false;
+    }
+    return pathStat.st_dev == fileStat.st_dev && pathStat.st_ino == fileStat.st_ino;
+#else
+    return !m_birthTime.isValid() || info.birthTime() == m_birthTime;
+#endif
+}
+
+void FileTailReader::checkFile()
+{
+    const QFileInfo info(m_filePath);
+    const bool replaced = !info.exists() || (m_file.isOpen() && !isFollowedFile(info));
+    
+    // Rotated: finish the old file through the open handle before switching
+    if (replaced && m_file.isOpen()) {
+        readAppended(true);
+        m_file.close();
+    }
+    if (!info.exists()) {
+        return;
+    }
+    
+    if (!m_file.isOpen()) {
+        if (!openFile(0)) {
+            return;
+        }
+        emit restarted(QString("%1 was rotated, following the new file").arg(m_filePath));
+    } else if (info.size() < m_offset) {
+        // Truncated in place, the old contents are gone; also catches a replaced
+        // file where it can't be told apart from the followed one
+        m_offset = 0;
+        m_atFileStart = true;
+        m_buffer.clear();
+        emit restarted(QString("%1 was truncated, following from the start").arg(m_filePath));
+    }
+    
+    readAppended(false);
+    
+    // The watcher drops a file that was removed or replaced
+    if (!m_watcher->files().contains(m_filePath)) {
+        m_watcher->addPath(m_filePath);
+    }
+}
+
+void FileTailReader::readAppended(bool flushPartialLine)
+{
+    while (m_offset < m_file.size()) {
+        if (!m_file.seek(m_offset)) {
+            break;
+        }
+        const QByteArray data = m_file.read(qMin(m_file.size() - m_offset, READ_BLOCK_SIZE));
+        if (data.isEmpty()) {
+            break;
+        }
+        m_offset += data.size();
+        m_buffer.append(data);
+        convertLines(false);
+    }
+    
+    if (flushPartialLine) {
+        convertLines(true);
+    }
+}
+
+void FileTailReader::convertLines(bool flushPartialLine)
+{
+    // Skip a UTF-8 byte order mark, like QTextStream does
+    if (m_atFileStart && m_buffer.size() >= 3) {
+        if (m_buffer.startsWith("\xEF\xBB\xBF")) {
+            m_buffer.remove(0, 3);
+        }
+        m_atFileStart = false;
+    }
+    
+    // Keep the incomplete last line for the next read
+    const qsizetype end = flushPartialLine ? m_buffer.size() : m_buffer.lastIndexOf('\n') + 1;
+    if (end == 0) {
+        return;
+    }
+    
+    QVector<LogEntry> batch = m_fileManager.readFromBuffer(QByteArrayView(m_buffer.constData(), end),
+                                                           m_converters);
+    m_buffer.remove(0, end);
+    
+    // One queue push and one queued signal per read, not per line
+    if (!batch.isEmpty()) {
+        m_queue->push(std::move(batch));
+        emit entriesAvailable();
+    }
+}
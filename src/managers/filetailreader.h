@@ -0,0 +1,81 @@
+#ifndef FILETAILREADER_H
+#define FILETAILREADER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+#include <QDateTime>
+#include "ilogconverter.h"
+#include "filemanager.h"
+#include "logcatreader.h"
+
+class QFileInfo;
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * Follows a growing log file on a worker thread, like tail -f
+ * Only the bytes appended since the last read are parsed, batches go to a
+ * queue read by the GUI thread. A file truncated in place is followed from
+ * its start again; a rotated file is read to its end through the open handle
+ * before the new file at the same path is followed. Must be moved to its
+ * thread before start() is called, the watcher is created on that thread
+ */
+class FileTailReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param filePath File to follow
+     * @param offset Bytes already read, following starts there
+     * @param converters Converters for the appended lines, preferred format first;
+     *                   only used on the reader's thread
+     * @param queue Destination for parsed batches, this reader is its only producer
+     */
+    FileTailReader(const QString &filePath, qint64 offset,
+                   const QVector<LogConverterPtr> &converters, LogBatchQueue *queue);
+    ~FileTailReader() override;
+    
+    /**
+     * Open the file and start watching it
+     * @return True if the file could be opened
+     */
+    bool start();
+    
+    // Stop watching and close the file
+    void stop();
+
+signals:
+    // Emitted after one or more batches were pushed to the queue
+    void entriesAvailable();
+    
+    // The file was truncated or rotated and is followed from its start
+    void restarted(const QString &reason);
+
+private:
+    bool openFile(qint64 offset);
+    
+    // Whether the path still leads to the open file, false once it was rotated
+    bool isFollowedFile(const QFileInfo &info) const;
+    
+    void checkFile();
+    void readAppended(bool flushPartialLine);
+    void convertLines(bool flushPartialLine);
+    
+    QString m_filePath;
+    QVector<LogConverterPtr> m_converters;
+    LogBatchQueue *m_queue;
+    FileManager m_fileManager;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_pollTimer;
+    QFile m_file;
+    QDateTime m_birthTime;  // Identifies the followed file without inodes, invalid where unsupported
+    qint64 m_offset;        // Bytes of m_file read so far
+    bool m_atFileStart;     // m_buffer starts at the beginning of the file
+    QByteArray m_buffer;    // Data not yet split into lines
+};
+
+#endif // FILETAILREADER_H
@@ -0,0 +1,464 @@
+#include "logcache.h"
+#include "logstringpool.h"
+#include "sectionio.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <cstring>
+
+namespace {
+
+const char CACHE_MAGIC[8] = {'T', 'L', 'P', 'C', 'A', 'C', 'H', 'E'};
+const quint32 CACHE_VERSION = 2;
+
+enum CacheKind : quint32 {
+    EntriesCache = 1,
+    IndexCache = 2
+};
+
+// Smaller files parse in about the time it takes to check a cache
+const qint64 MIN_CACHED_FILE_SIZE = 4 * 1024 * 1024;
+
+// Oldest cache files are removed beyond this count, or once all together take more
+// than this many bytes; messages are stored as UTF-16, so a cache of parsed entries
+// is about twice the size of its source
+const int MAX_CACHE_FILES = 16;
+const qint64 MAX_CACHE_BYTES = qint64(2) * 1024 * 1024 * 1024;
+
+// Bytes hashed from the head, middle and tail of a source file
+const qint64 HASH_REGION_SIZE = 64 * 1024;
+
+// Cached entries are delivered in batches of this size
+const qsizetype CACHE_BATCH_SIZE = 65536;
+
+// Written at the end of the cache file, so the columns can be streamed before it
+struct CacheTrailer {
+    char magic[8];
+    quint32 version;
+    quint32 kind;
+    qint64 sourceSize;
+    qint64 sourceModified;   // ms since epoch
+    char sourceHash[24];     // SHA-1 of sampled contents, zero padded
+    qint64 count;            // Entries or indexed lines
+    qint64 lineCount;        // Lines read from the source
+    qint64 converterCount;   // The last strings of the table are converter names, preferred first
+    qint64 stringCount;
+    qint64 stringChars;
+    qint64 messageChars;
+};
+static_assert(sizeof(CacheTrailer) % 8 == 0, "Cache sections must stay 8-byte aligned");
+
+using SourceState = LogCache::SourceState;
+
+bool readSourceState(const QString &sourcePath, SourceState &state)
+{
+    QFile file(sourcePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    state.size = file.size();
+    state.modified = QFileInfo(sourcePath).lastModified().toMSecsSinceEpoch();
+    
+    // Hashing the whole file would cost as much as parsing it; size and time catch
+    // appends and most rewrites, the samples catch edits that keep both
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 offsets[] = {0, state.size / 2, qMax<qint64>(0, state.size - HASH_REGION_SIZE)};
+    for (qint64 offset : offsets) {
+        if (file.seek(offset)) {
+            hash.addData(file.read(HASH_REGION_SIZE));
+        }
+    }
+    state.hash = hash.result();
+    return true;
+}
+
+void fillTrailer(CacheTrailer &trailer, CacheKind kind, const SourceState &state)
+{
+    std::memset(&trailer, 0, sizeof(trailer));
+    std::memcpy(trailer.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    trailer.version = CACHE_VERSION;
+    trailer.kind = kind;
+    trailer.sourceSize = state.size;
+    trailer.sourceModified = state.modified;
+    std::memcpy(trailer.sourceHash, state.hash.constData(),
+                qMin<qsizetype>(state.hash.size(), sizeof(trailer.sourceHash)));
+}
+
+// Keep the cache directory bounded, the most recently written files stay; the newest
+// one is kept even if it alone is over the byte budget
+void pruneCacheFiles(const QString &directory)
+{
+    const QFileInfoList files = QDir(directory).entryInfoList({"*.cache"}, QDir::Files, QDir::Time);
+    qint64 totalBytes = 0;
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        totalBytes += files[i].size();
+        if (i >= MAX_CACHE_FILES || (i > 0 && totalBytes > MAX_CACHE_BYTES)) {
+            QFile::remove(files[i].absoluteFilePath());
+        }
+    }
+}
+
+bool isSameState(const SourceState &a, const SourceState &b)
+{
+    return a.size == b.size && a.modified == b.modified && a.hash == b.hash;
+}
+
+// Converters in cached order, matched by name; false if one is not available
+bool matchConverters(const QStringList &strings, const CacheTrailer &trailer,
+                     const QVector<LogConverterPtr> &converters, QVector<LogConverterPtr> &ordered)
+{
+    if (trailer.converterCount <= 0 || trailer.converterCount > strings.size()) {
+        return false;
+    }
+    
+    for (qsizetype i = strings.size() - trailer.converterCount; i < strings.size(); ++i) {
+        LogConverterPtr match;
+        for (const LogConverterPtr &converter : converters) {
+            if (converter && converter->name() == strings[i]) {
+                match = converter;
+                break;
+            }
+        }
+        if (!match) {
+            return false;
+        }
+        ordered.append(match);
+    }
+    return true;
+}
+
+/**
+ * Map a cache file and check that it belongs to the source file as it is now
+ * @return Start of the sections, null if the cache is missing or stale
+ */
+const uchar *mapCache(QFile &file, const QString &sourcePath, CacheKind kind, CacheTrailer &trailer)
+{
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(CacheTrailer))) {
+        return nullptr;
+    }
+    
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        return nullptr;
+    }
+    
+    std::memcpy(&trailer, data + file.size() - sizeof(CacheTrailer), sizeof(CacheTrailer));
+    if (std::memcmp(trailer.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || trailer.version != CACHE_VERSION || trailer.kind != kind) {
+        return nullptr;
+    }
+    
+    SourceState state;
+    if (!readSourceState(sourcePath, state)
+        || state.size != trailer.sourceSize || state.modified != trailer.sourceModified
+        || std::memcmp(state.hash.constData(), trailer.sourceHash, state.hash.size()) != 0) {
+        return nullptr;
+    }
+    return data;
+}
+
+bool isValidLevel(quint8 level)
+{
+    return level <= static_cast<quint8>(LogLevel::Assert);
+}
+
+} // namespace
+
+LogCache::EntryWriter::EntryWriter(const QString &sourcePath)
+    : m_sourcePath(sourcePath)
+    , m_file(cachePath(sourcePath))
+    , m_ok(false)
+    , m_count(0)
+    , m_messageChars(0)
+{
+    // The source as it is before parsing starts; finish() discards the cache if it
+    // changed meanwhile, e.g. grew while a collector was still writing it
+    m_ok = readSourceState(m_sourcePath, m_state);
+    
+    // Messages are streamed into the file, the other columns follow them in finish()
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+    m_ok = m_ok && m_file.open(QIODevice::WriteOnly);
+    appendValue<qint64>(m_messageOffsets, 0);
+}
+
+void LogCache::EntryWriter::append(const QVector<LogEntry> &batch)
+{
+    if (!m_ok) {
+        return;
+    }
+    
+    for (const LogEntry &entry : batch) {
+        appendValue(m_timestamps, entry.timestamp);
+        appendValue(m_pids, entry.pid);
+        appendValue(m_tids, entry.tid);
+        
+        appendValue(m_tags, tableIndex(entry.tagId));
+        appendValue(m_packages, tableIndex(entry.packageId));
+        
+        appendValue(m_levels, static_cast<quint8>(entry.level));
+        
+        const qint64 bytes = entry.message.size() * qint64(sizeof(QChar));
+        if (m_file.write(reinterpret_cast<const char *>(entry.message.constData()), bytes) != bytes) {
+            m_ok = false;
+            return;
+        }
+        m_messageChars += entry.message.size();
+        appendValue(m_messageOffsets, m_messageChars);
+    }
+    m_count += batch.size();
+}
+
+quint32 LogCache::EntryWriter::tableIndex(quint32 poolId)
+{
+    // Tags and packages are stored once in the string table
+    auto it = m_tableIndex.constFind(poolId);
+    if (it == m_tableIndex.cend()) {
+        it = m_tableIndex.insert(poolId, static_cast<quint32>(m_tableIds.size()));
+        m_tableIds.append(poolId);
+    }
+    return it.value();
+}
+
+bool LogCache::EntryWriter::finish(const QVector<LogConverterPtr> &converters, int lineCount)
+{
+    // The entries only cover the source as it was when parsing started
+    SourceState state;
+    if (!m_ok || !readSourceState(m_sourcePath, state) || !isSameState(state, m_state)) {
+        m_file.cancelWriting();
+        return false;
+    }
+    
+    QStringList strings;
+    for (quint32 id : std::as_const(m_tableIds)) {
+        strings.append(LogStringPool::instance().at(id));
+    }
+    for (const LogConverterPtr &converter : converters) {
+        strings.append(converter->name());
+    }
+    
+    // Same order as readEntries() takes the sections
+    bool ok = true;
+    writePadding(m_file, m_messageChars * qint64(sizeof(QChar)), ok);
+    writeSection(m_file, m_timestamps.constData(), m_timestamps.size(), ok);
+    writeSection(m_file, m_pids.constData(), m_pids.size(), ok);
+    writeSection(m_file, m_tids.constData(), m_tids.size(), ok);
+    writeSection(m_file, m_tags.constData(), m_tags.size(), ok);
+    writeSection(m_file, m_packages.constData(), m_packages.size(), ok);
+    writeSection(m_file, m_levels.constData(), m_levels.size(), ok);
+    writeSection(m_file, m_messageOffsets.constData(), m_messageOffsets.size(), ok);
+    writeStringTable(m_file, strings, ok);
+    
+    CacheTrailer trailer;
+    fillTrailer(trailer, EntriesCache, state);
+    trailer.count = m_count;
+    trailer.lineCount = lineCount;
+    trailer.converterCount = converters.size();
+    trailer.stringCount = strings.size();
+    trailer.stringChars = stringTableChars(strings);
+    trailer.messageChars = m_messageChars;
+    writeSection(m_file, &trailer, sizeof(trailer), ok);
+    
+    if (!ok || !m_file.commit()) {
+        m_file.cancelWriting();
+        return false;
+    }
+    pruneCacheFiles(QFileInfo(m_file.fileName()).absolutePath());
+    return true;
+}
+
+bool LogCache::isCacheable(const QString &sourcePath)
+{
+    const QFileInfo fileInfo(sourcePath);
+    return fileInfo.isFile() && fileInfo.size() >= MIN_CACHED_FILE_SIZE;
+}
+
+QString LogCache::cachePath(const QString &sourcePath)
+{
+    // One cache per source path; the trailer decides whether it is still valid
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(sourcePath).absoluteFilePath().toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/logs/" + QString::fromLatin1(key) + ".cache";
+}
+
+bool LogCache::readEntries(const QString &sourcePath,
+                           const QVector<LogConverterPtr> &converters,
+                           LogConverterPtr &usedConverter,
+                           const FileManager::LogBatchHandler &onBatch,
+                           const QAtomicInt *cancelled,
+                           int &lineCount,
+                           int &parsedCount)
+{
+    QFile file(cachePath(sourcePath));
+    CacheTrailer trailer;
+    const uchar *data = mapCache(file, sourcePath, EntriesCache, trailer);
+    if (!data) {
+        return false;
+    }
+    
+    const qint64 count = trailer.count;
+    SectionReader reader(data, file.size() - qint64(sizeof(CacheTrailer)));
+    const char16_t *messages = reader.take<char16_t>(trailer.messageChars);
+    const qint64 *timestamps = reader.take<qint64>(count);
+    const qint32 *pids = reader.take<qint32>(count);
+    const qint32 *tids = reader.take<qint32>(count);
+    const quint32 *tags = reader.take<quint32>(count);
+    const quint32 *packages = reader.take<quint32>(count);
+    const quint8 *levels = reader.take<quint8>(count);
+    const qint64 *messageOffsets = reader.take<qint64>(count + 1);
+    
+    QStringList strings;
+    QVector<LogConverterPtr> ordered;
+    if (reader.failed() || !readStringTable(reader, trailer.stringCount, trailer.stringChars, strings)
+        || !matchConverters(strings, trailer, converters, ordered)) {
+        return false;
+    }
+    
+    // Check everything before the first batch, a broken cache must not deliver half a file
+    const quint32 tableSize = static_cast<quint32>(strings.size() - trailer.converterCount);
+    if (messageOffsets[0] != 0) {
+        return false;
+    }
+    for (qint64 i = 0; i < count; ++i) {
+        if (tags[i] >= tableSize || packages[i] >= tableSize || !isValidLevel(levels[i])
+            || messageOffsets[i + 1] < messageOffsets[i] || messageOffsets[i + 1] > trailer.messageChars) {
+            return false;
+        }
+    }
+    
+    // Tags and packages are interned once per distinct string, not once per entry
+    QVector<quint32> poolIds;
+    poolIds.reserve(tableSize);
+    for (quint32 i = 0; i < tableSize; ++i) {
+        poolIds.append(LogStringPool::instance().intern(strings[i]));
+    }
+    
+    for (qint64 begin = 0; begin < count; begin += CACHE_BATCH_SIZE) {
+        if (cancelled && cancelled->loadRelaxed()) {
+            break;
+        }
+        
+        const qint64 end = qMin<qint64>(begin + CACHE_BATCH_SIZE, count);
+        QVector<LogEntry> batch;
+        batch.reserve(end - begin);
+        for (qint64 i = begin; i < end; ++i) {
+            LogEntry entry;
+            entry.timestamp = timestamps[i];
+            entry.message = QString(reinterpret_cast<const QChar *>(messages + messageOffsets[i]),
+                                    messageOffsets[i + 1] - messageOffsets[i]);
+            entry.pid = pids[i];
+            entry.tid = tids[i];
+            entry.tagId = poolIds[tags[i]];
+            entry.packageId = poolIds[packages[i]];
+            entry.level = static_cast<LogLevel>(levels[i]);
+            batch.append(std::move(entry));
+        }
+        onBatch(batch, trailer.sourceSize * end / count, trailer.sourceSize);
+    }
+    
+    usedConverter = ordered.first();
+    lineCount = static_cast<int>(trailer.lineCount);
+    parsedCount = static_cast<int>(count);
+    return true;
+}
+
+bool LogCache::writeIndex(const QString &sourcePath, const LogFileIndex &index, int lineCount)
+{
+    SourceState state;
+    if (!readSourceState(sourcePath, state) || state.size != index.length()) {
+        return false;
+    }
+    
+    QSaveFile file(cachePath(sourcePath));
+    QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    
+    QStringList strings;
+    for (const LogConverterPtr &converter : index.converters()) {
+        strings.append(converter->name());
+    }
+    
+    // The columns of the index are written as they are, in the order readIndex() takes them
+    const qint64 count = index.size();
+    bool ok = true;
+    writeSection(file, index.offsets().constData(), count * qint64(sizeof(qint64)), ok);
+    writeSection(file, index.timestamps().constData(), count * qint64(sizeof(qint64)), ok);
+    writeSection(file, index.levels().constData(), count * qint64(sizeof(LogLevel)), ok);
+    writeSection(file, index.converterIds().constData(), count * qint64(sizeof(quint8)), ok);
+    writeStringTable(file, strings, ok);
+    
+    CacheTrailer trailer;
+    fillTrailer(trailer, IndexCache, state);
+    trailer.count = count;
+    trailer.lineCount = lineCount;
+    trailer.converterCount = strings.size();
+    trailer.stringCount = strings.size();
+    trailer.stringChars = stringTableChars(strings);
+    writeSection(file, &trailer, sizeof(trailer), ok);
+    
+    if (!ok || !file.commit()) {
+        file.cancelWriting();
+        return false;
+    }
+    pruneCacheFiles(QFileInfo(file.fileName()).absolutePath());
+    return true;
+}
+
+bool LogCache::readIndex(const QString &sourcePath,
+                         const QVector<LogConverterPtr> &converters,
+                         LogConverterPtr &usedConverter,
+                         LogFileIndex &index,
+                         int &lineCount)
+{
+    QFile file(cachePath(sourcePath));
+    CacheTrailer trailer;
+    const uchar *data = mapCache(file, sourcePath, IndexCache, trailer);
+    if (!data) {
+        return false;
+    }
+    
+    const qint64 count = trailer.count;
+    SectionReader reader(data, file.size() - qint64(sizeof(CacheTrailer)));
+    const qint64 *offsets = reader.take<qint64>(count);
+    const qint64 *timestamps = reader.take<qint64>(count);
+    const quint8 *levels = reader.take<quint8>(count);
+    const quint8 *converterIds = reader.take<quint8>(count);
+    
+    QStringList strings;
+    QVector<LogConverterPtr> ordered;
+    if (reader.failed() || !readStringTable(reader, trailer.stringCount, trailer.stringChars, strings)
+        || !matchConverters(strings, trailer, converters, ordered)) {
+        return false;
+    }
+    
+    for (qint64 i = 0; i < count; ++i) {
+        if (offsets[i] < 0 || offsets[i] >= trailer.sourceSize || !isValidLevel(levels[i])
+            || converterIds[i] >= ordered.size()) {
+            return false;
+        }
+    }
+    
+    QString errorMsg;
+    if (!index.open(sourcePath, errorMsg) || index.length() != trailer.sourceSize) {
+        index.close();
+        return false;
+    }
+    
+    // Copy the columns straight out of the mapping
+    const LogLevel *levelValues = reinterpret_cast<const LogLevel *>(levels);
+    index.setLines(QVector<qint64>(offsets, offsets + count),
+                   QVector<qint64>(timestamps, timestamps + count),
+                   QVector<LogLevel>(levelValues, levelValues + count),
+                   QVector<quint8>(converterIds, converterIds + count));
+    index.setConverters(ordered);
+    
+    usedConverter = ordered.first();
+    lineCount = static_cast<int>(trailer.lineCount);
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef LOGCACHE_H
+#define LOGCACHE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QHash>
+#include <QSaveFile>
+#include <QAtomicInt>
+#include "ilogconverter.h"
+#include "filemanager.h"
+#include "logfileindex.h"
+
+/**
+ * Binary cache of parsed log files, so reopening a file skips parsing
+ * Each source file has one cache file in the application cache directory,
+ * named after the source path. It records the source size, modification time
+ * and a hash of sampled contents, and is ignored once any of them changes.
+ * Fields are stored column by column (timestamps, levels, PIDs, TIDs, string
+ * table IDs, message offsets into a UTF-16 blob) and read from a memory map.
+ * Indexed files store the columns of their LogFileIndex instead
+ */
+class LogCache
+{
+public:
+    // State of a source file that a cache is valid for
+    struct SourceState {
+        qint64 size = 0;
+        qint64 modified = 0;   // ms since epoch
+        QByteArray hash;       // SHA-1 of sampled contents
+    };
+    
+    /**
+     * Writes the entries of a file while it is parsed
+     * Messages go to disk as they arrive, the smaller columns are kept until
+     * finish(); nothing is written unless finish() succeeds and the source is
+     * unchanged since the writer was created
+     */
+    class EntryWriter
+    {
+    public:
+        explicit EntryWriter(const QString &sourcePath);
+        
+        // Add parsed entries in file order
+        void append(const QVector<LogEntry> &batch);
+        
+        /**
+         * Complete the cache file
+         * @param converters Converters used for parsing, preferred format first
+         * @param lineCount Number of lines read from the source
+         * @return true if the cache was written
+         */
+        bool finish(const QVector<LogConverterPtr> &converters, int lineCount);
+    
+    private:
+        quint32 tableIndex(quint32 poolId);
+        
+        QString m_sourcePath;
+        SourceState m_state;  // Source when the writer was created
+        QSaveFile m_file;
+        bool m_ok;
+        qint64 m_count;
+        qint64 m_messageChars;
+        QByteArray m_timestamps;
+        QByteArray m_pids;
+        QByteArray m_tids;
+        QByteArray m_tags;
+        QByteArray m_packages;
+        QByteArray m_levels;
+        QByteArray m_messageOffsets;
+        QHash<quint32, quint32> m_tableIndex; // LogStringPool ID -> string table index
+        QVector<quint32> m_tableIds;          // LogStringPool IDs in string table order
+    };
+    
+    // Files smaller than this parse faster than a cache is checked
+    static bool isCacheable(const QString &sourcePath);
+    
+    // Location of the cache file for a source file
+    static QString cachePath(const QString &sourcePath);
+    
+    /**
+     * Deliver the entries of a file from its cache
+     * The cache is validated completely before the first batch is delivered
+     * @param sourcePath Path to the log file
+     * @param converters Available converters, matched by name
+     * @param usedConverter Output parameter for the converter the file was parsed with
+     * @param onBatch Receives the entries in file order
+     * @param cancelled Optional flag, delivery stops soon after it becomes non-zero
+     * @param lineCount Output parameter for the number of lines in the source
+     * @param parsedCount Output parameter for the number of entries
+     * @return false if there is no valid cache for the file in its current state
+     */
+    static bool readEntries(const QString &sourcePath,
+                            const QVector<LogConverterPtr> &converters,
+                            LogConverterPtr &usedConverter,
+                            const FileManager::LogBatchHandler &onBatch,
+                            const QAtomicInt *cancelled,
+                            int &lineCount,
+                            int &parsedCount);
+    
+    /**
+     * Write the columns of a file index
+     * @param sourcePath Path to the indexed log file
+     * @param index Complete index of the file
+     * @param lineCount Number of lines read from the source
+     * @return true if the cache was written
+     */
+    static bool writeIndex(const QString &sourcePath, const LogFileIndex &index, int lineCount);
+    
+    /**
+     * Restore a file index from its cache
+     * @param sourcePath Path to the log file
+     * @param converters Available converters, matched by name
+     * @param usedConverter Output parameter for the converter the file was indexed with
+     * @param index Receives the source mapping and the cached lines
+     * @param lineCount Output parameter for the number of lines in the source
+     * @return false if there is no valid cache for the file in its current state
+     */
+    static bool readIndex(const QString &sourcePath,
+                          const QVector<LogConverterPtr> &converters,
+                          LogConverterPtr &usedConverter,
+                          LogFileIndex &index,
+                          int &lineCount);
+};
+
+#endif // LOGCACHE_H
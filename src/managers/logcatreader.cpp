@@ -0,0 +1,100 @@
+#include "logcatreader.h"
+
+LogcatReader::LogcatReader(const QString &program, const QStringList &arguments,
+                           const LogConverterPtr &converter, LogBatchQueue *queue)
+    : QObject(nullptr)
+    , m_program(program)
+    , m_arguments(arguments)
+    , m_converter(converter)
+    , m_queue(queue)
+    , m_process(nullptr)
+{}
+
+LogcatReader::~LogcatReader()
+{
+    stop();
+}
+
+bool LogcatReader::start()
+{
+    m_process = new QProcess(this);
+    
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &LogcatReader::readOutput);
+    
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        emit errorOccurred(QString("Logcat process error: %1").arg(error));
+    });
+    
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+        Q_UNUSED(exitCode);
+        Q_UNUSED(exitStatus);
+        // Keep whatever the process printed last, even without a trailing newline
+        m_buffer.append(m_process->readAllStandardOutput());
+        convertLines(true);
+        emit finished();
+    });
+    
+    m_process->start(m_program, m_arguments);
+    if (!m_process->waitForStarted(3000)) {
+        delete m_process;
+        m_process = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void LogcatReader::stop()
+{
+    if (m_process) {
+        disconnect(m_process, nullptr, this, nullptr);
+        m_process->kill();
+        m_process->waitForFinished(1000);
+        delete m_process;
+        m_process = nullptr;
+    }
+    m_buffer.clear();
+}
+
+void LogcatReader::readOutput()
+{
+    m_buffer.append(m_process->readAllStandardOutput());
+    convertLines(false);
+}
+
+void LogcatReader::convertLines(bool flushPartialLine)
+{
+    QVector<LogEntry> batch;
+    qsizetype lineStart = 0;
+    
+    while (lineStart < m_buffer.size()) {
+        qsizetype lineEnd = m_buffer.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            if (!flushPartialLine) {
+                break;
+            }
+            lineEnd = m_buffer.size();
+        }
+        
+        const QString line = QString::fromUtf8(m_buffer.constData() + lineStart,
+                                               lineEnd - lineStart).trimmed();
+        lineStart = lineEnd + 1;
+        if (line.isEmpty()) {
+            continue;
+        }
+        
+        LogEntry entry = m_converter->convert(line);
+        if (entry.isValid()) {
+            batch.append(std::move(entry));
+        }
+    }
+    
+    // Keep the incomplete last line for the next read
+    m_buffer.remove(0, qMin(lineStart, m_buffer.size()));
+    
+    // One queue push and one queued signal per read, not per line
+    if (!batch.isEmpty()) {
+        m_queue->push(std::move(batch));
+        emit entriesAvailable();
+    }
+}
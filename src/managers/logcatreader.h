@@ -0,0 +1,63 @@
+#ifndef LOGCATREADER_H
+#define LOGCATREADER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QProcess>
+#include "ilogconverter.h"
+#include "spscqueue.h"
+
+using LogBatchQueue = SpscQueue<QVector<LogEntry>>;
+
+/**
+ * Runs a logcat process on a worker thread
+ * Splits the output into lines, converts them and pushes each batch of valid
+ * entries to a queue read by the GUI thread. Must be moved to its thread
+ * before start() is called, the process is created on that thread
+ */
+class LogcatReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param program adb executable
+     * @param arguments logcat command line
+     * @param converter Converter for the output lines, must be safe to call from this thread
+     * @param queue Destination for parsed batches, this reader is its only producer
+     */
+    LogcatReader(const QString &program, const QStringList &arguments,
+                 const LogConverterPtr &converter, LogBatchQueue *queue);
+    ~LogcatReader() override;
+    
+    /**
+     * Start the logcat process
+     * @return True if the process started
+     */
+    bool start();
+    
+    // Kill the process without emitting finished()
+    void stop();
+
+signals:
+    // Emitted after one or more batches were pushed to the queue
+    void entriesAvailable();
+    void errorOccurred(const QString &error);
+    void finished();
+
+private:
+    void readOutput();
+    void convertLines(bool flushPartialLine);
+    
+    QString m_program;
+    QStringList m_arguments;
+    LogConverterPtr m_converter;
+    LogBatchQueue *m_queue;
+    QProcess *m_process;
+    QByteArray m_buffer; // Output not yet split into lines
+};
+
+#endif // LOGCATREADER_H
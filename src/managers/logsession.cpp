@@ -0,0 +1,390 @@
+#include "logsession.h"
+#include "logstringpool.h"
+#include "sectionio.h"
+#include <QSaveFile>
+#include <QHash>
+#include <QStringList>
+#include <cstring>
+
+const QString LogSession::FILE_EXTENSION = ".tlpsession";
+
+namespace {
+
+const char SESSION_MAGIC[8] = {'T', 'L', 'P', 'S', 'E', 'S', 'S', 'N'};
+const quint32 SESSION_VERSION = 2;
+
+// Entries per block, the unit of compression and random access
+const qsizetype SESSION_BLOCK_SIZE = 65536;
+
+// Messages are compressed for size on disk; higher levels cost more time than they save
+const int MESSAGE_COMPRESSION_LEVEL = 1;
+
+struct SessionHeader {
+    char magic[8];
+    quint32 version;
+    quint32 reserved;
+};
+static_assert(sizeof(SessionHeader) % 8 == 0, "Session sections must stay 8-byte aligned");
+
+// Directory record of a block
+struct BlockRecord {
+    qint64 offset;
+    qint64 count;
+    qint64 compressedSize;   // Bytes of compressed messages after the columns
+    qint64 minTimestamp;
+    qint64 maxTimestamp;
+};
+static_assert(sizeof(BlockRecord) % 8 == 0, "Session sections must stay 8-byte aligned");
+
+// After the blocks follow the string table, the directory, the marks and the
+// filter inputs (as a table of name, value pairs), all located by the trailer
+struct SessionTrailer {
+    char magic[8];
+    quint32 version;
+    quint32 reserved;
+    qint64 entryCount;
+    qint64 blockCount;
+    qint64 tablesOffset;
+    qint64 stringCount;
+    qint64 stringChars;
+    qint64 markCount;
+    qint64 filterStringCount;
+    qint64 filterStringChars;
+};
+static_assert(sizeof(SessionTrailer) % 8 == 0, "Session sections must stay 8-byte aligned");
+
+bool isValidLevel(quint8 level)
+{
+    return level <= static_cast<quint8>(LogLevel::Assert);
+}
+
+} // namespace
+
+LogSession::Reader::Reader()
+    : m_data(nullptr)
+    , m_sectionsEnd(0)
+    , m_entryCount(0)
+{}
+
+bool LogSession::Reader::open(const QString &filePath, QString &errorMsg)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        errorMsg = QString("Failed to open file: %1").arg(m_file.errorString());
+        return false;
+    }
+    
+    const qint64 size = m_file.size();
+    m_data = size >= qint64(sizeof(SessionHeader) + sizeof(SessionTrailer)) ? m_file.map(0, size) : nullptr;
+    if (!m_data) {
+        errorMsg = "Not a session file";
+        return false;
+    }
+    
+    SessionHeader header;
+    SessionTrailer trailer;
+    std::memcpy(&header, m_data, sizeof(header));
+    std::memcpy(&trailer, m_data + size - sizeof(trailer), sizeof(trailer));
+    if (std::memcmp(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0
+        || std::memcmp(trailer.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+        errorMsg = "Not a session file";
+        return false;
+    }
+    if (header.version != SESSION_VERSION || trailer.version != SESSION_VERSION) {
+        errorMsg = QString("Unsupported session version %1").arg(trailer.version);
+        return false;
+    }
+    
+    // Blocks lie between the header and the tables
+    const qint64 tablesEnd = size - qint64(sizeof(trailer));
+    if (trailer.tablesOffset < qint64(sizeof(header)) || trailer.tablesOffset > tablesEnd
+        || trailer.tablesOffset % 8 != 0) {
+        errorMsg = "Corrupt session file: bad table offset";
+        return false;
+    }
+    m_sectionsEnd = trailer.tablesOffset;
+    
+    SectionReader reader(m_data + trailer.tablesOffset, tablesEnd - trailer.tablesOffset);
+    QStringList strings;
+    QStringList filterStrings;
+    const bool tablesRead = readStringTable(reader, trailer.stringCount, trailer.stringChars, strings);
+    const BlockRecord *records = reader.take<BlockRecord>(trailer.blockCount);
+    const qint64 *marks = reader.take<qint64>(trailer.markCount);
+    if (!tablesRead || reader.failed()
+        || !readStringTable(reader, trailer.filterStringCount, trailer.filterStringChars, filterStrings)
+        || filterStrings.size() % 2 != 0) {
+        errorMsg = "Corrupt session file: bad tables";
+        return false;
+    }
+    
+    // Block contents are checked when a block is read, its place in the file here
+    qint64 firstEntry = 0;
+    for (qint64 i = 0; i < trailer.blockCount; ++i) {
+        const BlockRecord &record = records[i];
+        if (record.offset < qint64(sizeof(header)) || record.offset >= m_sectionsEnd || record.offset % 8 != 0
+            || record.count <= 0 || record.count > SESSION_BLOCK_SIZE || record.compressedSize < 0) {
+            errorMsg = "Corrupt session file: bad block directory";
+            return false;
+        }
+        m_blocks.append({firstEntry, record.count, record.minTimestamp, record.maxTimestamp});
+        m_blockOffsets.append(record.offset);
+        m_compressedSizes.append(record.compressedSize);
+        firstEntry += record.count;
+    }
+    if (firstEntry != trailer.entryCount) {
+        errorMsg = "Corrupt session file: entry count mismatch";
+        return false;
+    }
+    m_entryCount = trailer.entryCount;
+    
+    // Tags, packages and sources are interned once per distinct string
+    m_poolIds.reserve(strings.size());
+    for (const QString &string : std::as_const(strings)) {
+        m_poolIds.append(LogStringPool::instance().intern(string));
+    }
+    
+    for (qint64 i = 0; i < trailer.markCount; ++i) {
+        if (marks[i] >= 0 && marks[i] < m_entryCount) {
+            m_state.markedEntries.append(marks[i]);
+        }
+    }
+    for (qsizetype i = 0; i + 1 < filterStrings.size(); i += 2) {
+        m_state.filters.append(qMakePair(filterStrings[i], filterStrings[i + 1]));
+    }
+    
+    errorMsg.clear();
+    return true;
+}
+
+qint64 LogSession::Reader::entryCount() const
+{
+    return m_entryCount;
+}
+
+const QVector<LogSession::Reader::Block> &LogSession::Reader::blocks() const
+{
+    return m_blocks;
+}
+
+const SessionState &LogSession::Reader::state() const
+{
+    return m_state;
+}
+
+bool LogSession::Reader::readBlock(qsizetype block, QVector<LogEntry> &entries) const
+{
+    if (block < 0 || block >= m_blocks.size()) {
+        return false;
+    }
+    
+    // Same order as write() puts the columns
+    const qint64 count = m_blocks[block].count;
+    const qint64 offset = m_blockOffsets[block];
+    SectionReader reader(m_data + offset, m_sectionsEnd - offset);
+    const qint64 *timestamps = reader.take<qint64>(count);
+    const qint32 *pids = reader.take<qint32>(count);
+    const qint32 *tids = reader.take<qint32>(count);
+    const quint32 *tags = reader.take<quint32>(count);
+    const quint32 *packages = reader.take<quint32>(count);
+    const quint32 *sources = reader.take<quint32>(count);
+    const quint8 *levels = reader.take<quint8>(count);
+    const quint32 *messageOffsets = reader.take<quint32>(count + 1);
+    const uchar *compressed = reader.take<uchar>(m_compressedSizes[block]);
+    if (reader.failed()) {
+        return false;
+    }
+    
+    const QByteArray messages = qUncompress(compressed, m_compressedSizes[block]);
+    const qint64 messageChars = messages.size() / qint64(sizeof(QChar));
+    const QChar *chars = reinterpret_cast<const QChar *>(messages.constData());
+    
+    // Check the whole block before adding any of it
+    const quint32 tableSize = static_cast<quint32>(m_poolIds.size());
+    if (messageOffsets[0] != 0 || messageOffsets[count] != messageChars) {
+        return false;
+    }
+    for (qint64 i = 0; i < count; ++i) {
+        if (tags[i] >= tableSize || packages[i] >= tableSize || sources[i] >= tableSize
+            || !isValidLevel(levels[i]) || messageOffsets[i + 1] < messageOffsets[i]) {
+            return false;
+        }
+    }
+    
+    entries.reserve(entries.size() + count);
+    for (qint64 i = 0; i < count; ++i) {
+        LogEntry entry;
+        entry.timestamp = timestamps[i];
+        entry.pid = pids[i];
+        entry.tid = tids[i];
+        entry.tagId = m_poolIds[tags[i]];
+        entry.packageId = m_poolIds[packages[i]];
+        entry.sourceId = m_poolIds[sources[i]];
+        entry.level = static_cast<LogLevel>(levels[i]);
+        entry.message = QString(chars + messageOffsets[i], messageOffsets[i + 1] - messageOffsets[i]);
+        entries.append(std::move(entry));
+    }
+    return true;
+}
+
+bool LogSession::isSessionFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray magic = file.read(sizeof(SESSION_MAGIC));
+    return magic.size() == qsizetype(sizeof(SESSION_MAGIC))
+           && std::memcmp(magic.constData(), SESSION_MAGIC, sizeof(SESSION_MAGIC)) == 0;
+}
+
+bool LogSession::write(const QString &filePath,
+                       qsizetype entryCount,
+                       const FileManager::EntryChunkReader &readChunk,
+                       const SessionState &state,
+                       const FileManager::SaveProgressHandler &onProgress,
+                       QString &errorMsg)
+{
+    if (filePath.isEmpty()) {
+        errorMsg = "File path is empty";
+        return false;
+    }
+    
+    // Nothing replaces the old file unless the new one is complete
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMsg = QString("Failed to open file for writing: %1").arg(file.errorString());
+        return false;
+    }
+    
+    bool ok = true;
+    SessionHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    header.version = SESSION_VERSION;
+    writeSection(file, &header, sizeof(header), ok);
+    
+    // Tags, packages and sources are stored once in the string table
+    QHash<quint32, quint32> tableIndex;
+    QVector<quint32> tableIds;
+    auto indexOf = [&tableIndex, &tableIds](quint32 poolId) {
+        auto it = tableIndex.constFind(poolId);
+        if (it == tableIndex.cend()) {
+            it = tableIndex.insert(poolId, static_cast<quint32>(tableIds.size()));
+            tableIds.append(poolId);
+        }
+        return it.value();
+    };
+    
+    QVector<BlockRecord> records;
+    QVector<LogEntry> logs;
+    for (qsizetype first = 0; first < entryCount && ok; first += SESSION_BLOCK_SIZE) {
+        // Only one block of entries is held at a time
+        const qsizetype count = qMin(SESSION_BLOCK_SIZE, entryCount - first);
+        logs.clear();
+        readChunk(first, count, logs);
+        if (logs.size() != count) {
+            errorMsg = "The entries being saved are no longer available";
+            return false;
+        }
+        QByteArray timestamps;
+        QByteArray pids;
+        QByteArray tids;
+        QByteArray tags;
+        QByteArray packages;
+        QByteArray sources;
+        QByteArray levels;
+        QByteArray messageOffsets;
+        QByteArray messages;
+        
+        BlockRecord record;
+        record.offset = file.pos();
+        record.count = count;
+        record.minTimestamp = LogEntry::NoTimestamp;
+        record.maxTimestamp = LogEntry::NoTimestamp;
+        
+        quint32 messageChars = 0;
+        appendValue<quint32>(messageOffsets, 0);
+        for (qsizetype i = 0; i < count; ++i) {
+            const LogEntry &entry = logs[i];
+            appendValue(timestamps, entry.timestamp);
+            appendValue(pids, entry.pid);
+            appendValue(tids, entry.tid);
+            appendValue(tags, indexOf(entry.tagId));
+            appendValue(packages, indexOf(entry.packageId));
+            appendValue(sources, indexOf(entry.sourceId));
+            appendValue(levels, static_cast<quint8>(entry.level));
+            
+            messages.append(reinterpret_cast<const char *>(entry.message.constData()),
+                            entry.message.size() * sizeof(QChar));
+            messageChars += static_cast<quint32>(entry.message.size());
+            appendValue(messageOffsets, messageChars);
+            
+            if (entry.timestamp != LogEntry::NoTimestamp) {
+                if (record.minTimestamp == LogEntry::NoTimestamp || entry.timestamp < record.minTimestamp) {
+                    record.minTimestamp = entry.timestamp;
+                }
+                if (record.maxTimestamp == LogEntry::NoTimestamp || entry.timestamp > record.maxTimestamp) {
+                    record.maxTimestamp = entry.timestamp;
+                }
+            }
+        }
+        
+        const QByteArray compressed = qCompress(messages, MESSAGE_COMPRESSION_LEVEL);
+        record.compressedSize = compressed.size();
+        
+        // Same order as Reader::readBlock() takes the columns
+        writeSection(file, timestamps.constData(), timestamps.size(), ok);
+        writeSection(file, pids.constData(), pids.size(), ok);
+        writeSection(file, tids.constData(), tids.size(), ok);
+        writeSection(file, tags.constData(), tags.size(), ok);
+        writeSection(file, packages.constData(), packages.size(), ok);
+        writeSection(file, sources.constData(), sources.size(), ok);
+        writeSection(file, levels.constData(), levels.size(), ok);
+        writeSection(file, messageOffsets.constData(), messageOffsets.size(), ok);
+        writeSection(file, compressed.constData(), compressed.size(), ok);
+        records.append(record);
+        
+        if (onProgress) {
+            onProgress(first + count, entryCount);
+        }
+    }
+    
+    QStringList strings;
+    for (quint32 id : std::as_const(tableIds)) {
+        strings.append(id == 0 ? QString() : LogStringPool::instance().at(id));
+    }
+    QStringList filterStrings;
+    for (const auto &filter : state.filters) {
+        filterStrings.append(filter.first);
+        filterStrings.append(filter.second);
+    }
+    
+    SessionTrailer trailer;
+    std::memset(&trailer, 0, sizeof(trailer));
+    std::memcpy(trailer.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    trailer.version = SESSION_VERSION;
+    trailer.entryCount = entryCount;
+    trailer.blockCount = records.size();
+    trailer.tablesOffset = file.pos();
+    trailer.stringCount = strings.size();
+    trailer.stringChars = stringTableChars(strings);
+    trailer.markCount = state.markedEntries.size();
+    trailer.filterStringCount = filterStrings.size();
+    trailer.filterStringChars = stringTableChars(filterStrings);
+    
+    // Same order as Reader::open() takes the tables
+    writeStringTable(file, strings, ok);
+    writeSection(file, records.constData(), records.size() * qint64(sizeof(BlockRecord)), ok);
+    writeSection(file, state.markedEntries.constData(), state.markedEntries.size() * qint64(sizeof(qint64)), ok);
+    writeStringTable(file, filterStrings, ok);
+    writeSection(file, &trailer, sizeof(trailer), ok);
+    
+    if (!ok || !file.commit()) {
+        errorMsg = QString("Failed to write file: %1").arg(file.errorString());
+        file.cancelWriting();
+        return false;
+    }
+    
+    errorMsg.clear();
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef LOGSESSION_H
+#define LOGSESSION_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QFile>
+#include "logentry.h"
+#include "filemanager.h"
+
+/**
+ * Marks and filter inputs saved with a session
+ */
+struct SessionState {
+    QVector<qint64> markedEntries;           // Positions of marked entries in the saved order
+    QList<QPair<QString, QString>> filters;  // Filter inputs by name
+};
+
+/**
+ * Native session files, a capture saved without losing information
+ * Unlike threadtime text, entries keep their full timestamp (including the year),
+ * resolved packages and source file. Entries are stored in blocks; within a block
+ * the fields are columns (timestamps, levels, PIDs, TIDs, string table IDs for
+ * tags, packages and sources) and the messages are compressed together. A
+ * directory at the end of the file locates every block, so any block can be read
+ * on its own from the memory-mapped file
+ */
+class LogSession
+{
+public:
+    // Suggested extension, sessions are recognised by their contents
+    static const QString FILE_EXTENSION;
+    
+    /**
+     * Reads the blocks of a session file
+     * All methods are const and can be called from several threads at once
+     */
+    class Reader
+    {
+    public:
+        // Entries of a block, known without decoding it
+        struct Block {
+            qint64 firstEntry;
+            qint64 count;
+            qint64 minTimestamp;  // LogEntry::NoTimestamp if no entry has one
+            qint64 maxTimestamp;
+        };
+        
+        Reader();
+        
+        // Delete copy constructor and assignment operator
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        
+        /**
+         * Map a session file and read its directory, string table and state
+         * @param filePath Path to the session file
+         * @param errorMsg Output parameter for error messages
+         * @return false if the file is not a valid session
+         */
+        bool open(const QString &filePath, QString &errorMsg);
+        
+        qint64 entryCount() const;
+        const QVector<Block> &blocks() const;
+        const SessionState &state() const;
+        
+        /**
+         * Decode one block
+         * @param block Index into blocks()
+         * @param entries Receives the entries of the block, appended
+         * @return false if the block is corrupt
+         */
+        bool readBlock(qsizetype block, QVector<LogEntry> &entries) const;
+    
+    private:
+        QFile m_file;
+        const uchar *m_data;
+        qint64 m_sectionsEnd;          // End of the blocks
+        qint64 m_entryCount;
+        QVector<Block> m_blocks;
+        QVector<qint64> m_blockOffsets;
+        QVector<qint64> m_compressedSizes;
+        QVector<quint32> m_poolIds;    // String table index -> LogStringPool ID
+        SessionState m_state;
+    };
+    
+    // Check the magic bytes at the start of a file
+    static bool isSessionFile(const QString &filePath);
+    
+    /**
+     * Write a session file
+     * @param filePath Path where to save the session
+     * @param entryCount Number of entries to save
+     * @param readChunk Supplies the entries one block at a time, oldest first
+     * @param state Marks and filter inputs to save with the entries
+     * @param onProgress Optional, called after each written block
+     * @param errorMsg Output parameter for error messages
+     * @return true if the file was written completely
+     */
+    static bool write(const QString &filePath,
+                      qsizetype entryCount,
+                      const FileManager::EntryChunkReader &readChunk,
+                      const SessionState &state,
+                      const FileManager::SaveProgressHandler &onProgress,
+                      QString &errorMsg);
+};
+
+#endif // LOGSESSION_H
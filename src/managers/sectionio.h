@@ -0,0 +1,120 @@
+#ifndef SECTIONIO_H
+#define SECTIONIO_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Helpers for binary files made of sections written one after another
+ * Every section is padded to 8 bytes, so the columns of a memory-mapped file
+ * can be read in place. Used by LogCache and LogSession
+ */
+
+inline qint64 paddedSize(qint64 bytes)
+{
+    return (bytes + 7) & ~qint64(7);
+}
+
+template <typename T>
+void appendValue(QByteArray &column, T value)
+{
+    column.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Pad a section to 8 bytes so every column of the mapped file is aligned
+inline void writePadding(QIODevice &device, qint64 sectionBytes, bool &ok)
+{
+    static const char padding[8] = {};
+    const qint64 bytes = paddedSize(sectionBytes) - sectionBytes;
+    if (bytes > 0 && device.write(padding, bytes) != bytes) {
+        ok = false;
+    }
+}
+
+inline void writeSection(QIODevice &device, const void *data, qint64 bytes, bool &ok)
+{
+    if (bytes > 0 && device.write(static_cast<const char *>(data), bytes) != bytes) {
+        ok = false;
+    }
+    writePadding(device, bytes, ok);
+}
+
+// Offsets into the character blob followed by the blob, both in UTF-16 code units
+inline void writeStringTable(QIODevice &device, const QStringList &strings, bool &ok)
+{
+    QByteArray offsets;
+    QByteArray chars;
+    qint64 length = 0;
+    appendValue<qint64>(offsets, 0);
+    for (const QString &string : strings) {
+        chars.append(reinterpret_cast<const char *>(string.constData()), string.size() * sizeof(QChar));
+        length += string.size();
+        appendValue<qint64>(offsets, length);
+    }
+    writeSection(device, offsets.constData(), offsets.size(), ok);
+    writeSection(device, chars.constData(), chars.size(), ok);
+}
+
+// UTF-16 code units written by writeStringTable()
+inline qint64 stringTableChars(const QStringList &strings)
+{
+    qint64 chars = 0;
+    for (const QString &string : strings) {
+        chars += string.size();
+    }
+    return chars;
+}
+
+// Walks the sections of a mapped file in the order they were written
+class SectionReader
+{
+public:
+    SectionReader(const uchar *data, qint64 size)
+        : m_data(data)
+        , m_size(size)
+        , m_pos(0)
+        , m_failed(false)
+    {}
+    
+    // Next section of count values, null if the file is too short
+    template <typename T>
+    const T *take(qint64 count) {
+        if (m_failed || count < 0 || count > (m_size - m_pos) / qint64(sizeof(T))) {
+            m_failed = true;
+            return nullptr;
+        }
+        const T *section = reinterpret_cast<const T *>(m_data + m_pos);
+        m_pos = qMin(m_size, m_pos + paddedSize(count * qint64(sizeof(T))));
+        return section;
+    }
+    
+    bool failed() const { return m_failed; }
+
+private:
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_pos;
+    bool m_failed;
+};
+
+// Read a table written by writeStringTable(), false if it is malformed
+inline bool readStringTable(SectionReader &reader, qint64 stringCount, qint64 stringChars, QStringList &strings)
+{
+    const qint64 *offsets = reader.take<qint64>(stringCount + 1);
+    const char16_t *chars = reader.take<char16_t>(stringChars);
+    if (reader.failed()) {
+        return false;
+    }
+    
+    for (qint64 i = 0; i < stringCount; ++i) {
+        if (offsets[i] < 0 || offsets[i] > offsets[i + 1] || offsets[i + 1] > stringChars) {
+            return false;
+        }
+        strings.append(QString(reinterpret_cast<const QChar *>(chars + offsets[i]), offsets[i + 1] - offsets[i]));
+    }
+    return true;
+}
+
+#endif // SECTIONIO_H
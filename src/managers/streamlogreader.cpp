@@ -0,0 +1,204 @@
+#include "streamlogreader.h"
+#include <QSocketNotifier>
+#include <QLocalSocket>
+#include <QFile>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Data is read in steps of this size
+const qsizetype READ_BLOCK_SIZE = 256 * 1024;
+
+// A fast writer is parsed at least every this many bytes, so batches stay small
+// enough to keep the GUI responsive
+const qsizetype MAX_READ_BYTES = 4 * 1024 * 1024;
+
+const int CONNECT_TIMEOUT_MS = 3000;
+
+} // namespace
+
+StreamLogReader::StreamLogReader(Source source, const QString &path,
+                                 const QVector<LogConverterPtr> &converters, LogBatchQueue *queue)
+    : QObject(nullptr)
+    , m_source(source)
+    , m_path(path)
+    , m_converters(converters)
+    , m_queue(queue)
+    , m_fd(-1)
+    , m_fifoWriter(-1)
+    , m_notifier(nullptr)
+    , m_socket(nullptr)
+{}
+
+StreamLogReader::~StreamLogReader()
+{
+    stop();
+}
+
+bool StreamLogReader::start()
+{
+    if (m_source != Source::LocalSocket) {
+        return openDescriptor();
+    }
+    
+    m_socket = new QLocalSocket(this);
+    connect(m_socket, &QLocalSocket::readyRead, this, &StreamLogReader::readSocket);
+    connect(m_socket, &QLocalSocket::disconnected, this, [this]() {
+        // Keep whatever was written last, even without a trailing newline
+        m_buffer.append(m_socket->readAll());
+        convertLines(true);
+        emit finished();
+    });
+    
+    m_socket->connectToServer(m_path, QIODevice::ReadOnly);
+    if (!m_socket->waitForConnected(CONNECT_TIMEOUT_MS)) {
+        m_errorString = QString("Failed to connect to %1: %2").arg(m_path, m_socket->errorString());
+        closeStream();
+        return false;
+    }
+    return true;
+}
+
+void StreamLogReader::stop()
+{
+    closeStream();
+    m_buffer.clear();
+}
+
+QString StreamLogReader::errorString() const
+{
+    return m_errorString;
+}
+
+bool StreamLogReader::openDescriptor()
+{
+#ifdef Q_OS_UNIX
+    if (m_source == Source::Stdin) {
+        m_fd = STDIN_FILENO;
+    } else {
+        // Non-blocking, so opening doesn't wait for a writer
+        m_fd = ::open(QFile::encodeName(m_path).constData(), O_RDONLY | O_NONBLOCK);
+        if (m_fd < 0) {
+            m_errorString = QString("Failed to open %1: %2").arg(m_path, QString::fromLocal8Bit(std::strerror(errno)));
+            return false;
+        }
+        
+        // Holding a write end ourselves means the pipe never reaches end of file,
+        // so a wrapper can be restarted without ending the stream
+        m_fifoWriter = ::open(QFile::encodeName(m_path).constData(), O_WRONLY | O_NONBLOCK);
+    }
+    
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &StreamLogReader::readDescriptor);
+    return true;
+#else
+    m_errorString = "Reading standard input or a named pipe is only supported on Unix";
+    return false;
+#endif
+}
+
+void StreamLogReader::readDescriptor()
+{
+#ifdef Q_OS_UNIX
+    // Standard input is shared with the shell and the rest of the pipeline, so it keeps
+    // its blocking mode and only the bytes available are read. The first read follows
+    // the notifier and returns at once, with data or with 0 at end of file
+    bool atEnd = false;
+    qsizetype bytesRead = 0;
+    for (bool first = true; bytesRead < MAX_READ_BYTES; first = false) {
+        int available = 0;
+        if (::ioctl(m_fd, FIONREAD, &available) < 0) {
+            available = 0;
+        }
+        if (available <= 0 && !first) {
+            break;
+        }
+        const qsizetype blockSize = available > 0 ? qMin<qsizetype>(available, READ_BLOCK_SIZE) : READ_BLOCK_SIZE;
+        
+        const qsizetype size = m_buffer.size();
+        m_buffer.resize(size + blockSize);
+        const ssize_t bytes = ::read(m_fd, m_buffer.data() + size, blockSize);
+        m_buffer.resize(size + qMax<ssize_t>(bytes, 0));
+        if (bytes > 0) {
+            bytesRead += bytes;
+            continue;
+        }
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            emit errorOccurred(QString("Failed to read %1: %2")
+                                   .arg(m_source == Source::Stdin ? QString("standard input") : m_path,
+                                        QString::fromLocal8Bit(std::strerror(errno))));
+            atEnd = true;
+        }
+        atEnd = atEnd || bytes == 0;
+        break;
+    }
+    
+    convertLines(atEnd);
+    if (atEnd) {
+        closeStream();
+        emit finished();
+    }
+#endif
+}
+
+void StreamLogReader::readSocket()
+{
+    m_buffer.append(m_socket->readAll());
+    convertLines(false);
+}
+
+void StreamLogReader::closeStream()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    
+    if (m_socket) {
+        disconnect(m_socket, nullptr, this, nullptr);
+        m_socket->abort();
+        delete m_socket;
+        m_socket = nullptr;
+    }
+
+#ifdef Q_OS_UNIX
+    if (m_fd >= 0) {
+        // Standard input stays open
+        if (m_source != Source::Stdin) {
+            ::close(m_fd);
+        }
+        m_fd = -1;
+    }
+    if (m_fifoWriter >= 0) {
+        ::close(m_fifoWriter);
+        m_fifoWriter = -1;
+    }
+#endif
+}
+
+void StreamLogReader::convertLines(bool flushPartialLine)
+{
+    // Keep the incomplete last line for the next read
+    const qsizetype end = flushPartialLine ? m_buffer.size() : m_buffer.lastIndexOf('\n') + 1;
+    if (end == 0) {
+        return;
+    }
+    
+    QVector<LogEntry> batch = m_fileManager.readFromBuffer(QByteArrayView(m_buffer.constData(), end),
+                                                           m_converters);
+    m_buffer.remove(0, end);
+    
+    // One queue push and one queued signal per read, not per line
+    if (!batch.isEmpty()) {
+        m_queue->push(std::move(batch));
+        emit entriesAvailable();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef STREAMLOGREADER_H
+#define STREAMLOGREADER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include "ilogconverter.h"
+#include "filemanager.h"
+#include "logcatreader.h"
+
+class QSocketNotifier;
+class QLocalSocket;
+
+/**
+ * Reads log lines piped in from outside on a worker thread
+ * For output of adb wrappers or ssh tunnels: standard input, a named pipe or a
+ * local (Unix domain) socket. Lines are parsed per read and pushed as batches
+ * to a queue read by the GUI thread, like LogcatReader does. Must be moved to
+ * its thread before start() is called, the notifier or socket is created there
+ */
+class StreamLogReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Source {
+        Stdin,
+        Fifo,
+        LocalSocket
+    };
+    
+    /**
+     * @param source Kind of stream
+     * @param path Named pipe path or socket name, unused for standard input
+     * @param converters Converters for the lines, preferred format first;
+     *                   only used on the reader's thread
+     * @param queue Destination for parsed batches, this reader is its only producer
+     */
+    StreamLogReader(Source source, const QString &path,
+                    const QVector<LogConverterPtr> &converters, LogBatchQueue *queue);
+    ~StreamLogReader() override;
+    
+    /**
+     * Open the stream and start reading
+     * @return True if the stream could be opened, see errorString() otherwise
+     */
+    bool start();
+    
+    // Close the stream without emitting finished()
+    void stop();
+    
+    // Reason start() failed
+    QString errorString() const;
+
+signals:
+    // Emitted after one or more batches were pushed to the queue
+    void entriesAvailable();
+    void errorOccurred(const QString &error);
+    
+    // The writer closed the stream
+    void finished();
+
+private:
+    bool openDescriptor();
+    void readDescriptor();
+    void readSocket();
+    void closeStream();
+    void convertLines(bool flushPartialLine);
+    
+    Source m_source;
+    QString m_path;
+    QVector<LogConverterPtr> m_converters;
+    LogBatchQueue *m_queue;
+    FileManager m_fileManager;
+    QString m_errorString;
+    int m_fd;                     // Standard input or the named pipe
+    int m_fifoWriter;             // Keeps a named pipe open between writers
+    QSocketNotifier *m_notifier;
+    QLocalSocket *m_socket;
+    QByteArray m_buffer;          // Data not yet split into lines
+};
+
+#endif // STREAMLOGREADER_H
@@ -1,42 +1,50 @@
 #include "logmodel.h"
 #include <QFont>
+#include <algorithm>
 
 LogModel::LogModel(QObject *parent)
     : QAbstractTableModel(parent)
-    , m_markedRows(nullptr)
+    , m_source(nullptr)
+    , m_head(0)
+    , m_markedSequences(nullptr)
 {}
 
 int LogModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-    return m_logs.size();
+    return m_rows.size() - m_head;
 }
 
 int LogModel::columnCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-    return 8; // Date, Time, PID, TID, Package, Lvl, Tag, Message
+    return 9; // Date, Time, PID, TID, Package, Lvl, Tag, Message, Source
 }
 
 QVariant LogModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() >= m_logs.size())
+    if (!index.isValid() || index.row() >= rowCount() || !m_source)
         return QVariant();
 
-    const LogEntry &entry = m_logs[index.row()];
+    const quint32 sequence = m_rows[m_head + index.row()];
+    if (!m_source->contains(sequence))
+        return QVariant();
+
+    const LogEntry entry = m_source->entry(sequence);
 
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
-            case 0: return entry.date;
-            case 1: return entry.time;
-            case 2: return entry.pid;
-            case 3: return entry.tid;
-            case 4: return entry.package;
-            case 5: return entry.level;
-            case 6: return entry.tag;
+            case 0: return entry.date();
+            case 1: return entry.time();
+            case 2: return entry.pidText();
+            case 3: return entry.tidText();
+            case 4: return entry.package();
+            case 5: return entry.levelText();
+            case 6: return entry.tag();
             case 7: return entry.message;
+            case 8: return entry.source();
         }
     }
     else if (role == Qt::TextAlignmentRole && index.column() == 0) {
@@ -55,7 +63,7 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
     }
     else if (role == Qt::BackgroundRole) {
         // Highlight marked rows
-        if (m_markedRows && m_markedRows->contains(index.row())) {
+        if (m_markedSequences && m_markedSequences->contains(sequence)) {
             return QColor("#30567a"); // Slightly lighter than normal for marked rows
         }
     }
@@ -78,6 +86,7 @@ QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role
             case 5: return "Lvl";
             case 6: return "Tag";
             case 7: return "Message";
+            case 8: return "Source";
         }
     }
     else {
@@ -87,54 +96,119 @@ QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role
     return QVariant();
 }
 
-void LogModel::setLogs(const QVector<LogEntry> &logs)
+void LogModel::setSource(const ILogSource *logs)
+{
+    beginResetModel();
+    m_source = logs;
+    m_rows.clear();
+    m_head = 0;
+    endResetModel();
+}
+
+void LogModel::setRows(QVector<quint32> sequences)
 {
     beginResetModel();
-    m_logs = logs;
+    m_rows = std::move(sequences);
+    m_head = 0;
     endResetModel();
 }
 
-void LogModel::addLog(const LogEntry &entry)
+void LogModel::appendRows(const QVector<quint32> &sequences)
 {
-    int row = m_logs.size();
-    beginInsertRows(QModelIndex(), row, row);
-    m_logs.append(entry);
+    if (sequences.isEmpty()) {
+        return;
+    }
+
+    // One insert notification for the whole batch
+    int first = rowCount();
+    beginInsertRows(QModelIndex(), first, first + sequences.size() - 1);
+    m_rows.append(sequences);
     endInsertRows();
 }
 
+void LogModel::removeEvictedRows()
+{
+    if (!m_source) {
+        return;
+    }
+
+    // Rows are in store order, so evicted entries are always at the top
+    int count = 0;
+    while (m_head + count < m_rows.size() && !m_source->contains(m_rows[m_head + count])) {
+        ++count;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // Only the head moves; shifting the vector on every flush would cost all rows each time
+    beginRemoveRows(QModelIndex(), 0, count - 1);
+    m_head += count;
+    if (m_head * 2 >= m_rows.size()) {
+        m_rows.remove(0, m_head);
+        m_head = 0;
+    }
+    endRemoveRows();
+}
+
 void LogModel::clear()
 {
     beginResetModel();
-    m_logs.clear();
+    m_rows.clear();
+    m_head = 0;
     endResetModel();
 }
 
-const LogEntry& LogModel::getLogEntry(int row) const
+LogEntry LogModel::getLogEntry(int row) const
+{
+    return m_source->entry(m_rows[m_head + row]);
+}
+
+quint32 LogModel::getSequence(int row) const
 {
-    return m_logs[row];
+    return m_rows[m_head + row];
+}
+
+int LogModel::findRow(quint32 sequence) const
+{
+    if (!m_source || !m_source->contains(sequence)) {
+        return -1;
+    }
+
+    // Binary search on the position in the store, raw sequence numbers may wrap
+    const quint32 offset = m_source->offsetOf(sequence);
+    const auto first = m_rows.cbegin() + m_head;
+    auto it = std::lower_bound(first, m_rows.cend(), offset,
+                               [this](quint32 row, quint32 target) {
+        return m_source->offsetOf(row) < target;
+    });
+    if (it == m_rows.cend() || *it != sequence) {
+        return -1; // Hidden by the current filter
+    }
+    return static_cast<int>(it - first);
 }
 
 int LogModel::getLogCount() const
 {
-    return m_logs.size();
+    return rowCount();
 }
 
-void LogModel::setMarkedRows(const QSet<int> *markedRows)
+void LogModel::setMarkedSequences(const QSet<quint32> *markedSequences)
 {
-    m_markedRows = markedRows;
+    m_markedSequences = markedSequences;
     // Trigger repaint of all rows
-    if (!m_logs.isEmpty()) {
-        emit dataChanged(index(0, 0), index(m_logs.size() - 1, columnCount() - 1));
+    if (rowCount() > 0) {
+        emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
     }
 }
 
-QColor LogModel::getLevelColor(const QString &level) const
+QColor LogModel::getLevelColor(LogLevel level) const
 {
-    if (level == "V") return QColor("#9ca3af"); // Verbose - Gray
-    if (level == "D") return QColor("#60a5fa"); // Debug - Blue
-    if (level == "I") return QColor("#34d399"); // Info - Green
-    if (level == "W") return QColor("#fbbf24"); // Warn - Yellow
-    if (level == "E") return QColor("#f87171"); // Error - Red
-    if (level == "A") return QColor("#c084fc"); // Assert - Purple
+    if (level == LogLevel::Verbose) return QColor("#9ca3af"); // Verbose - Gray
+    if (level == LogLevel::Debug) return QColor("#60a5fa"); // Debug - Blue
+    if (level == LogLevel::Info) return QColor("#34d399"); // Info - Green
+    if (level == LogLevel::Warn) return QColor("#fbbf24"); // Warn - Yellow
+    if (level == LogLevel::Error) return QColor("#f87171"); // Error - Red
+    if (level == LogLevel::Assert) return QColor("#c084fc"); // Assert - Purple
     return QColor("#CCCCCC");
 }
@@ -6,6 +6,7 @@
 #include <QColor>
 #include <QSet>
 #include "ilogconverter.h"
+#include "ilogsource.h"
 
 class LogModel : public QAbstractTableModel
 {
@@ -20,17 +21,23 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     // Custom methods
-    void setLogs(const QVector<LogEntry> &logs);
-    void addLog(const LogEntry &entry);
+    void setSource(const ILogSource *logs);
+    void setRows(QVector<quint32> sequences);
+    void appendRows(const QVector<quint32> &sequences);
+    void removeEvictedRows();
     void clear();
-    const LogEntry& getLogEntry(int row) const;
+    LogEntry getLogEntry(int row) const;
+    quint32 getSequence(int row) const;
+    int findRow(quint32 sequence) const;
     int getLogCount() const;
-    void setMarkedRows(const QSet<int> *markedRows);
+    void setMarkedSequences(const QSet<quint32> *markedSequences);
 
 private:
-    QVector<LogEntry> m_logs;
-    const QSet<int> *m_markedRows;
-    QColor getLevelColor(const QString &level) const;
+    const ILogSource *m_source;    // Owned by the caller, rows refer to it by sequence number
+    QVector<quint32> m_rows;       // Sequence number of each visible row from m_head on, oldest first
+    qsizetype m_head;              // Rows before it were evicted, dropped once they are half of m_rows
+    const QSet<quint32> *m_markedSequences;
+    QColor getLevelColor(LogLevel level) const;
 };
 
 #endif // LOGMODEL_H
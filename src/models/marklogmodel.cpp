@@ -17,7 +17,7 @@ int MarkLogModel::columnCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-    return 8; // Date, Time, PID, TID, Package, Lvl, Tag, Message
+    return 9; // Date, Time, PID, TID, Package, Lvl, Tag, Message, Source
 }
 
 QVariant MarkLogModel::data(const QModelIndex &index, int role) const
@@ -29,14 +29,15 @@ QVariant MarkLogModel::data(const QModelIndex &index, int role) const
 
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
-            case 0: return entry.date;
-            case 1: return entry.time;
-            case 2: return entry.pid;
-            case 3: return entry.tid;
-            case 4: return entry.package;
-            case 5: return entry.level;
-            case 6: return entry.tag;
+            case 0: return entry.date();
+            case 1: return entry.time();
+            case 2: return entry.pidText();
+            case 3: return entry.tidText();
+            case 4: return entry.package();
+            case 5: return entry.levelText();
+            case 6: return entry.tag();
             case 7: return entry.message;
+            case 8: return entry.source();
         }
     }
     else if (role == Qt::TextAlignmentRole && index.column() == 0) {
@@ -72,6 +73,7 @@ QVariant MarkLogModel::headerData(int section, Qt::Orientation orientation, int
             case 5: return "Lvl";
             case 6: return "Tag";
             case 7: return "Message";
+            case 8: return "Source";
         }
     }
     else {
@@ -81,23 +83,23 @@ QVariant MarkLogModel::headerData(int section, Qt::Orientation orientation, int
     return QVariant();
 }
 
-void MarkLogModel::addMarkedLog(const LogEntry &entry, int originalIndex)
+void MarkLogModel::addMarkedLog(const LogEntry &entry, quint32 sequence)
 {
     // Check if already marked
     for (const MarkedLogEntry &marked : m_markedLogs) {
-        if (marked.originalIndex == originalIndex) {
+        if (marked.sequence == sequence) {
             return; // Already marked
         }
     }
 
     MarkedLogEntry markedEntry;
     markedEntry.entry = entry;
-    markedEntry.originalIndex = originalIndex;
+    markedEntry.sequence = sequence;
     
     // Find the correct position to insert based on time (sorted order)
     int insertPos = 0;
     for (int i = 0; i < m_markedLogs.size(); ++i) {
-        if (entry.time < m_markedLogs[i].entry.time) {
+        if (entry.msecsOfDay() < m_markedLogs[i].entry.msecsOfDay()) {
             insertPos = i;
             break;
         }
@@ -109,10 +111,10 @@ void MarkLogModel::addMarkedLog(const LogEntry &entry, int originalIndex)
     endInsertRows();
 }
 
-void MarkLogModel::removeMarkedLog(int originalIndex)
+void MarkLogModel::removeMarkedLog(quint32 sequence)
 {
     for (int i = 0; i < m_markedLogs.size(); ++i) {
-        if (m_markedLogs[i].originalIndex == originalIndex) {
+        if (m_markedLogs[i].sequence == sequence) {
             beginRemoveRows(QModelIndex(), i, i);
             m_markedLogs.removeAt(i);
             endRemoveRows();
@@ -121,22 +123,19 @@ void MarkLogModel::removeMarkedLog(int originalIndex)
     }
 }
 
-bool MarkLogModel::isMarked(int originalIndex) const
+bool MarkLogModel::isMarked(quint32 sequence) const
 {
     for (const MarkedLogEntry &marked : m_markedLogs) {
-        if (marked.originalIndex == originalIndex) {
+        if (marked.sequence == sequence) {
             return true;
         }
     }
     return false;
 }
 
-int MarkLogModel::getOriginalIndex(int row) const
+quint32 MarkLogModel::getSequence(int row) const
 {
-    if (row >= 0 && row < m_markedLogs.size()) {
-        return m_markedLogs[row].originalIndex;
-    }
-    return -1;
+    return m_markedLogs[row].sequence;
 }
 
 void MarkLogModel::clear()
@@ -151,13 +150,13 @@ int MarkLogModel::getMarkedCount() const
     return m_markedLogs.size();
 }
 
-QColor MarkLogModel::getLevelColor(const QString &level) const
+QColor MarkLogModel::getLevelColor(LogLevel level) const
 {
-    if (level == "V") return QColor("#9ca3af");      // Gray
-    else if (level == "D") return QColor("#60a5fa"); // Blue
-    else if (level == "I") return QColor("#34d399"); // Green
-    else if (level == "W") return QColor("#fbbf24"); // Yellow
-    else if (level == "E") return QColor("#f87171"); // Red
-    else if (level == "A") return QColor("#c084fc"); // Purple
+    if (level == LogLevel::Verbose) return QColor("#9ca3af");      // Gray
+    else if (level == LogLevel::Debug) return QColor("#60a5fa"); // Blue
+    else if (level == LogLevel::Info) return QColor("#34d399"); // Green
+    else if (level == LogLevel::Warn) return QColor("#fbbf24"); // Yellow
+    else if (level == LogLevel::Error) return QColor("#f87171"); // Red
+    else if (level == LogLevel::Assert) return QColor("#c084fc"); // Purple
     return QColor("#cccccc");
 }
@@ -8,7 +8,7 @@
 
 struct MarkedLogEntry {
     LogEntry entry;
-    int originalIndex; // Index in the main log table
+    quint32 sequence; // Sequence number of the entry in the main log table
 };
 
 class MarkLogModel : public QAbstractTableModel
@@ -24,16 +24,16 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     // Custom methods
-    void addMarkedLog(const LogEntry &entry, int originalIndex);
-    void removeMarkedLog(int originalIndex);
-    bool isMarked(int originalIndex) const;
-    int getOriginalIndex(int row) const;
+    void addMarkedLog(const LogEntry &entry, quint32 sequence);
+    void removeMarkedLog(quint32 sequence);
+    bool isMarked(quint32 sequence) const;
+    quint32 getSequence(int row) const;
     void clear();
     int getMarkedCount() const;
 
 private:
     QVector<MarkedLogEntry> m_markedLogs;
-    QColor getLevelColor(const QString &level) const;
+    QColor getLevelColor(LogLevel level) const;
 };
 
 #endif // MARKLOGMODEL_H
@@ -1,4 +1,5 @@
 #include "propertiesmodel.h"
+#include <QFont>
 
 PropertiesModel::PropertiesModel(QObject *parent)
     : QAbstractTableModel(parent), m_isFiltered(false)
@@ -38,6 +39,12 @@ QVariant PropertiesModel::data(const QModelIndex &index, int role) const
         default: return QVariant();
         }
     }
+    else if (role == Qt::FontRole && index.column() == 2 && m_pending.contains(entry.property)) {
+        // Edited values not yet applied are bold
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
 
     return QVariant();
 }
@@ -95,7 +102,13 @@ bool PropertiesModel::setData(const QModelIndex &index, const QVariant &value, i
         }
     }
     
-    emit dataChanged(index, index, {role});
+    const int previousCount = m_pending.size();
+    m_pending.insert(properties[index.row()].property);
+    
+    emit dataChanged(index, index, {role, Qt::FontRole});
+    if (m_pending.size() != previousCount) {
+        emit pendingCountChanged(m_pending.size());
+    }
     return true;
 }
 
@@ -105,7 +118,14 @@ void PropertiesModel::setProperties(const QVector<PropertyEntry> &properties)
     m_allProperties = properties;
     m_filteredProperties.clear();
     m_isFiltered = false;
+    
+    // Edits belong to the properties they were made on
+    const bool hadPending = !m_pending.isEmpty();
+    m_pending.clear();
     endResetModel();
+    if (hadPending) {
+        emit pendingCountChanged(0);
+    }
 }
 
 void PropertiesModel::updateProperties(const QVector<PropertyEntry> &properties)
@@ -121,8 +141,10 @@ void PropertiesModel::updateProperties(const QVector<PropertyEntry> &properties)
         // Find existing entry by property name
         for (int i = 0; i < m_allProperties.size(); ++i) {
             if (m_allProperties[i].property == newEntry.property) {
-                // Update existing entry
-                m_allProperties[i].value = newEntry.value;
+                // Update existing entry, keeping values edited but not yet applied
+                if (!m_pending.contains(newEntry.property)) {
+                    m_allProperties[i].value = newEntry.value;
+                }
                 m_allProperties[i].line = newEntry.line;
                 found = true;
                 break;
@@ -150,6 +172,38 @@ const QVector<PropertyEntry>& PropertiesModel::getProperties() const
     return m_allProperties;
 }
 
+QVector<PropertyEntry> PropertiesModel::pendingChanges() const
+{
+    QVector<PropertyEntry> changes;
+    for (const PropertyEntry &entry : m_allProperties) {
+        if (m_pending.contains(entry.property)) {
+            changes.append(entry);
+        }
+    }
+    return changes;
+}
+
+int PropertiesModel::pendingCount() const
+{
+    return m_pending.size();
+}
+
+void PropertiesModel::clearPending(const QString &property)
+{
+    if (!m_pending.remove(property)) {
+        return;
+    }
+    
+    const QVector<PropertyEntry> &properties = m_isFiltered ? m_filteredProperties : m_allProperties;
+    for (int i = 0; i < properties.size(); ++i) {
+        if (properties[i].property == property) {
+            emit dataChanged(index(i, 2), index(i, 2), {Qt::FontRole});
+            break;
+        }
+    }
+    emit pendingCountChanged(m_pending.size());
+}
+
 void PropertiesModel::applyFilter(const QString &filterText)
 {
     beginResetModel();
@@ -4,6 +4,7 @@
 #include <QAbstractTableModel>
 #include <QVector>
 #include <QString>
+#include <QSet>
 #include "iconfigfilter.h"
 #include "configfilter.h"
 #include "propertyentry.h"
@@ -26,15 +27,24 @@ public:
     void updateProperties(const QVector<PropertyEntry> &properties);  // Update values without clearing filter
     const QVector<PropertyEntry>& getProperties() const;
     
+    // Values edited since they were fetched or last applied, not yet on the device
+    QVector<PropertyEntry> pendingChanges() const;
+    int pendingCount() const;
+    void clearPending(const QString &property);
+    
     void applyFilter(const QString &filterText);
     void clearFilter();
 
+signals:
+    void pendingCountChanged(int count);
+
 private:
     QVector<PropertyEntry> m_allProperties;
     QVector<PropertyEntry> m_filteredProperties;
     ConfigFilter m_filter;
     bool m_isFiltered;
     QString m_currentFilterText;  // Store current filter text to reapply after update
+    QSet<QString> m_pending;      // Names of the edited properties
 };
 
 #endif // PROPERTIESMODEL_H
@@ -1,4 +1,5 @@
 #include "settingsmodel.h"
+#include <QFont>
 
 SettingsModel::SettingsModel(QObject *parent)
     : QAbstractTableModel(parent), m_isFiltered(false)
@@ -39,6 +40,12 @@ QVariant SettingsModel::data(const QModelIndex &index, int role) const
         default: return QVariant();
         }
     }
+    else if (role == Qt::FontRole && index.column() == 3 && m_pending.contains(pendingKey(entry))) {
+        // Edited values not yet applied are bold
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
 
     return QVariant();
 }
@@ -97,7 +104,13 @@ bool SettingsModel::setData(const QModelIndex &index, const QVariant &value, int
         }
     }
     
-    emit dataChanged(index, index, {role});
+    const int previousCount = m_pending.size();
+    m_pending.insert(pendingKey(settings[index.row()]));
+    
+    emit dataChanged(index, index, {role, Qt::FontRole});
+    if (m_pending.size() != previousCount) {
+        emit pendingCountChanged(m_pending.size());
+    }
     return true;
 }
 
@@ -107,7 +120,14 @@ void SettingsModel::setSettings(const QVector<SettingEntry> &settings)
     m_allSettings = settings;
     m_filteredSettings.clear();
     m_isFiltered = false;
+    
+    // Edits belong to the settings they were made on
+    const bool hadPending = !m_pending.isEmpty();
+    m_pending.clear();
     endResetModel();
+    if (hadPending) {
+        emit pendingCountChanged(0);
+    }
 }
 
 void SettingsModel::updateSettings(const QVector<SettingEntry> &settings)
@@ -124,8 +144,10 @@ void SettingsModel::updateSettings(const QVector<SettingEntry> &settings)
         for (int i = 0; i < m_allSettings.size(); ++i) {
             if (m_allSettings[i].group == newEntry.group && 
                 m_allSettings[i].setting == newEntry.setting) {
-                // Update existing entry
-                m_allSettings[i].value = newEntry.value;
+                // Update existing entry, keeping values edited but not yet applied
+                if (!m_pending.contains(pendingKey(newEntry))) {
+                    m_allSettings[i].value = newEntry.value;
+                }
                 m_allSettings[i].line = newEntry.line;
                 found = true;
                 break;
@@ -153,6 +175,47 @@ const QVector<SettingEntry>& SettingsModel::getSettings() const
     return m_allSettings;
 }
 
+QVector<SettingEntry> SettingsModel::pendingChanges() const
+{
+    QVector<SettingEntry> changes;
+    for (const SettingEntry &entry : m_allSettings) {
+        if (m_pending.contains(pendingKey(entry))) {
+            changes.append(entry);
+        }
+    }
+    return changes;
+}
+
+int SettingsModel::pendingCount() const
+{
+    return m_pending.size();
+}
+
+void SettingsModel::clearPending(const QString &group, const QString &setting)
+{
+    SettingEntry entry;
+    entry.group = group;
+    entry.setting = setting;
+    if (!m_pending.remove(pendingKey(entry))) {
+        return;
+    }
+    
+    const QVector<SettingEntry> &settings = m_isFiltered ? m_filteredSettings : m_allSettings;
+    for (int i = 0; i < settings.size(); ++i) {
+        if (settings[i].group == group && settings[i].setting == setting) {
+            emit dataChanged(index(i, 3), index(i, 3), {Qt::FontRole});
+            break;
+        }
+    }
+    emit pendingCountChanged(m_pending.size());
+}
+
+QString SettingsModel::pendingKey(const SettingEntry &entry)
+{
+    // Setting names never contain a newline
+    return entry.group + '\n' + entry.setting;
+}
+
 void SettingsModel::applyFilter(const QString &filterText)
 {
     beginResetModel();
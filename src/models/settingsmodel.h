@@ -4,6 +4,7 @@
 #include <QAbstractTableModel>
 #include <QVector>
 #include <QString>
+#include <QSet>
 #include "iconfigfilter.h"
 #include "configfilter.h"
 #include "settingentry.h"
@@ -26,15 +27,26 @@ public:
     void updateSettings(const QVector<SettingEntry> &settings);  // Update values without clearing filter
     const QVector<SettingEntry>& getSettings() const;
     
+    // Values edited since they were fetched or last applied, not yet on the device
+    QVector<SettingEntry> pendingChanges() const;
+    int pendingCount() const;
+    void clearPending(const QString &group, const QString &setting);
+    
     void applyFilter(const QString &filterText);
     void clearFilter();
 
+signals:
+    void pendingCountChanged(int count);
+
 private:
+    static QString pendingKey(const SettingEntry &entry);
+    
     QVector<SettingEntry> m_allSettings;
     QVector<SettingEntry> m_filteredSettings;
     ConfigFilter m_filter;
     bool m_isFiltered;
     QString m_currentFilterText;  // Store current filter text to reapply after update
+    QSet<QString> m_pending;      // pendingKey() of every edited entry
 };
 
 #endif // SETTINGSMODEL_H
@@ -6,6 +6,7 @@
 #include "propertiesmodel.h"
 #include "propertydefinitionmodel.h"
 #include "highlightdelegate.h"
+#include "logsession.h"
 #include <QClipboard>
 #include <QApplication>
 #include <QTableWidgetItem>
@@ -22,14 +23,22 @@
 #include <QDebug>
 #include <QKeyEvent>
 #include <QLineEdit>
+#include <QRadioButton>
+#include <QThread>
+#include <QHash>
 #include <QBrush>
 #include <QColor>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDir>
+#include <QFileInfo>
 #include <QCompleter>
+#include <QSignalBlocker>
+#include <QShortcut>
 #include <QStringListModel>
 #include <QInputDialog>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -43,6 +52,13 @@ MainWindow::MainWindow(QWidget *parent)
     , isPaused(true)
     , memoryUsage(42)
     , m_logConverter(new ThreadtimeLogConverter())
+    , m_ingestTimer(new QTimer(this))
+    , m_fileLoader(new FileLoader(this))
+    , m_streamThread(nullptr)
+    , m_streamReader(nullptr)
+    , m_loadReplacesLogs(false)
+    , m_loadMerged(false)
+    , m_liveSwitch(LiveSwitch::NotAsked)
 {
     ui->setupUi(this);
     
@@ -50,8 +66,11 @@ MainWindow::MainWindow(QWidget *parent)
     ui->tableLog->setModel(m_logModel);
     ui->tableLog->horizontalHeader()->setStretchLastSection(true);
     
-    // Set marked rows pointer to model for highlighting
-    m_logModel->setMarkedRows(&m_markedRows);
+    // The model shows entries of allLogs through a list of sequence numbers, no entries are copied
+    m_logModel->setSource(&allLogs);
+    
+    // Set marked entries pointer to model for highlighting
+    m_logModel->setMarkedSequences(&m_markedSequences);
     
     // Set column widths for main log table
     ui->tableLog->setColumnWidth(0, 100); // Date
@@ -62,6 +81,11 @@ MainWindow::MainWindow(QWidget *parent)
     ui->tableLog->setColumnWidth(5, 35);  // Lvl
     ui->tableLog->setColumnWidth(6, 150); // Tag
     
+    // The Source column of merged files is shown first, Message stays the stretched last section
+    ui->tableLog->horizontalHeader()->moveSection(SOURCE_COLUMN, 0);
+    ui->tableLog->setColumnWidth(SOURCE_COLUMN, 120);
+    ui->tableLog->setColumnHidden(SOURCE_COLUMN, true);
+    
     // Setup mark log table view with model
     ui->tableMarkLog->setModel(m_markLogModel);
     ui->tableMarkLog->horizontalHeader()->setStretchLastSection(true);
@@ -74,6 +98,9 @@ MainWindow::MainWindow(QWidget *parent)
     ui->tableMarkLog->setColumnWidth(4, 200); // Package
     ui->tableMarkLog->setColumnWidth(5, 35);  // Lvl
     ui->tableMarkLog->setColumnWidth(6, 150); // Tag
+    ui->tableMarkLog->horizontalHeader()->moveSection(SOURCE_COLUMN, 0);
+    ui->tableMarkLog->setColumnWidth(SOURCE_COLUMN, 120);
+    ui->tableMarkLog->setColumnHidden(SOURCE_COLUMN, true);
     
     // Setup highlight delegates for Tag (column 6) and Message (column 7) columns
     m_tagHighlightDelegate = new HighlightDelegate(this);
@@ -94,14 +121,27 @@ MainWindow::MainWindow(QWidget *parent)
     // Connect click on mark log table for scrolling to original
     connect(ui->tableMarkLog, &QTableView::clicked, this, &MainWindow::onMarkLogTableClicked);
     
+    // Commit buffered live lines in batches instead of one model insert per line
+    m_ingestTimer->setSingleShot(true);
+    m_ingestTimer->setInterval(INGEST_INTERVAL_MS);
+    connect(m_ingestTimer, &QTimer::timeout, this, &MainWindow::flushPendingLogs);
+    
     // Connect to AdbManager
     AdbManager &adbManager = AdbManager::instance();
     connect(&adbManager, &AdbManager::devicesChanged, this, &MainWindow::onDevicesChanged);
-    connect(&adbManager, &AdbManager::logcatLineReceived, this, &MainWindow::onLogcatLineReceived);
+    connect(&adbManager, &AdbManager::logcatEntriesAvailable, this, &MainWindow::onEntriesAvailable);
     connect(&adbManager, &AdbManager::settingsFetched, this, &MainWindow::onSettingsFetched);
     connect(&adbManager, &AdbManager::propertiesFetched, this, &MainWindow::onPropertiesFetched);
     connect(&adbManager, &AdbManager::propertyDefinitionsFetched, this, &MainWindow::onPropertyDefinitionsFetched);
     
+    // Files are parsed in the background and shown batch by batch
+    connect(m_fileLoader, &FileLoader::entriesAvailable, this, &MainWindow::onEntriesAvailable);
+    connect(m_fileLoader, &FileLoader::progressChanged, this, &MainWindow::onFileLoadProgress);
+    connect(m_fileLoader, &FileLoader::finished, this, &MainWindow::onFileLoadFinished);
+    connect(m_fileLoader, &FileLoader::followRestarted, this, [this](const QString &reason) {
+        ui->statusbar->showMessage(reason, 5000);
+    });
+    
     // Initialize with current devices
     onDevicesChanged(adbManager.getConnectedDevices());
     
@@ -125,6 +165,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    stopStream();
+    
+    // A running save reports to the window
+    m_saveFuture.waitForFinished();
     delete ui;
 }
 
@@ -143,6 +187,10 @@ void MainWindow::setupConnections()
     connect(ui->txtFilterProperties, &QLineEdit::textChanged, this, &MainWindow::onPropertiesFilterChanged);
     connect(ui->btnRefreshSettings, &QPushButton::clicked, this, &MainWindow::onRefreshSettingsClicked);
     connect(ui->btnRefreshProperties, &QPushButton::clicked, this, &MainWindow::onRefreshPropertiesClicked);
+    connect(ui->btnApplySettings, &QPushButton::clicked, this, &MainWindow::onApplyChangesClicked);
+    connect(ui->btnApplyProperties, &QPushButton::clicked, this, &MainWindow::onApplyChangesClicked);
+    connect(m_settingsModel, &SettingsModel::pendingCountChanged, this, &MainWindow::updateApplyButtons);
+    connect(m_propertiesModel, &PropertiesModel::pendingCountChanged, this, &MainWindow::updateApplyButtons);
     
     // SDK tab connections
     connect(ui->txtPropertySearch, &QLineEdit::returnPressed, this, &MainWindow::onSearchPropertyDefinition);
@@ -169,6 +217,11 @@ void MainWindow::setupConnections()
     // File path input - load file when Enter is pressed
     connect(ui->txtFilePath, &QLineEdit::returnPressed, this, &MainWindow::onLoadFileClicked);
     connect(ui->btnOpen, &QPushButton::clicked, this, &MainWindow::onOpenFileClicked);
+    connect(ui->btnFollow, &QPushButton::toggled, this, &MainWindow::onFollowToggled);
+    
+    // Escape stops a file that is still loading
+    QShortcut *cancelLoadShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    connect(cancelLoadShortcut, &QShortcut::activated, this, &MainWindow::onCancelLoadTriggered);
 }
 
 void MainWindow::setupConfigurationTables()
@@ -428,9 +481,10 @@ void MainWindow::onSaveSettingClicked(int row)
     QString setting = m_settingsModel->data(m_settingsModel->index(row, 2), Qt::DisplayRole).toString();
     QString newValue = m_settingsModel->data(m_settingsModel->index(row, 3), Qt::DisplayRole).toString();
     
-    // Set the value via ADB
+    // Set the value via ADB and read it back to verify it was actually set
     QString error;
-    bool success = AdbManager::instance().setSetting(m_currentDeviceId, group, setting, newValue, error);
+    QString verifiedValue;
+    bool success = AdbManager::instance().setSetting(m_currentDeviceId, group, setting, newValue, verifiedValue, error);
     
     if (!success) {
         QMessageBox::warning(this, "Failed to Set Value", 
@@ -438,14 +492,12 @@ void MainWindow::onSaveSettingClicked(int row)
         return;
     }
     
-    // Verify the value was actually set
-    QString verifiedValue = AdbManager::instance().verifySetting(m_currentDeviceId, group, setting);
-    
     if (verifiedValue != newValue) {
         QMessageBox::warning(this, "Value Not Set", 
             QString("Setting %1.%2 could not be set.\nExpected: %3\nActual: %4\n\nThis setting may be read-only or require special permissions.")
                 .arg(group, setting, newValue, verifiedValue.isEmpty() ? "(null)" : verifiedValue));
     } else {
+        m_settingsModel->clearPending(group, setting);
         ui->statusbar->showMessage(QString("Successfully set %1.%2 = %3").arg(group, setting, newValue), 3000);
     }
 }
@@ -466,9 +518,10 @@ void MainWindow::onSavePropertyClicked(int row)
     QString property = m_propertiesModel->data(m_propertiesModel->index(row, 1), Qt::DisplayRole).toString();
     QString newValue = m_propertiesModel->data(m_propertiesModel->index(row, 2), Qt::DisplayRole).toString();
     
-    // Set the value via ADB
+    // Set the value via ADB and read it back to verify it was actually set
     QString error;
-    bool success = AdbManager::instance().setProperty(m_currentDeviceId, property, newValue, error);
+    QString verifiedValue;
+    bool success = AdbManager::instance().setProperty(m_currentDeviceId, property, newValue, verifiedValue, error);
     
     if (!success) {
         QMessageBox::warning(this, "Failed to Set Property", 
@@ -476,39 +529,104 @@ void MainWindow::onSavePropertyClicked(int row)
         return;
     }
     
-    // Verify the value was actually set
-    QString verifiedValue = AdbManager::instance().verifyProperty(m_currentDeviceId, property);
-    
     if (verifiedValue != newValue) {
         QMessageBox::warning(this, "Property Not Set", 
             QString("Property %1 could not be set.\nExpected: %2\nActual: %3\n\nThis property may be read-only or require special permissions.")
                 .arg(property, newValue, verifiedValue.isEmpty() ? "(null)" : verifiedValue));
     } else {
+        m_propertiesModel->clearPending(property);
         ui->statusbar->showMessage(QString("Successfully set %1 = %2").arg(property, newValue), 3000);
     }
 }
 
-void MainWindow::applyFilters()
+void MainWindow::onApplyChangesClicked()
 {
-    filteredLogs.clear();
+    if (m_currentDeviceId.isEmpty()) {
+        QMessageBox::warning(this, "No Device", "Please select a device first.");
+        return;
+    }
     
-    for (const auto &entry : allLogs) {
-        if (passesFilter(entry)) {
-            filteredLogs.append(entry);
+    // Collect every edited row of both tables into one batch
+    QVector<ConfigChange> changes;
+    for (const SettingEntry &entry : m_settingsModel->pendingChanges()) {
+        changes.append({ConfigChange::Setting, entry.group, entry.setting, entry.value});
+    }
+    for (const PropertyEntry &entry : m_propertiesModel->pendingChanges()) {
+        changes.append({ConfigChange::Property, QString(), entry.property, entry.value});
+    }
+    if (changes.isEmpty()) {
+        return;
+    }
+    
+    QString error;
+    QVector<ConfigChangeResult> results;
+    if (!AdbManager::instance().applyChanges(m_currentDeviceId, changes, results, error)) {
+        QMessageBox::warning(this, "Failed to Apply Changes", 
+            QString("Failed to apply %1 changes:\n%2").arg(changes.size()).arg(error));
+        return;
+    }
+    
+    // Applied rows are no longer pending, failed ones stay for another attempt
+    QStringList report;
+    int failed = 0;
+    for (int i = 0; i < changes.size(); ++i) {
+        const ConfigChange &change = changes[i];
+        const ConfigChangeResult &result = results[i];
+        const QString name = change.kind == ConfigChange::Setting ? change.group + "." + change.name : change.name;
+        if (result.applied) {
+            report.append(QString("OK      %1 = %2").arg(name, change.value));
+            if (change.kind == ConfigChange::Setting) {
+                m_settingsModel->clearPending(change.group, change.name);
+            } else {
+                m_propertiesModel->clearPending(change.name);
+            }
+        } else {
+            ++failed;
+            report.append(QString("FAILED  %1 = %2 (actual: %3): %4")
+                .arg(name, change.value, result.verifiedValue.isEmpty() ? "(null)" : result.verifiedValue, result.error));
         }
     }
     
-    // Update model with filtered data
-    m_logModel->setLogs(filteredLogs);
+    if (failed == 0) {
+        ui->statusbar->showMessage(QString("Successfully applied %1 changes").arg(changes.size()), 3000);
+        return;
+    }
+    
+    QMessageBox box(QMessageBox::Warning, "Changes Not Applied", 
+        QString("%1 of %2 changes could not be applied.").arg(failed).arg(changes.size()), QMessageBox::Ok, this);
+    box.setDetailedText(report.join('\n'));
+    box.exec();
+}
+
+void MainWindow::updateApplyButtons()
+{
+    const int count = m_settingsModel->pendingCount() + m_propertiesModel->pendingCount();
+    const QString text = count > 0 ? QString("Apply All (%1)").arg(count) : QString("Apply All");
+    ui->btnApplySettings->setEnabled(count > 0);
+    ui->btnApplySettings->setText(text);
+    ui->btnApplyProperties->setEnabled(count > 0);
+    ui->btnApplyProperties->setText(text);
+}
+
+void MainWindow::applyFilters()
+{
+    // Read the filter inputs once and reuse the compiled predicate for every entry
+    m_compiledFilter = CompiledLogFilter(buildFilterCriteria());
+    
+    // Scan in parallel, the model only keeps the indices of the matches
+    if (m_fileIndex) {
+        m_logModel->setRows(m_compiledFilter.matchingSequences(*m_fileIndex));
+    } else {
+        m_logModel->setRows(m_compiledFilter.matchingSequences(allLogs));
+    }
     
     updateFilterCount();
     updateStatusBar();
 }
 
-bool MainWindow::passesFilter(const LogEntry &entry)
+bool MainWindow::passesFilter(const LogEntry &entry) const
 {
-    FilterCriteria criteria = buildFilterCriteria();
-    return m_logFilter.passesFilter(entry, criteria);
+    return m_compiledFilter.matches(entry);
 }
 
 FilterCriteria MainWindow::buildFilterCriteria() const
@@ -572,14 +690,17 @@ FilterCriteria MainWindow::buildFilterCriteria() const
 void MainWindow::updateFilterCount()
 {
     ui->lblFilterCount->setText(QString("Showing: %1 / %2")
-                                    .arg(filteredLogs.size())
-                                    .arg(allLogs.size()));
+                                    .arg(m_logModel->getLogCount())
+                                    .arg(logSource().size()));
 }
 
 void MainWindow::updateStatusBar()
 {
+    // Approximate size of the stored entries, or of the line index of a large file
+    memoryUsage = (m_fileIndex ? m_fileIndex->byteSize() : allLogs.byteSize()) / (1024 * 1024);
+    
     QString status = QString("UTF-8  Lines: %1    Mem: %2MB  ● %3")
-                        .arg(filteredLogs.size())
+                        .arg(m_logModel->getLogCount())
                         .arg(memoryUsage)
                         .arg(isPaused ? "Paused" : "Running");
     ui->statusbar->showMessage(status);
@@ -595,9 +716,15 @@ void MainWindow::onStartClicked()
 
 void MainWindow::onClearClicked()
 {
-    allLogs.clear();
-    filteredLogs.clear();
+    // Drop the rows before the entries they point to
+    m_fileLoader->cancel();
+    m_ingestTimer->stop();
+    QVector<LogEntry> discarded;
+    AdbManager::instance().takeLogcatEntries(discarded);
     m_logModel->clear();
+    setFileIndex(QSharedPointer<LogFileIndex>());
+    allLogs.clear();
+    removeEvictedMarks();
     updateFilterCount();
     updateStatusBar();
 }
@@ -618,7 +745,7 @@ void MainWindow::onColumnsClicked()
     
     // Create checkboxes for each column
     QVector<QCheckBox*> checkboxes;
-    QStringList columnNames = {"Date", "Time", "PID", "TID", "Package", "Lvl", "Tag", "Message"};
+    QStringList columnNames = {"Date", "Time", "PID", "TID", "Package", "Lvl", "Tag", "Message", "Source"};
     
     for (int i = 0; i < columnNames.size(); ++i) {
         QCheckBox *checkbox = new QCheckBox(columnNames[i], &dialog);
@@ -676,6 +803,11 @@ void MainWindow::onDeviceChanged(int index)
     QString deviceName = ui->cmbDevice->itemText(index);
     QString deviceId = ui->cmbDevice->itemData(index).toString();
     
+    // Settings and properties shown are those of the previous device
+    if (deviceId != m_currentDeviceId) {
+        clearDeviceConfiguration();
+    }
+    
     // Update both local and AdbManager's current device
     m_currentDeviceId = deviceId;
     AdbManager::instance().setCurrentDeviceId(deviceId);
@@ -685,6 +817,15 @@ void MainWindow::onDeviceChanged(int index)
     }
 }
 
+void MainWindow::clearDeviceConfiguration()
+{
+    // Edits not yet applied go with the tables, they can't be applied to another device
+    m_settingsModel->setSettings(QVector<SettingEntry>());
+    m_propertiesModel->setProperties(QVector<PropertyEntry>());
+    recreateSettingsButtons();
+    recreatePropertiesButtons();
+}
+
 void MainWindow::onTableContextMenu(const QPoint &pos)
 {
     QModelIndex index = ui->tableLog->indexAt(pos);
@@ -801,12 +942,17 @@ void MainWindow::onDevicesChanged(const QList<AdbDevice> &devices)
     // Save current selection
     QString currentDeviceId = ui->cmbDevice->currentData().toString();
     
-    // Clear and repopulate device list
+    // Clear and repopulate device list; the selection only counts as changed
+    // if a different device ends up selected
+    const QSignalBlocker blocker(ui->cmbDevice);
     ui->cmbDevice->clear();
     
     if (devices.isEmpty()) {
         ui->cmbDevice->addItem("No devices found", "");
         ui->lblDeviceStatus->setStyleSheet("color: #f87171; font-size: 16px;"); // Red
+        if (!m_currentDeviceId.isEmpty()) {
+            clearDeviceConfiguration();
+        }
         m_currentDeviceId = "";
         AdbManager::instance().setCurrentDeviceId("");
     } else {
@@ -826,44 +972,217 @@ void MainWindow::onDevicesChanged(const QList<AdbDevice> &devices)
         
         // Update current device ID
         QString selectedDeviceId = ui->cmbDevice->currentData().toString();
+        if (selectedDeviceId != m_currentDeviceId) {
+            clearDeviceConfiguration();
+        }
         m_currentDeviceId = selectedDeviceId;
         AdbManager::instance().setCurrentDeviceId(selectedDeviceId);
     }
 }
 
-void MainWindow::onLogcatLineReceived(const QString &line)
+void MainWindow::onEntriesAvailable()
 {
-    parseAndAddLogLine(line);
+    // The entries stay queued until the next flush
+    if (!m_ingestTimer->isActive()) {
+        m_ingestTimer->start();
+    }
 }
 
-void MainWindow::parseAndAddLogLine(const QString &line)
+void MainWindow::flushPendingLogs()
 {
-    // Use the configured log converter to parse the line
-    LogEntry entry = m_logConverter->convert(line);
-    
-    // Check if parsing was successful
-    if (!entry.isValid()) {
+    // Entries arrive already parsed from the file loader, the logcat thread and a piped stream;
+    // the first batch of a file replaces the logs shown so far
+    QVector<LogEntry> pendingLogs;
+    if (m_fileLoader->takeEntries(pendingLogs) && m_loadReplacesLogs) {
+        replaceLogsWithLoad();
+    }
+    AdbManager::instance().takeLogcatEntries(pendingLogs);
+    QVector<LogEntry> batch;
+    while (m_streamQueue.pop(batch)) {
+        pendingLogs.append(std::move(batch));
+    }
+    if (pendingLogs.isEmpty()) {
         return;
     }
     
-    allLogs.append(entry);
-    
-    // Apply filters and update display if it passes
-    if (passesFilter(entry)) {
-        filteredLogs.append(entry);
+    // Live entries go to the store, which an indexed file replaces; ask once per file
+    // before closing it with its marks and filter position
+    if (m_fileIndex) {
+        if (m_liveSwitch == LiveSwitch::Declined) {
+            return;
+        }
         
-        // Add to model
-        m_logModel->addLog(entry);
+        // Kept without rows until answered, the question's event loop may flush again
+        for (const LogEntry &entry : std::as_const(pendingLogs)) {
+            allLogs.append(entry);
+        }
+        if (m_liveSwitch == LiveSwitch::Asking) {
+            return;
+        }
         
-        // Auto-scroll to bottom if enabled
-        if (ui->btnAutoScroll->isChecked()) {
-            ui->tableLog->scrollToBottom();
+        m_liveSwitch = LiveSwitch::Asking;
+        const QMessageBox::StandardButton reply = QMessageBox::question(this, "Live Logs",
+            "Live logs are arriving while an indexed file is shown.\n"
+            "Switch to the live logs? The file, its marks and its filter position are closed.",
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        
+        // The file may have been replaced while the question was open
+        if (m_liveSwitch != LiveSwitch::Asking) {
+            return;
+        }
+        if (reply == QMessageBox::Yes) {
+            setFileIndex(QSharedPointer<LogFileIndex>());
+            applyFilters();
+        } else {
+            m_liveSwitch = LiveSwitch::Declined;
+            allLogs.clear();
+            ui->statusbar->showMessage("Live logs are ignored while the file is shown", 5000);
         }
+        updateStatusBar();
+        return;
+    }
+    
+    QVector<quint32> newRows;
+    newRows.reserve(pendingLogs.size());
+    qsizetype evicted = 0;
+    for (const LogEntry &entry : std::as_const(pendingLogs)) {
+        evicted += allLogs.append(entry);
         
-        updateFilterCount();
+        // Apply filters, only matching entries become visible rows
+        if (passesFilter(entry)) {
+            newRows.append(allLogs.sequenceAt(allLogs.size() - 1));
+        }
+    }
+    
+    // A bounded store drops its oldest entries, remove their rows and marks from the top
+    if (evicted > 0) {
+        m_logModel->removeEvictedRows();
+        removeEvictedMarks();
+        
+        // A batch larger than the store also pushes out some of its own entries
+        qsizetype stale = 0;
+        while (stale < newRows.size() && !allLogs.contains(newRows[stale])) {
+            ++stale;
+        }
+        newRows.remove(0, stale);
+    }
+    
+    // Add the whole batch to the model with a single insert
+    m_logModel->appendRows(newRows);
+    
+    // Auto-scroll to bottom if enabled
+    if (!newRows.isEmpty() && ui->btnAutoScroll->isChecked()) {
+        ui->tableLog->scrollToBottom();
+    }
+    
+    updateFilterCount();
+    updateStatusBar();
+}
+
+void MainWindow::removeEvictedMarks()
+{
+    QVector<quint32> evicted;
+    const ILogSource &source = logSource();
+    for (quint32 sequence : std::as_const(m_markedSequences)) {
+        if (!source.contains(sequence)) {
+            evicted.append(sequence);
+        }
+    }
+    
+    for (quint32 sequence : std::as_const(evicted)) {
+        m_markedSequences.remove(sequence);
+        m_markLogModel->removeMarkedLog(sequence);
     }
 }
 
+bool MainWindow::startStream(StreamLogReader::Source source, const QString &path)
+{
+    stopStream();
+    
+    // Same converters as for files, wrappers may print either format
+    m_streamThread = new QThread(this);
+    m_streamReader = new StreamLogReader(source, path, fileConverters(), &m_streamQueue);
+    m_streamReader->moveToThread(m_streamThread);
+    
+    connect(m_streamReader, &StreamLogReader::entriesAvailable, this, &MainWindow::onEntriesAvailable);
+    connect(m_streamReader, &StreamLogReader::errorOccurred, this, [this](const QString &error) {
+        ui->statusbar->showMessage(error, 5000);
+    });
+    connect(m_streamReader, &StreamLogReader::finished, this, [this]() {
+        ui->statusbar->showMessage("Input stream closed", 5000);
+    });
+    
+    m_streamThread->start();
+    
+    bool started = false;
+    QMetaObject::invokeMethod(m_streamReader, &StreamLogReader::start,
+                              Qt::BlockingQueuedConnection, &started);
+    if (!started) {
+        ui->statusbar->showMessage(QString("Failed to open input stream: %1").arg(m_streamReader->errorString()), 5000);
+        stopStream();
+        return false;
+    }
+    
+    const QString name = source == StreamLogReader::Source::Stdin ? QString("standard input") : path;
+    ui->statusbar->showMessage(QString("Reading logs from %1").arg(name), 3000);
+    return true;
+}
+
+void MainWindow::stopStream()
+{
+    if (m_streamThread) {
+        // Close the stream on its own thread, then let the thread finish
+        QMetaObject::invokeMethod(m_streamReader, &StreamLogReader::stop, Qt::BlockingQueuedConnection);
+        m_streamThread->quit();
+        m_streamThread->wait();
+        delete m_streamReader;
+        m_streamReader = nullptr;
+        delete m_streamThread;
+        m_streamThread = nullptr;
+    }
+    
+    // Entries not yet taken are discarded
+    QVector<LogEntry> batch;
+    while (m_streamQueue.pop(batch)) {
+    }
+}
+
+void MainWindow::setFileIndex(const QSharedPointer<LogFileIndex> &index)
+{
+    if (m_fileIndex == index) {
+        return;
+    }
+    
+    // Live logs are asked about again for the new file
+    m_liveSwitch = LiveSwitch::NotAsked;
+    
+    // Marks hold sequence numbers of the previous source
+    m_markedSequences.clear();
+    m_markLogModel->clear();
+    
+    // Switch the model first, it may still refer to the old index until then
+    m_logModel->setSource(index ? static_cast<const ILogSource *>(index.data()) : &allLogs);
+    m_fileIndex = index;
+}
+
+const ILogSource& MainWindow::logSource() const
+{
+    if (m_fileIndex) {
+        return *m_fileIndex;
+    }
+    return allLogs;
+}
+
+void MainWindow::setLogCapacity(qsizetype maxEntries, qint64 maxBytes)
+{
+    if (allLogs.setCapacity(maxEntries, maxBytes) > 0) {
+        m_logModel->removeEvictedRows();
+        removeEvictedMarks();
+    }
+    updateFilterCount();
+    updateStatusBar();
+}
+
 void MainWindow::onLoadFileClicked()
 {
     QString filePath = ui->txtFilePath->text().trimmed();
@@ -872,6 +1191,16 @@ void MainWindow::onLoadFileClicked()
         return;
     }
     
+    // Several files are separated by semicolons, see onOpenFileClicked()
+    if (!QFileInfo::exists(filePath) && filePath.contains(FILE_PATH_SEPARATOR)) {
+        QStringList filePaths;
+        for (const QString &path : filePath.split(FILE_PATH_SEPARATOR, Qt::SkipEmptyParts)) {
+            filePaths.append(path.trimmed());
+        }
+        loadLogsFromFiles(filePaths);
+        return;
+    }
+    
     loadLogsFromFile(filePath);
 }
 
@@ -880,16 +1209,17 @@ void MainWindow::onOpenFileClicked()
     QString currentPath = ui->txtFilePath->text().trimmed();
     QString defaultPath = currentPath.isEmpty() ? QDir::homePath() : currentPath;
     
-    QString filePath = QFileDialog::getOpenFileName(
+    // Selecting several files merges them into one timeline
+    const QStringList filePaths = QFileDialog::getOpenFileNames(
         this,
-        "Open Log File",
-        defaultPath,
-        "Log Files (*.log *.txt);;All Files (*.*)"
+        "Open Log Files",
+        defaultPath.split(FILE_PATH_SEPARATOR).first().trimmed(),
+        "Log Files (*.log *.txt *.gz *.zst *.zip *" + LogSession::FILE_EXTENSION + ");;All Files (*.*)"
     );
     
-    if (!filePath.isEmpty()) {
-        ui->txtFilePath->setText(filePath);
-        loadLogsFromFile(filePath);
+    if (!filePaths.isEmpty()) {
+        ui->txtFilePath->setText(filePaths.join(QChar(FILE_PATH_SEPARATOR)));
+        loadLogsFromFiles(filePaths);
     }
 }
 
@@ -901,60 +1231,132 @@ void MainWindow::onSaveFileClicked()
         return;
     }
     
-    // Add .log extension if not present
-    if (!filePath.endsWith(".log") && !filePath.endsWith(".txt")) {
+    // Add .log extension if not present; the session extension saves marks and filters too
+    const bool session = filePath.endsWith(LogSession::FILE_EXTENSION);
+    if (!session && !filePath.endsWith(".log") && !filePath.endsWith(".txt")) {
         filePath += ".log";
     }
     
-    QString errorMsg;
-    bool success = m_fileManager.saveToFile(filePath, allLogs, errorMsg);
+    if (m_saveFuture.isRunning()) {
+        ui->statusbar->showMessage("A save is already in progress", 3000);
+        return;
+    }
     
-    if (success) {
-        ui->statusbar->showMessage(QString("Saved %1 log entries to %2")
-                                       .arg(allLogs.size())
-                                       .arg(filePath), 3000);
+    // Format and write on a worker thread. Loaded entries are snapshotted, the snapshot
+    // shares its messages with the store; an indexed file is parsed a chunk at a time
+    // while it is written, so it never has to fit in memory
+    FileManager::EntryChunkReader readChunk;
+    qsizetype count = 0;
+    if (m_fileIndex) {
+        const QSharedPointer<LogFileIndex> index = m_fileIndex;
+        count = index->size();
+        readChunk = [index](qsizetype first, qsizetype chunkCount, QVector<LogEntry> &entries) {
+            entries.append(index->parseLines(first, chunkCount));
+        };
     } else {
-        ui->statusbar->showMessage(QString("Failed to save: %1").arg(errorMsg), 5000);
-    }
+        const QVector<LogEntry> logs = allLogs.toVector();
+        count = logs.size();
+        readChunk = [logs](qsizetype first, qsizetype chunkCount, QVector<LogEntry> &entries) {
+            entries.append(logs.mid(first, chunkCount));
+        };
+    }
+    const SessionState state = session ? sessionState() : SessionState();
+    m_saveFuture = QtConcurrent::run([this, filePath, count, readChunk, session, state]() {
+        FileManager fileManager;
+        QString errorMsg;
+        const FileManager::SaveProgressHandler onProgress =
+            [this, filePath](qsizetype entriesWritten, qsizetype totalEntries) {
+                QMetaObject::invokeMethod(this, [this, filePath, entriesWritten, totalEntries]() {
+                    const qsizetype percent = totalEntries > 0 ? entriesWritten * 100 / totalEntries : 100;
+                    ui->statusbar->showMessage(QString("Saving %1... %2%").arg(filePath).arg(percent), 0);
+                }, Qt::QueuedConnection);
+            };
+        const bool success = session ? fileManager.saveSession(filePath, count, readChunk, state, onProgress, errorMsg)
+                                     : fileManager.saveToFile(filePath, count, readChunk, onProgress, errorMsg);
+        
+        QMetaObject::invokeMethod(this, [this, filePath, success, errorMsg, count]() {
+            if (success) {
+                ui->statusbar->showMessage(QString("Saved %1 log entries to %2")
+                                               .arg(count)
+                                               .arg(filePath), 3000);
+            } else {
+                ui->statusbar->showMessage(QString("Failed to save: %1").arg(errorMsg), 5000);
+            }
+        }, Qt::QueuedConnection);
+    });
+    ui->statusbar->showMessage(QString("Saving %1...").arg(filePath), 0);
 }
 
 void MainWindow::loadLogsFromFile(const QString &filePath)
 {
-    ui->statusbar->showMessage("Loading log file...", 0);
-    
-    // Prepare converters for auto-detection
-    QVector<LogConverterPtr> converters;
-    converters.append(LogConverterPtr(new ThreadtimeLogConverter()));
-    converters.append(LogConverterPtr(new BriefLogConverter()));
-    
-    QString errorMsg;
-    LogConverterPtr usedConverter;
-    QVector<LogEntry> logs = m_fileManager.readFromFileAuto(filePath, converters, usedConverter, errorMsg);
-    
-    qDebug() << "Loading file:" << filePath;
-    qDebug() << "Loaded entries:" << logs.size();
-    qDebug() << "Error message:" << errorMsg;
-    qDebug() << "Line count:" << m_fileManager.getLastLineCount();
-    qDebug() << "Parsed count:" << m_fileManager.getLastParsedCount();
+    if (!checkReadable({filePath})) {
+        return;
+    }
+    beginFileLoad(false);
     
-    if (logs.isEmpty() && !errorMsg.isEmpty()) {
-        ui->statusbar->showMessage(QString("Failed to load file: %1").arg(errorMsg), 5000);
+    // Sessions hold entries, not lines; marks and filters are restored once read
+    if (FileManager::isSession(filePath)) {
+        m_fileLoader->startSession(filePath);
+        ui->statusbar->showMessage(QString("Loading %1...").arg(filePath), 0);
         return;
     }
     
-    if (logs.isEmpty()) {
-        ui->statusbar->showMessage("No valid log entries found in file", 5000);
+    // Large files only get a line index, entries are parsed when they are shown;
+    // compressed files have to be decompressed and parsed completely
+    if (QFileInfo(filePath).size() >= INDEXED_LOAD_THRESHOLD && !FileManager::isCompressed(filePath)) {
+        m_fileLoader->startIndexed(filePath, fileConverters());
+    } else {
+        m_fileLoader->start(filePath, fileConverters());
+    }
+    ui->statusbar->showMessage(QString("Loading %1...").arg(filePath), 0);
+}
+
+void MainWindow::loadLogsFromFiles(const QStringList &filePaths)
+{
+    if (filePaths.size() == 1) {
+        loadLogsFromFile(filePaths.first());
         return;
     }
     
-    // Clear existing logs and load new ones
-    allLogs.clear();
-    allLogs = logs;
+    if (!checkReadable(filePaths)) {
+        return;
+    }
     
-    // Update converter to match the detected format
-    if (usedConverter) {
-        m_logConverter = usedConverter;
+    // One timeline, the Source column tells the files apart
+    beginFileLoad(true);
+    m_fileLoader->startMerged(filePaths, fileConverters());
+    ui->statusbar->showMessage(QString("Merging %1 files...").arg(filePaths.size()), 0);
+}
+
+bool MainWindow::checkReadable(const QStringList &filePaths)
+{
+    // A mistyped path must not cost the logs that are shown
+    for (const QString &filePath : filePaths) {
+        const QFileInfo info(filePath);
+        if (!info.isFile() || !info.isReadable()) {
+            ui->statusbar->showMessage(QString("Failed to load file: %1 is not a readable file").arg(filePath), 5000);
+            return false;
+        }
     }
+    return true;
+}
+
+void MainWindow::beginFileLoad(bool merged)
+{
+    // Any load still running is cancelled by the loader; the logs are replaced once
+    // the new one delivers entries or succeeds, a load that fails leaves them alone
+    m_loadReplacesLogs = true;
+    m_loadMerged = merged;
+}
+
+void MainWindow::replaceLogsWithLoad()
+{
+    // Clear existing logs, dropping the rows that point into them first
+    m_loadReplacesLogs = false;
+    m_logModel->clear();
+    setFileIndex(QSharedPointer<LogFileIndex>());
+    allLogs.clear();
+    removeEvictedMarks();
     
     // Clear filters to show all loaded data
     ui->txtFindMessage->clear();
@@ -964,56 +1366,231 @@ void MainWindow::loadLogsFromFile(const QString &filePath)
     ui->txtPackageFilter->clear();
     ui->txtPidFilter->clear();
     
-    // Apply filters and display
+    // Batches are filtered as they arrive, so compile the cleared filter first
     applyFilters();
-    updateFilterCount();
-    updateStatusBar();
+    
+    ui->tableLog->setColumnHidden(SOURCE_COLUMN, !m_loadMerged);
+    ui->tableMarkLog->setColumnHidden(SOURCE_COLUMN, !m_loadMerged);
+}
+
+QVector<LogConverterPtr> MainWindow::fileConverters() const
+{
+    // Converters for format auto-detection
+    QVector<LogConverterPtr> converters;
+    converters.append(LogConverterPtr(new ThreadtimeLogConverter()));
+    converters.append(LogConverterPtr(new BriefLogConverter()));
+    return converters;
+}
+
+SessionState MainWindow::sessionState() const
+{
+    SessionState state;
+    
+    // Marks by position, matching the order the entries are saved in
+    const ILogSource &source = logSource();
+    for (quint32 sequence : std::as_const(m_markedSequences)) {
+        if (source.contains(sequence)) {
+            state.markedEntries.append(source.offsetOf(sequence));
+        }
+    }
+    std::sort(state.markedEntries.begin(), state.markedEntries.end());
+    
+    state.filters.append(qMakePair(QString("message"), ui->txtFindMessage->text()));
+    state.filters.append(qMakePair(QString("startTime"), ui->txtStartTime->text()));
+    state.filters.append(qMakePair(QString("endTime"), ui->txtEndTime->text()));
+    state.filters.append(qMakePair(QString("tag"), ui->txtTagFilter->text()));
+    state.filters.append(qMakePair(QString("package"), ui->txtPackageFilter->text()));
+    state.filters.append(qMakePair(QString("pid"), ui->txtPidFilter->text()));
+    for (QRadioButton *radio : levelRadios()) {
+        if (radio->isChecked()) {
+            state.filters.append(qMakePair(QString("level"), radio->objectName()));
+        }
+    }
+    return state;
+}
+
+void MainWindow::restoreSessionState(const SessionState &state)
+{
+    const QHash<QString, QLineEdit *> lineEdits = {
+        {"message", ui->txtFindMessage},
+        {"startTime", ui->txtStartTime},
+        {"endTime", ui->txtEndTime},
+        {"tag", ui->txtTagFilter},
+        {"package", ui->txtPackageFilter},
+        {"pid", ui->txtPidFilter}
+    };
+    for (const auto &filter : state.filters) {
+        if (QLineEdit *lineEdit = lineEdits.value(filter.first)) {
+            lineEdit->setText(filter.second);
+        } else if (filter.first == "level") {
+            for (QRadioButton *radio : levelRadios()) {
+                if (radio->objectName() == filter.second) {
+                    radio->setChecked(true);
+                }
+            }
+        }
+    }
+    
+    // Entries beyond the store's capacity were evicted from the front
+    const qint64 evicted = m_fileLoader->parsedCount() - allLogs.size();
+    for (qint64 position : state.markedEntries) {
+        const qint64 index = position - evicted;
+        if (index >= 0 && index < allLogs.size()) {
+            const quint32 sequence = allLogs.sequenceAt(index);
+            m_markedSequences.insert(sequence);
+            m_markLogModel->addMarkedLog(allLogs.at(index), sequence);
+        }
+    }
+    m_logModel->setMarkedSequences(&m_markedSequences);
+    
+    // Entries of merged files keep their source
+    bool hasSources = false;
+    for (qsizetype i = 0; i < allLogs.size() && !hasSources; ++i) {
+        hasSources = allLogs.at(i).sourceId != 0;
+    }
+    ui->tableLog->setColumnHidden(SOURCE_COLUMN, !hasSources);
+    ui->tableMarkLog->setColumnHidden(SOURCE_COLUMN, !hasSources);
+    
+    applyFilters();
+}
+
+QList<QRadioButton *> MainWindow::levelRadios() const
+{
+    return {ui->radioVerbosePlus, ui->radioV, ui->radioD, ui->radioI, ui->radioW, ui->radioE, ui->radioA};
+}
+
+void MainWindow::onFileLoadProgress(qint64 bytesRead, qint64 totalBytes)
+{
+    const int percent = totalBytes > 0 ? static_cast<int>(bytesRead * 100 / totalBytes) : 100;
+    ui->statusbar->showMessage(QString("Loading %1... %2%  (Esc to cancel)")
+                                   .arg(m_fileLoader->filePath())
+                                   .arg(percent), 0);
+}
+
+void MainWindow::onFileLoadFinished(bool success)
+{
+    // Show the last batches before reporting
+    flushPendingLogs();
+    
+    if (!success) {
+        m_loadReplacesLogs = false;
+        ui->statusbar->showMessage(QString("Failed to load file: %1").arg(m_fileLoader->errorString()), 5000);
+        return;
+    }
+    
+    // An indexed or empty file delivers no batches, its logs replace the old ones now
+    if (m_loadReplacesLogs) {
+        replaceLogsWithLoad();
+    }
+    
+    // Show an indexed file through its index, filtered like loaded entries
+    QSharedPointer<LogFileIndex> index = m_fileLoader->takeIndex();
+    if (index) {
+        setFileIndex(index);
+        applyFilters();
+    }
+    
+    // Marks and filters saved with a session
+    const SessionState *state = m_fileLoader->sessionState();
+    if (state) {
+        restoreSessionState(*state);
+        ui->statusbar->showMessage(QString("Restored %1 log entries from session %2")
+                                       .arg(m_fileLoader->parsedCount())
+                                       .arg(m_fileLoader->filePath()), 5000);
+        return;
+    }
+    
+    // Update converter to match the detected format
+    LogConverterPtr usedConverter = m_fileLoader->usedConverter();
+    if (usedConverter) {
+        m_logConverter = usedConverter;
+    }
     
     // Show success message
     ui->statusbar->showMessage(
         QString("Loaded %1 log entries from %2 (Format: %3, Parsed: %4/%5)")
-            .arg(logs.size())
-            .arg(filePath)
+            .arg(m_fileLoader->parsedCount())
+            .arg(m_fileLoader->filePath())
             .arg(usedConverter ? usedConverter->name() : "Unknown")
-            .arg(m_fileManager.getLastParsedCount())
-            .arg(m_fileManager.getLastLineCount()),
+            .arg(m_fileLoader->parsedCount())
+            .arg(m_fileLoader->lineCount()),
         5000
     );
+    
+    // Keep reading what is appended to the file from here on
+    if (ui->btnFollow->isChecked()) {
+        startFollowingFile();
+    }
+}
+
+void MainWindow::onCancelLoadTriggered()
+{
+    if (!m_fileLoader->isLoading()) {
+        return;
+    }
+    
+    // Keep the rows loaded so far, or the previous logs if none arrived yet
+    m_fileLoader->cancel();
+    m_loadReplacesLogs = false;
+    ui->statusbar->showMessage("Loading cancelled", 3000);
+}
+
+void MainWindow::onFollowToggled(bool checked)
+{
+    if (!checked) {
+        m_fileLoader->stopFollowing();
+        return;
+    }
+    
+    // A file that is still loading is followed once it has been read
+    if (!m_fileLoader->isLoading()) {
+        startFollowingFile();
+    }
+}
+
+void MainWindow::startFollowingFile()
+{
+    QString errorMsg;
+    if (!m_fileLoader->startFollowing(errorMsg)) {
+        ui->btnFollow->setChecked(false);
+        ui->statusbar->showMessage(QString("Can't follow file: %1").arg(errorMsg), 5000);
+    }
 }
 
 void MainWindow::onLogTableDoubleClicked(const QModelIndex &index)
 {
-    if (!index.isValid() || index.row() >= filteredLogs.size()) {
+    if (!index.isValid() || index.row() >= m_logModel->getLogCount()) {
         return;
     }
     
     int row = index.row();
-    const LogEntry &entry = filteredLogs[row];
+    const LogEntry entry = m_logModel->getLogEntry(row);
+    const quint32 sequence = m_logModel->getSequence(row);
     
-    // Toggle mark state
-    if (m_markedRows.contains(row)) {
+    // Toggle mark state, keyed by entry so marks survive refiltering and eviction
+    if (m_markedSequences.contains(sequence)) {
         // Unmark
-        m_markedRows.remove(row);
-        m_markLogModel->removeMarkedLog(row);
+        m_markedSequences.remove(sequence);
+        m_markLogModel->removeMarkedLog(sequence);
     } else {
         // Mark
-        m_markedRows.insert(row);
-        m_markLogModel->addMarkedLog(entry, row);
+        m_markedSequences.insert(sequence);
+        m_markLogModel->addMarkedLog(entry, sequence);
     }
     
     // Notify model to update highlighting
-    m_logModel->setMarkedRows(&m_markedRows);
+    m_logModel->setMarkedSequences(&m_markedSequences);
 }
 
 void MainWindow::onMarkLogTableClicked(const QModelIndex &index)
 {
-    if (!index.isValid()) {
+    if (!index.isValid() || index.row() >= m_markLogModel->getMarkedCount()) {
         return;
     }
     
-    // Get the original index in the main log table
-    int originalRow = m_markLogModel->getOriginalIndex(index.row());
-    if (originalRow < 0 || originalRow >= filteredLogs.size()) {
+    // Find the marked entry in the main log table, it may be hidden by the current filter
+    int originalRow = m_logModel->findRow(m_markLogModel->getSequence(index.row()));
+    if (originalRow < 0) {
         return;
     }
     
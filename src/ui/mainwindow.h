@@ -7,9 +7,11 @@
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QFuture>
 #include "adbmanager.h"
 #include "ilogconverter.h"
 #include "filemanager.h"
+#include "fileloader.h"
 #include "logmodel.h"
 #include "marklogmodel.h"
 #include "settingsmodel.h"
@@ -18,9 +20,15 @@
 #include "valuedelegate.h"
 #include "highlightdelegate.h"
 #include "ilogfilter.h"
-#include "logfilter.h"
+#include "compiledlogfilter.h"
+#include "logstore.h"
+#include "logfileindex.h"
+#include "streamlogreader.h"
 #include "QLineEdit"
 
+class QRadioButton;
+class QThread;
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -34,6 +42,22 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    
+    /**
+     * Bound the log store for long captures, the oldest entries are dropped first
+     * @param maxEntries Maximum number of stored entries, 0 for no limit
+     * @param maxBytes Approximate memory limit for the stored entries, 0 for no limit
+     */
+    void setLogCapacity(qsizetype maxEntries, qint64 maxBytes);
+    
+    /**
+     * Show log lines piped in from outside, e.g. adb logcat through a wrapper
+     * Entries are parsed on a worker thread and ingested like live logcat output
+     * @param source Standard input, a named pipe or a local socket
+     * @param path Named pipe path or socket name, unused for standard input
+     * @return false if the stream couldn't be opened
+     */
+    bool startStream(StreamLogReader::Source source, const QString &path);
 
 private slots:
     void onFilterChanged();
@@ -51,18 +75,25 @@ private slots:
     void onTableContextMenu(const QPoint &pos);
     void addToFilter(const QString &filterType, const QString &value, FilterOperator op);
     void onDevicesChanged(const QList<AdbDevice> &devices);
-    void onLogcatLineReceived(const QString &line);
-    void parseAndAddLogLine(const QString &line);
+    void onEntriesAvailable();
     void onLoadFileClicked();
     void onOpenFileClicked();
     void onSaveFileClicked();
     void loadLogsFromFile(const QString &filePath);
+    void loadLogsFromFiles(const QStringList &filePaths);
+    void onFileLoadProgress(qint64 bytesRead, qint64 totalBytes);
+    void onFileLoadFinished(bool success);
+    void onCancelLoadTriggered();
+    void onFollowToggled(bool checked);
+    void startFollowingFile();
     void onLogTableDoubleClicked(const QModelIndex &index);
     void onMarkLogTableClicked(const QModelIndex &index);
     void onSettingsFetched(const QVector<SettingEntry> &settings);
     void onPropertiesFetched(const QVector<PropertyEntry> &properties);
     void onSaveSettingClicked(int row);
     void onSavePropertyClicked(int row);
+    void onApplyChangesClicked();
+    void updateApplyButtons();
     
     // SDK tab slots
     void onSearchPropertyDefinition();
@@ -79,21 +110,45 @@ protected:
 
 private:
     Ui::MainWindow *ui;
-    QVector<LogEntry> allLogs;
-    QVector<LogEntry> filteredLogs;
+    LogStore allLogs; // Single owning store, m_logModel and the marks refer to it by sequence number
+    QSharedPointer<LogFileIndex> m_fileIndex; // Shown instead of allLogs while a large file is open
     LogModel *m_logModel;
     MarkLogModel *m_markLogModel;
     SettingsModel *m_settingsModel;
     PropertiesModel *m_propertiesModel;
     PropertyDefinitionModel *m_propertyDefinitionModel;
     QVector<PropertyDefinition> m_availablePropertyDefinitions; // All available property definitions for auto-complete
-    QSet<int> m_markedRows; // Track marked rows for highlighting
+    QSet<quint32> m_markedSequences; // Track marked entries for highlighting
     QString m_currentDeviceId; // Currently selected device
     bool isPaused;
     qint64 memoryUsage;
     LogConverterPtr m_logConverter;
-    FileManager m_fileManager;
-    LogFilter m_logFilter;
+    CompiledLogFilter m_compiledFilter; // Rebuilt from the filter inputs by applyFilters()
+    
+    // Entries parsed by the logcat thread or the file loader are committed to the model once per interval
+    QTimer *m_ingestTimer;
+    FileLoader *m_fileLoader;
+    QThread *m_streamThread;
+    StreamLogReader *m_streamReader;  // Lives in m_streamThread
+    LogBatchQueue m_streamQueue;      // Filled by m_streamReader
+    QFuture<void> m_saveFuture;    // Save running on a worker thread
+    bool m_loadReplacesLogs;       // The current logs stay until the loading file delivers entries or succeeds
+    bool m_loadMerged;             // The load in progress merges several files
+    
+    // Answer to switching from m_fileIndex to live logs that arrive while it is shown
+    enum class LiveSwitch { NotAsked, Asking, Declined };
+    LiveSwitch m_liveSwitch;
+    
+    static const int INGEST_INTERVAL_MS = 33;
+    
+    // Files from this size on are indexed and parsed on demand instead of loaded
+    static const qint64 INDEXED_LOAD_THRESHOLD = 256 * 1024 * 1024;
+    
+    // Column with the file name of merged entries, hidden otherwise
+    static const int SOURCE_COLUMN = 8;
+    
+    // Separates the files to merge in the file path box
+    static constexpr char FILE_PATH_SEPARATOR = ';';
     
     // Highlight delegates for Tag and Message columns
     HighlightDelegate *m_tagHighlightDelegate;
@@ -111,10 +166,23 @@ private:
     void recreatePropertyDefinitionButtons();
     void recreateSettingsButtons();
     void recreatePropertiesButtons();
+    void clearDeviceConfiguration();
     void updatePropertyNamesCompleter();
     void applyFilters();
+    void flushPendingLogs();
+    void removeEvictedMarks();
+    void stopStream();
+    void setFileIndex(const QSharedPointer<LogFileIndex> &index);
+    bool checkReadable(const QStringList &filePaths);
+    void beginFileLoad(bool merged);
+    void replaceLogsWithLoad();
+    QVector<LogConverterPtr> fileConverters() const;
+    SessionState sessionState() const;
+    void restoreSessionState(const SessionState &state);
+    QList<QRadioButton *> levelRadios() const;
+    const ILogSource& logSource() const;
     void updateFilterCount();
-    bool passesFilter(const LogEntry &entry);
+    bool passesFilter(const LogEntry &entry) const;
     FilterCriteria buildFilterCriteria() const;
     void saveToHistory(QLineEdit *lineEdit);
     void navigateHistory(QLineEdit *lineEdit, bool up);
@@ -0,0 +1,409 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QtEndian>
+#include <utility>
+#include "adbclient.h"
+#include "adbdevicetracker.h"
+
+namespace {
+
+const char SERIAL[] = "emulator-5554";
+const char DEVICE_LIST[] = "emulator-5554          device product:sdk model:Pixel device:emu64 transport_id:1\n";
+const int TIMEOUT_MS = 5000;
+
+} // namespace
+
+/**
+ * Fake adb server emulating the services AdbClient and AdbDeviceTracker use
+ * Runs on its own thread, since AdbClient blocks the thread that calls it.
+ * Knows host:devices-l, host:track-devices-l and host:transport:<serial>,
+ * followed by shell,v2,raw: or the legacy shell:, and records every request
+ */
+class FakeAdbServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Output of every shell command
+    struct ShellReply {
+        QByteArray standardOutput;
+        QByteArray standardError;
+        quint8 exitCode = 0;
+    };
+    
+    FakeAdbServer()
+        : m_server(nullptr)
+        , m_shellV2(true)
+    {
+        moveToThread(&m_thread);
+        m_thread.start();
+        QMetaObject::invokeMethod(this, [this]() {
+            m_server = new QTcpServer(this);
+            connect(m_server, &QTcpServer::newConnection, this, &FakeAdbServer::acceptConnections);
+            m_server->listen(QHostAddress::LocalHost);
+        }, Qt::BlockingQueuedConnection);
+    }
+    
+    ~FakeAdbServer() override
+    {
+        QMetaObject::invokeMethod(this, [this]() {
+            // Connections are closed with the server, without running their handlers
+            for (QTcpSocket *socket : m_connections.keys()) {
+                disconnect(socket, nullptr, this, nullptr);
+            }
+            delete m_server;
+            m_server = nullptr;
+        }, Qt::BlockingQueuedConnection);
+        m_thread.quit();
+        m_thread.wait();
+    }
+    
+    quint16 port() const { return m_server->serverPort(); }
+    
+    void setShellV2(bool supported)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shellV2 = supported;
+    }
+    
+    // FAIL message for host:transport of the known device, empty to accept it
+    void setTransportError(const QByteArray &message)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_transportError = message;
+    }
+    
+    void setShellReply(const ShellReply &reply)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shellReply = reply;
+    }
+    
+    // Requests received so far, in order
+    QStringList takeRequests()
+    {
+        QMutexLocker locker(&m_mutex);
+        return std::exchange(m_requests, QStringList());
+    }
+    
+    /**
+     * Send a device list to every host:track-devices-l connection
+     * @param data Raw bytes, so tests can send partial or unframed data
+     */
+    void pushToTrackers(const QByteArray &data)
+    {
+        QMetaObject::invokeMethod(this, [this, data]() {
+            for (QTcpSocket *socket : std::as_const(m_trackers)) {
+                socket->write(data);
+                socket->flush();
+            }
+        }, Qt::BlockingQueuedConnection);
+    }
+    
+    static QByteArray frame(const QByteArray &payload)
+    {
+        return QByteArray::number(payload.size(), 16).rightJustified(4, '0') + payload;
+    }
+    
+    static QByteArray fail(const QByteArray &message)
+    {
+        return "FAIL" + frame(message);
+    }
+    
+    static QByteArray shellPacket(quint8 id, const QByteArray &data)
+    {
+        char header[AdbClient::SHELL_HEADER_SIZE];
+        header[0] = static_cast<char>(id);
+        qToLittleEndian<quint32>(data.size(), header + 1);
+        return QByteArray(header, sizeof(header)) + data;
+    }
+
+private:
+    // Device selected on a connection by host:transport, empty before
+    struct Connection {
+        QByteArray buffer;
+        QString serial;
+    };
+    
+    void acceptConnections()
+    {
+        while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+            m_connections.insert(socket, Connection());
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+                readRequests(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                m_connections.remove(socket);
+                m_trackers.removeAll(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+    
+    void readRequests(QTcpSocket *socket)
+    {
+        m_connections[socket].buffer.append(socket->readAll());
+        
+        // A handled request may close the connection
+        QByteArray request;
+        while (socket->state() == QAbstractSocket::ConnectedState && m_connections.contains(socket)
+               && AdbClient::takeMessage(m_connections[socket].buffer, request)) {
+            handleRequest(socket, m_connections[socket], QString::fromUtf8(request));
+        }
+    }
+    
+    void handleRequest(QTcpSocket *socket, Connection &connection, const QString &service)
+    {
+        static const QString transportPrefix = "host:transport:";
+        QMutexLocker locker(&m_mutex);
+        m_requests.append(service);
+        if (connection.serial.isEmpty()) {
+            if (service == "host:devices-l") {
+                socket->write("OKAY" + frame(DEVICE_LIST));
+                socket->disconnectFromHost();
+            } else if (service == "host:track-devices-l") {
+                socket->write("OKAY" + frame(DEVICE_LIST));
+                m_trackers.append(socket);
+            } else if (service.startsWith(transportPrefix)) {
+                const QString serial = service.mid(transportPrefix.size());
+                if (serial == SERIAL && !m_transportError.isEmpty()) {
+                    socket->write(fail(m_transportError));
+                    socket->disconnectFromHost();
+                } else if (serial == SERIAL) {
+                    socket->write("OKAY");
+                    connection.serial = serial;
+                } else {
+                    socket->write(fail(QString("device '%1' not found").arg(serial).toUtf8()));
+                    socket->disconnectFromHost();
+                }
+            } else {
+                socket->write(fail("unknown host service"));
+                socket->disconnectFromHost();
+            }
+            return;
+        }
+        
+        if (service.startsWith("shell,v2,raw:") && m_shellV2) {
+            // Output split over several packets, like a device sends it
+            const QByteArray &output = m_shellReply.standardOutput;
+            const qsizetype half = output.size() / 2;
+            socket->write("OKAY");
+            socket->write(shellPacket(AdbClient::ShellStdout, output.left(half)));
+            socket->write(shellPacket(AdbClient::ShellStderr, m_shellReply.standardError));
+            socket->write(shellPacket(AdbClient::ShellStdout, output.mid(half)));
+            socket->write(shellPacket(AdbClient::ShellExit, QByteArray(1, char(m_shellReply.exitCode))));
+        } else if (service.startsWith("shell:")) {
+            // Legacy shell: unframed output until the connection closes
+            socket->write("OKAY");
+            socket->write(m_shellReply.standardOutput + m_shellReply.standardError);
+        } else {
+            socket->write(fail("closed"));
+        }
+        socket->disconnectFromHost();
+    }
+    
+    QThread m_thread;
+    QTcpServer *m_server;
+    QHash<QTcpSocket *, Connection> m_connections;
+    QList<QTcpSocket *> m_trackers;
+    
+    // Shared with the test thread
+    QMutex m_mutex;
+    bool m_shellV2;
+    QByteArray m_transportError;
+    ShellReply m_shellReply;
+    QStringList m_requests;
+};
+
+class TestAdbClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    
+    void encodeRequest();
+    void takeMessage();
+    void hostQuery();
+    void hostQueryFail();
+    void connectionRefused();
+    void shellV2();
+    void shellUnknownDevice();
+    void shellLegacyFallback();
+    void shellDeviceOffline();
+    void trackDevices();
+
+private:
+    AdbClient client() const { return AdbClient("127.0.0.1", m_server->port()); }
+    
+    QScopedPointer<FakeAdbServer> m_server;
+};
+
+void TestAdbClient::init()
+{
+    m_server.reset(new FakeAdbServer);
+    QVERIFY(m_server->port() != 0);
+}
+
+void TestAdbClient::cleanup()
+{
+    m_server.reset();
+}
+
+void TestAdbClient::encodeRequest()
+{
+    QCOMPARE(AdbClient::encodeRequest("host:version"), QByteArray("000chost:version"));
+    QCOMPARE(AdbClient::encodeRequest(""), QByteArray("0000"));
+}
+
+void TestAdbClient::takeMessage()
+{
+    QByteArray payload;
+    
+    // Incomplete length and incomplete payload wait for more data
+    QByteArray buffer("00");
+    QVERIFY(!AdbClient::takeMessage(buffer, payload));
+    buffer.append("05abc");
+    QVERIFY(!AdbClient::takeMessage(buffer, payload));
+    QCOMPARE(buffer, QByteArray("0005abc"));
+    
+    // Two messages in one read are taken one at a time
+    buffer.append("de0000");
+    QVERIFY(AdbClient::takeMessage(buffer, payload));
+    QCOMPARE(payload, QByteArray("abcde"));
+    QVERIFY(AdbClient::takeMessage(buffer, payload));
+    QCOMPARE(payload, QByteArray());
+    QVERIFY(buffer.isEmpty());
+    
+    // Unframed lines printed by adb are dropped
+    buffer = "* daemon started successfully\n0002ok";
+    QVERIFY(AdbClient::takeMessage(buffer, payload));
+    QCOMPARE(payload, QByteArray("ok"));
+}
+
+void TestAdbClient::hostQuery()
+{
+    QByteArray reply;
+    QString errorMsg;
+    QVERIFY2(client().hostQuery("host:devices-l", reply, TIMEOUT_MS, errorMsg), qPrintable(errorMsg));
+    QCOMPARE(reply, QByteArray(DEVICE_LIST));
+    QCOMPARE(m_server->takeRequests(), QStringList({"host:devices-l"}));
+}
+
+void TestAdbClient::hostQueryFail()
+{
+    QByteArray reply;
+    QString errorMsg;
+    QVERIFY(!client().hostQuery("host:bogus", reply, TIMEOUT_MS, errorMsg));
+    QCOMPARE(errorMsg, QString("unknown host service"));
+}
+
+void TestAdbClient::connectionRefused()
+{
+    // Nothing listens on the port once the server is gone
+    const quint16 port = m_server->port();
+    m_server.reset();
+    
+    QByteArray reply;
+    QString errorMsg;
+    QVERIFY(!AdbClient("127.0.0.1", port).hostQuery("host:devices-l", reply, TIMEOUT_MS, errorMsg));
+    QVERIFY2(errorMsg.startsWith("Can't connect to the adb server"), qPrintable(errorMsg));
+}
+
+void TestAdbClient::shellV2()
+{
+    FakeAdbServer::ShellReply reply;
+    reply.standardOutput = "line one\nline two\n";
+    reply.standardError = "warning\n";
+    reply.exitCode = 3;
+    m_server->setShellReply(reply);
+    
+    AdbClient::ShellResult result;
+    QString errorMsg;
+    QVERIFY2(client().shell(SERIAL, {"echo", "a b"}, result, TIMEOUT_MS, errorMsg), qPrintable(errorMsg));
+    QCOMPARE(result.standardOutput, reply.standardOutput);
+    QCOMPARE(result.standardError, reply.standardError);
+    QCOMPARE(result.exitCode, 3);
+    
+    // The transport is selected first, then the command goes out quoted on the same connection
+    QCOMPARE(m_server->takeRequests(),
+             QStringList({QString("host:transport:") + SERIAL, "shell,v2,raw:echo 'a b'"}));
+}
+
+void TestAdbClient::shellUnknownDevice()
+{
+    AdbClient::ShellResult result;
+    QString errorMsg;
+    QVERIFY(!client().shell("missing", {"true"}, result, TIMEOUT_MS, errorMsg));
+    QCOMPARE(errorMsg, QString("device 'missing' not found"));
+    QCOMPARE(m_server->takeRequests(), QStringList({"host:transport:missing"}));
+}
+
+void TestAdbClient::shellLegacyFallback()
+{
+    FakeAdbServer::ShellReply reply;
+    reply.standardOutput = "output\n";
+    reply.standardError = "error\n";
+    m_server->setShellReply(reply);
+    m_server->setShellV2(false);
+    
+    // Devices without shell v2 mix stderr into stdout and can't report the exit code
+    AdbClient::ShellResult result;
+    QString errorMsg;
+    QVERIFY2(client().shell(SERIAL, {"getprop"}, result, TIMEOUT_MS, errorMsg), qPrintable(errorMsg));
+    QCOMPARE(result.standardOutput, QByteArray("output\nerror\n"));
+    QVERIFY(result.standardError.isEmpty());
+    QCOMPARE(result.exitCode, 0);
+    
+    const QString transport = QString("host:transport:") + SERIAL;
+    QCOMPARE(m_server->takeRequests(),
+             QStringList({transport, "shell,v2,raw:getprop", transport, "shell:getprop"}));
+}
+
+void TestAdbClient::shellDeviceOffline()
+{
+    m_server->setTransportError("device offline");
+    
+    // Only a refused shell v2 is retried with the plain shell, other errors are kept
+    AdbClient::ShellResult result;
+    QString errorMsg;
+    QVERIFY(!client().shell(SERIAL, {"getprop"}, result, TIMEOUT_MS, errorMsg));
+    QCOMPARE(errorMsg, QString("device offline"));
+    QCOMPARE(m_server->takeRequests(), QStringList({QString("host:transport:") + SERIAL}));
+}
+
+void TestAdbClient::trackDevices()
+{
+    AdbDeviceTracker tracker;
+    QSignalSpy listed(&tracker, &AdbDeviceTracker::devicesListed);
+    QSignalSpy errors(&tracker, &AdbDeviceTracker::errorOccurred);
+    tracker.start("adb", client());
+    
+    // The current list arrives right after the server's OKAY
+    QVERIFY(listed.wait(TIMEOUT_MS));
+    QCOMPARE(listed.takeFirst().at(0).toString(), QString(DEVICE_LIST));
+    
+    // A list split over two writes is reported once it is complete
+    const QByteArray update = FakeAdbServer::frame("emulator-5556          offline transport_id:2\n");
+    m_server->pushToTrackers(update.left(6));
+    QVERIFY(!listed.wait(200));
+    m_server->pushToTrackers(update.mid(6));
+    QVERIFY(listed.wait(TIMEOUT_MS));
+    QCOMPARE(listed.takeFirst().at(0).toString(), QString("emulator-5556          offline transport_id:2\n"));
+    
+    // The last device going away is an empty message
+    m_server->pushToTrackers(FakeAdbServer::frame(QByteArray()));
+    QVERIFY(listed.wait(TIMEOUT_MS));
+    QCOMPARE(listed.takeFirst().at(0).toString(), QString());
+    
+    tracker.stop();
+    QVERIFY(errors.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestAdbClient)
+#include "tst_adbclient.moc"
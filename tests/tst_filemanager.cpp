@@ -0,0 +1,96 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QStandardPaths>
+#include "filemanager.h"
+#include "threadtimelogconverter.h"
+#include "brieflogconverter.h"
+
+class TestFileManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    
+    void mergeBriefAndThreadtime();
+
+private:
+    // Write lines to a file in the temporary directory, returns its path
+    QString writeFile(const QString &name, const QStringList &lines);
+    
+    static QVector<LogConverterPtr> converters();
+    
+    QTemporaryDir m_dir;
+};
+
+void TestFileManager::initTestCase()
+{
+    // Keep cache files out of the user's cache directory
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+QString TestFileManager::writeFile(const QString &name, const QStringList &lines)
+{
+    const QString path = m_dir.filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    file.write((lines.join('\n') + '\n').toUtf8());
+    return path;
+}
+
+QVector<LogConverterPtr> TestFileManager::converters()
+{
+    return {LogConverterPtr(new ThreadtimeLogConverter()), LogConverterPtr(new BriefLogConverter())};
+}
+
+void TestFileManager::mergeBriefAndThreadtime()
+{
+    // Threadtime with a brief line in between, which has no timestamp of its own
+    const QString mixed = writeFile("mixed.log", {
+        "01-02 10:00:01.000   200   200 I Mixed   : m1",
+        "W/Mixed(200): m2",
+        "01-02 10:00:03.000   200   200 I Mixed   : m3",
+    });
+    const QString threadtime = writeFile("threadtime.log", {
+        "01-02 10:00:00.000   100   100 I Time    : t1",
+        "01-02 10:00:01.000   100   100 I Time    : t2",
+        "01-02 10:00:02.000   100   100 I Time    : t3",
+    });
+    const QString brief = writeFile("brief.log", {
+        "I/Brief(300): b1",
+        "E/Brief(300): b2",
+    });
+    
+    FileManager fileManager;
+    LogConverterPtr usedConverter;
+    QString errorMsg;
+    QVector<LogEntry> merged;
+    const bool ok = fileManager.mergeFilesAuto({mixed, threadtime, brief}, converters(), usedConverter,
+                                                [&merged](QVector<LogEntry> &batch, qint64, qint64) {
+        merged.append(batch);
+    }, nullptr, errorMsg);
+    QVERIFY2(ok, qPrintable(errorMsg));
+    
+    // The brief file has no times and comes first; m2 stays right after m1, which
+    // wins the tie with t2 as the earlier file
+    QStringList messages;
+    QStringList sources;
+    for (const LogEntry &entry : std::as_const(merged)) {
+        messages.append(entry.message);
+        sources.append(entry.source());
+    }
+    QCOMPARE(messages, QStringList({"b1", "b2", "t1", "m1", "m2", "t2", "t3", "m3"}));
+    QCOMPARE(sources, QStringList({"brief.log", "brief.log", "threadtime.log", "mixed.log",
+                                   "mixed.log", "threadtime.log", "threadtime.log", "mixed.log"}));
+    
+    // Brief lines are never stamped with the time they were parsed at
+    QCOMPARE(merged[0].timestamp, LogEntry::NoTimestamp);
+    QCOMPARE(merged[4].timestamp, LogEntry::NoTimestamp);
+    QCOMPARE(fileManager.getLastParsedCount(), 8);
+}
+
+QTEST_GUILESS_MAIN(TestFileManager)
+#include "tst_filemanager.moc"
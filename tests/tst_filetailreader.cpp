@@ -0,0 +1,104 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "filetailreader.h"
+#include "threadtimelogconverter.h"
+
+namespace {
+
+const int TIMEOUT_MS = 5000;
+
+} // namespace
+
+class TestFileTailReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void followAppended();
+    void followRenamedAndCreated();
+
+private:
+    static bool appendLines(const QString &path, const QStringList &lines);
+    static QString line(int second, const QString &message);
+    
+    // Messages of all batches queued so far
+    static QStringList takeMessages(LogBatchQueue &queue);
+};
+
+bool TestFileTailReader::appendLines(const QString &path, const QStringList &lines)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    return file.write((lines.join('\n') + '\n').toUtf8()) > 0;
+}
+
+QString TestFileTailReader::line(int second, const QString &message)
+{
+    return QString("03-04 10:00:%1.000   100   100 I Tail    : %2").arg(second, 2, 10, QChar('0')).arg(message);
+}
+
+QStringList TestFileTailReader::takeMessages(LogBatchQueue &queue)
+{
+    QStringList messages;
+    QVector<LogEntry> batch;
+    while (queue.pop(batch)) {
+        for (const LogEntry &entry : std::as_const(batch)) {
+            messages.append(entry.message);
+        }
+    }
+    return messages;
+}
+
+void TestFileTailReader::followAppended()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("app.log");
+    QVERIFY(appendLines(path, {line(0, "loaded")}));
+    
+    // Following starts after the bytes already loaded
+    LogBatchQueue queue;
+    FileTailReader reader(path, QFileInfo(path).size(), {LogConverterPtr(new ThreadtimeLogConverter())}, &queue);
+    QVERIFY(reader.start());
+    
+    QVERIFY(appendLines(path, {line(1, "appended")}));
+    QStringList messages;
+    QTRY_VERIFY_WITH_TIMEOUT((messages += takeMessages(queue)).size() >= 1, TIMEOUT_MS);
+    QCOMPARE(messages, QStringList({"appended"}));
+}
+
+void TestFileTailReader::followRenamedAndCreated()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("app.log");
+    QVERIFY(appendLines(path, {line(0, "before")}));
+    
+    LogBatchQueue queue;
+    FileTailReader reader(path, 0, {LogConverterPtr(new ThreadtimeLogConverter())}, &queue);
+    QSignalSpy restarted(&reader, &FileTailReader::restarted);
+    QVERIFY(reader.start());
+    QStringList messages = takeMessages(queue);
+    QCOMPARE(messages, QStringList({"before"}));
+    
+    // logrotate's rename then create: the old file still gets its last line, and the
+    // new file exists before the reader looks again
+    QVERIFY(QFile::rename(path, path + ".1"));
+    QVERIFY(appendLines(path + ".1", {line(1, "old tail")}));
+    QVERIFY(appendLines(path, {line(2, "new")}));
+    
+    QTRY_VERIFY_WITH_TIMEOUT(!restarted.isEmpty(), TIMEOUT_MS);
+    QVERIFY(restarted.first().at(0).toString().contains("rotated"));
+    QTRY_VERIFY_WITH_TIMEOUT((messages += takeMessages(queue)).size() >= 3, TIMEOUT_MS);
+    QCOMPARE(messages, QStringList({"before", "old tail", "new"}));
+    
+    // The new file is the one followed from now on
+    QVERIFY(appendLines(path + ".1", {line(3, "ignored")}));
+    QVERIFY(appendLines(path, {line(4, "newer")}));
+    QTRY_VERIFY_WITH_TIMEOUT((messages += takeMessages(queue)).size() >= 4, TIMEOUT_MS);
+    QCOMPARE(messages.last(), QString("newer"));
+    QCOMPARE(messages.size(), 4);
+}
+
+QTEST_GUILESS_MAIN(TestFileTailReader)
+#include "tst_filetailreader.moc"
@@ -0,0 +1,54 @@
+#include <QtTest>
+#include "logentry.h"
+
+class TestLogEntry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void leapDayKeepsOrder();
+    void invalidDate();
+};
+
+void TestLogEntry::leapDayKeepsOrder()
+{
+    // Lines of a 2024 log read in 2026, which has no 02-29
+    const QStringList lines = {
+        "02-28 23:59:59.999",
+        "02-29 00:00:00.000",
+        "02-29 23:59:59.999",
+        "03-01 00:00:00.000",
+    };
+    const QStringList dates = {"2026-02-28", "2026-02-29", "2026-02-29", "2026-03-01"};
+    
+    qint64 previous = LogEntry::NoTimestamp;
+    for (qsizetype i = 0; i < lines.size(); ++i) {
+        const QString line = lines[i];
+        const QByteArray bytes = line.toLatin1();
+        LogEntry entry;
+        entry.timestamp = LogEntry::parseTimestamp(2026, QStringView(line).left(5), QStringView(line).mid(6));
+        QCOMPARE(LogEntry::parseTimestamp(2026, QLatin1StringView(bytes.left(5)), QLatin1StringView(bytes.mid(6))),
+                 entry.timestamp);
+        
+        QVERIFY2(entry.timestamp > previous, qPrintable(line));
+        QCOMPARE(entry.date(), dates[i]);
+        QCOMPARE(entry.time(), line.mid(6));
+        previous = entry.timestamp;
+    }
+}
+
+void TestLogEntry::invalidDate()
+{
+    QCOMPARE(LogEntry::parseTimestamp(2026, u"02-30", u"00:00:00.000"), LogEntry::NoTimestamp);
+    QCOMPARE(LogEntry::parseTimestamp(2026, u"13-01", u"00:00:00.000"), LogEntry::NoTimestamp);
+    QCOMPARE(LogEntry::parseTimestamp(2026, u"04-31", u"00:00:00.000"), LogEntry::NoTimestamp);
+    
+    // Years before 1970 keep their fields too
+    LogEntry entry;
+    entry.timestamp = LogEntry::parseTimestamp(1969, u"12-31", u"23:59:59.999");
+    QCOMPARE(entry.date(), QString("1969-12-31"));
+    QCOMPARE(entry.time(), QString("23:59:59.999"));
+}
+
+QTEST_GUILESS_MAIN(TestLogEntry)
+#include "tst_logentry.moc"